@@ -72,6 +72,27 @@ void hal_stepper_step_clear(hal_axis_t axis) {
     (void)axis;
 }
 
+void hal_stepper_set_pulse_width(uint32_t ticks) {
+    (void)ticks;
+}
+
+void hal_step_timer_init(hal_step_timer_cb_t cb, void *user) {
+    (void)cb;
+    (void)user;
+    /* No-op in mock: the timer never fires */
+}
+
+void hal_step_timer_start(uint32_t period_ticks) {
+    (void)period_ticks;
+}
+
+void hal_step_timer_set_period(uint32_t period_ticks) {
+    (void)period_ticks;
+}
+
+void hal_step_timer_stop(void) {
+}
+
 void hal_stepper_pulse_mask(uint32_t axis_mask) {
     (void)axis_mask;
 }
@@ -0,0 +1,175 @@
+/* linux_sim_run.c - Run a G-code file on the Linux simulation HAL
+ *
+ * Streams a file through protocol -> serial_gcode_bridge -> planner ->
+ * stepper exactly as the firmware main loop does, against virtual time,
+ * and prints the cycle time and step statistics. Optionally writes the
+ * binary step trace described in hal_linux_sim.h.
+ *
+ *   linux_sim_run <file.gcode> [trace.bin]
+ *
+ * Build with -DGRBL_PLATFORM_LINUX_SIM (see README).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/hal_linux_sim.h"
+#include "../src/protocol.h"
+#include "../src/serial_gcode_bridge.h"
+
+#define RUN_CHUNK 256u
+#define RUN_GAP_TICKS (HAL_STEP_TIMER_HZ / 50u)  /* Longer step gaps end a run (20 ms) */
+
+/* Step timing per axis, from the HAL step hook */
+typedef struct {
+    uint64_t last;          /* Time of the previous step */
+    uint64_t interval;      /* Previous step interval (0 = none) */
+    uint64_t min_interval;  /* Shortest interval: peak step rate */
+    uint64_t max_jitter;    /* Largest change between consecutive intervals */
+    uint64_t jitter_sum;
+    uint64_t jitter_count;
+    bool seen;
+} axis_timing_t;
+
+static axis_timing_t g_timing[HAL_AXIS_MAX];
+
+static void on_step(void *user, uint64_t ticks, uint32_t axis_mask) {
+    (void)user;
+    for (uint8_t axis = 0; axis < HAL_AXIS_MAX; axis++) {
+        axis_timing_t *t = &g_timing[axis];
+        if (!(axis_mask & (1u << axis))) {
+            continue;
+        }
+        if (t->seen) {
+            const uint64_t interval = ticks - t->last;
+            if (interval < RUN_GAP_TICKS) {
+                if (t->min_interval == 0u || interval < t->min_interval) {
+                    t->min_interval = interval;
+                }
+                if (t->interval != 0u) {
+                    const uint64_t jitter = interval > t->interval ? interval - t->interval
+                                                                   : t->interval - interval;
+                    if (jitter > t->max_jitter) {
+                        t->max_jitter = jitter;
+                    }
+                    t->jitter_sum += jitter;
+                    t->jitter_count++;
+                }
+                t->interval = interval;
+            } else {
+                t->interval = 0u;
+            }
+        }
+        t->last = ticks;
+        t->seen = true;
+    }
+}
+
+static void on_report(void *ctx, const char *msg) {
+    (void)ctx;
+    printf("%s\n", msg);
+}
+
+static void drain(serial_gcode_bridge_t *bridge) {
+    while (!serial_gcode_bridge_is_idle(bridge)) {
+        if (!serial_gcode_bridge_poll(bridge)) {
+            break;
+        }
+        hal_poll();
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <file.gcode> [trace.bin]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    hal_init();
+    hal_sim_set_serial_out(NULL);
+    hal_sim_set_step_hook(on_step, NULL);
+    if (argc == 3 && !hal_sim_trace_open(argv[2])) {
+        perror(argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    static serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+    serial_gcode_bridge_set_report(&bridge, on_report, NULL);
+
+    protocol_t proto;
+    const proto_config_t cfg = {
+        .strip_semicolon_comments = true,
+        .strip_paren_comments = true,
+        .allow_dollar_commands = true,
+        .to_uppercase = true,
+    };
+    protocol_init(&proto, &cfg, NULL, NULL, NULL);
+
+    uint8_t chunk[RUN_CHUNK];
+    char line[PROTOCOL_LINE_MAX + 1];
+    char response[128];
+    uint32_t lines = 0u;
+    uint32_t errors = 0u;
+    size_t got;
+    do {
+        got = fread(chunk, 1u, sizeof(chunk), in);
+        protocol_feed_bytes(&proto, chunk, got);
+        if (got < sizeof(chunk)) {
+            /* End of file: terminate a last line without a newline */
+            protocol_feed_bytes(&proto, (const uint8_t *)"\n", 1u);
+        }
+
+        proto_line_status_t st;
+        while (protocol_pop_line(&proto, line, sizeof(line), &st)) {
+            if (st == PROTO_LINE_EMPTY) {
+                continue;
+            }
+            lines++;
+            if (st != PROTO_LINE_OK ||
+                serial_gcode_bridge_process_line(&bridge, line, response, sizeof(response)) != GCODE_OK) {
+                errors++;
+                fprintf(stderr, "line %lu: %s: %s\n", (unsigned long)lines, line,
+                        st != PROTO_LINE_OK ? "bad line" : response);
+            }
+        }
+    } while (got == sizeof(chunk));
+    fclose(in);
+
+    drain(&bridge);
+    hal_deinit();
+
+    hal_sim_stats_t stats;
+    hal_sim_get_stats(&stats);
+    const double hz = (double)HAL_STEP_TIMER_HZ;
+    printf("lines %lu errors %lu\n", (unsigned long)lines, (unsigned long)errors);
+    printf("cycle_time_s %.6f motion_time_s %.6f isr_calls %llu\n",
+           (double)hal_sim_now() / hz,
+           (double)(stats.last_step_ticks - stats.first_step_ticks) / hz,
+           (unsigned long long)stats.isr_calls);
+    for (uint8_t axis = 0; axis < HAL_AXIS_MAX; axis++) {
+        const axis_timing_t *t = &g_timing[axis];
+        if (stats.steps[axis] == 0u) {
+            continue;
+        }
+        printf("axis %c steps %llu pos %lld dir_changes %lu peak_rate_hz %.1f "
+               "jitter_max_us %.3f jitter_avg_us %.3f\n",
+               "XYZA"[axis],
+               (unsigned long long)stats.steps[axis],
+               (long long)stats.position[axis],
+               (unsigned long)stats.dir_changes[axis],
+               t->min_interval ? hz / (double)t->min_interval : 0.0,
+               (double)t->max_jitter * 1e6 / hz,
+               t->jitter_count ? (double)t->jitter_sum * 1e6 / hz / (double)t->jitter_count : 0.0);
+    }
+    return errors == 0u ? 0 : 1;
+}
@@ -85,7 +85,14 @@ void hal_stepper_step_pulse(hal_axis_t axis) {
 }
 
 void hal_stepper_step_clear(hal_axis_t axis) { (void)axis; }
-void hal_stepper_pulse_mask(uint32_t axis_mask) { (void)axis_mask; }
+void hal_stepper_set_pulse_width(uint32_t ticks) { (void)ticks; }
+void hal_stepper_pulse_mask(uint32_t axis_mask) {
+    for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
+        if ((axis_mask & (1u << axis)) != 0u) {
+            g_step_pulses[axis]++;
+        }
+    }
+}
 void hal_spindle_set(hal_spindle_dir_t dir, float pwm_0_to_1) {
     (void)dir;
     (void)pwm_0_to_1;
@@ -97,7 +104,31 @@ void hal_read_inputs(hal_inputs_t *out) {
         memset(out, 0, sizeof(*out));
     }
 }
-void hal_poll(void) { g_mock_time_us++; }
+/* Step timer: fire the ISR callback once per poll, advancing simulated time
+ * by one timer period. */
+static hal_step_timer_cb_t g_timer_cb = NULL;
+static void *g_timer_user = NULL;
+static bool g_timer_running = false;
+static uint32_t g_timer_period = 0u;
+
+void hal_step_timer_init(hal_step_timer_cb_t cb, void *user) {
+    g_timer_cb = cb;
+    g_timer_user = user;
+}
+void hal_step_timer_start(uint32_t period_ticks) {
+    g_timer_period = period_ticks;
+    g_timer_running = true;
+}
+void hal_step_timer_set_period(uint32_t period_ticks) { g_timer_period = period_ticks; }
+void hal_step_timer_stop(void) { g_timer_running = false; }
+
+void hal_poll(void) {
+    g_mock_time_us++;
+    if (g_timer_running && g_timer_cb != NULL) {
+        g_mock_time_us += g_timer_period * (1000000u / HAL_STEP_TIMER_HZ);
+        g_timer_cb(g_timer_user);
+    }
+}
 void hal_tick_1khz_isr(void) {}
 
 static void write_line(const char *msg) {
@@ -154,6 +185,15 @@ int main(void) {
             hal_stepper_enable(false);
         }
 
+        /* Motion is queued; run it to completion so the counts below cover it */
+        while (!serial_gcode_bridge_is_idle(&bridge)) {
+            if (!serial_gcode_bridge_poll(&bridge)) {
+                write_line("error: safety input active");
+                break;
+            }
+            hal_poll();
+        }
+
         printf("MCU [stepper]: dir_changes[X=%lu Y=%lu Z=%lu A=%lu]"
                " pulses[X=%lu Y=%lu Z=%lu A=%lu]\n",
                (unsigned long)g_dir_changes[HAL_AXIS_X],
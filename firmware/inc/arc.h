@@ -21,9 +21,10 @@
 extern "C" {
 #endif
 
-/* Maximum arc segment length in mm (smaller = smoother curves) */
-#ifndef ARC_SEGMENT_LEN_MM
-#define ARC_SEGMENT_LEN_MM 0.5f
+/* Default chord tolerance in mm ($12): largest distance allowed between a
+ * segment and the true arc. Segment count follows from it and the radius. */
+#ifndef ARC_TOLERANCE_MM_DEFAULT
+#define ARC_TOLERANCE_MM_DEFAULT 0.002f
 #endif
 
 /* Minimum arc radius to avoid degenerate arcs */
@@ -36,6 +37,14 @@ extern "C" {
  */
 typedef bool (*arc_segment_cb_t)(float x, float y, void *user);
 
+/* Set the chord tolerance used by subsequent arcs (mm, must be > 0).
+ * Returns false and keeps the current value if tolerance is invalid.
+ */
+bool arc_set_tolerance_mm(float tolerance);
+
+/* Current chord tolerance (mm) */
+float arc_get_tolerance_mm(void);
+
 /* Compute arc segments from I/J center-offset form.
  *
  *  start_x, start_y  - current position
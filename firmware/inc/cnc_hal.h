@@ -73,6 +73,11 @@ uint32_t hal_micros(void);
 /* Busy delay. Keep short; core should prefer scheduling. */
 void hal_delay_ms(uint32_t ms);
 
+/* Free-running CPU cycle counter for profiling (profile.h). Wraps; the
+ * difference of two readings is valid across one wrap. Cheap enough to
+ * read from the step ISR. */
+uint32_t hal_cycles(void);
+
 /* ----------------------------- Serial I/O ----------------------------- */
 
 /* Non-blocking read:
@@ -124,6 +129,36 @@ void hal_stepper_step_clear(hal_axis_t axis);
 /* Optional: atomic multi-axis pulse for tighter timing (bitmask). */
 void hal_stepper_pulse_mask(uint32_t axis_mask);
 
+/* Step pulse width in step timer ticks: pins raised by hal_stepper_pulse_mask()
+ * drop again this long after they rose (second timer compare or one-shot).
+ * 0: they stay high until hal_stepper_step_clear(). */
+void hal_stepper_set_pulse_width(uint32_t ticks);
+
+/* ----------------------------- Step timer ----------------------------- */
+
+/* Hardware timer that paces step events.
+ * The stepper core installs a callback that runs in interrupt context once per
+ * timer period; each call emits at most one step event (hal_stepper_pulse_mask).
+ *
+ * Periods are in step timer ticks (HAL_STEP_TIMER_HZ ticks per second).
+ * hal_step_timer_set_period() may be called from inside the callback and
+ * applies to the interval that has just started.
+ */
+#ifndef HAL_STEP_TIMER_HZ
+#define HAL_STEP_TIMER_HZ 1000000u
+#endif
+
+typedef void (*hal_step_timer_cb_t)(void *user);
+
+void hal_step_timer_init(hal_step_timer_cb_t cb, void *user);
+void hal_step_timer_start(uint32_t period_ticks);
+void hal_step_timer_set_period(uint32_t period_ticks);
+void hal_step_timer_stop(void);
+
+/* From inside the callback: step timer ticks between the update that raised
+ * this interrupt and now, i.e. how late the ISR was entered. */
+uint32_t hal_step_timer_latency(void);
+
 /* ----------------------------- Spindle / coolant ----------------------------- */
 
 typedef enum {
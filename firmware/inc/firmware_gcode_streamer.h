@@ -34,12 +34,20 @@ typedef struct {
 /* Initialize streamer. */
 void fw_gcode_streamer_init(fw_gcode_streamer_t *s);
 
-/* Feed incoming UART bytes (call from ISR or DMA callback). */
+/* Feed incoming UART bytes (call from ISR or DMA callback). Realtime
+ * commands (?, !, ~, Ctrl-X) are taken out of the stream here and acted on
+ * at once; everything else goes to the line ring. */
 void fw_gcode_streamer_rx_bytes(fw_gcode_streamer_t *s, const uint8_t *data, size_t len);
 
+/* Realtime filter for receive paths that push into s->uart themselves
+ * (streamer is an fw_gcode_streamer_t). Returns true if byte was a realtime
+ * command and has been handled; it must then not be queued as line data. */
+bool fw_gcode_streamer_rx_realtime(void *streamer, uint8_t byte);
+
 /* Polling function (call frequently from main loop).
+ * - keeps queued motion running in the background
  * - pulls full lines
- * - runs gcode parser/motion
+ * - runs gcode parser/planner (returns once motion is queued)
  * - enqueues "OK"/"error: ..." responses into TX buffer
  */
 void fw_gcode_streamer_poll(fw_gcode_streamer_t *s);
@@ -47,6 +55,9 @@ void fw_gcode_streamer_poll(fw_gcode_streamer_t *s);
 /* Pull bytes that should be transmitted (your UART TX ISR/DMA can use this). */
 bool fw_gcode_streamer_tx_pop(fw_gcode_streamer_t *s, uint8_t *out_byte);
 
+/* Bulk variant: copy up to cap pending TX bytes into out, return the count. */
+size_t fw_gcode_streamer_tx_read(fw_gcode_streamer_t *s, uint8_t *out, size_t cap);
+
 /* Convenience: enqueue a raw string for TX (adds exactly what you pass). */
 size_t fw_gcode_streamer_tx_write(fw_gcode_streamer_t *s, const char *str);
 
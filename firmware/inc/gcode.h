@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "planner.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -68,8 +69,17 @@ typedef enum {
     GCODE_ERR_UNSUPPORTED_CMD,
     GCODE_ERR_INVALID_TARGET,
     GCODE_ERR_OVERFLOW,
+    GCODE_ERR_MOTION_ABORTED,
 } gcode_status_t;
 
+/* Called while the planner queue is full: run background motion and return
+ * true to retry, or false to abort the move. */
+typedef bool (*gcode_planner_wait_t)(void *user);
+
+/* Called when M3/M4/M5, M2/M30 or an S word changes the spindle, before the
+ * line's motion is queued. Return false to abort the line. */
+typedef bool (*gcode_spindle_sync_t)(void *user, gcode_spindle_state_t state, float speed);
+
 /* Modal state machine */
 typedef struct {
     /* Current position (in machine coordinates, mm) */
@@ -92,6 +102,19 @@ typedef struct {
     bool absolute_mode;    /* derived from coord_mode for convenience */
     bool program_complete; /* true after M02/M30 - program has ended */
     
+    /* Motion output (optional): lines and arc segments are queued here */
+    planner_queue_t *planner;
+    gcode_planner_wait_t planner_wait;
+    void *planner_wait_user;
+    
+    /* Spindle output (optional) */
+    gcode_spindle_sync_t spindle_sync;
+    void *spindle_sync_user;
+    
+    /* Word letters the last processed line carried but could not act on
+     * (bit 0 = 'A'). N line numbers are accepted and not counted. */
+    uint32_t ignored_words;
+    
 } gcode_state_t;
 
 /* Parsed G-code block */
@@ -114,6 +137,9 @@ typedef struct {
     int m_code;            /* M-code number (2, 3, 4, 5, 30, etc.) */
     
     bool has_g, has_m;
+
+    /* Other word letters seen on the line (bit 0 = 'A'); not executed */
+    uint32_t unsupported_words;
     
 } gcode_block_t;
 
@@ -122,9 +148,17 @@ typedef struct {
 /* Initialize the G-code parser/executor state */
 void gcode_init(gcode_state_t *gc);
 
-/* Reset to safe startup state */
+/* Reset to safe startup state (keeps the planner and spindle bindings) */
 void gcode_reset(gcode_state_t *gc);
 
+/* Queue motion into a planner (NULL: track position only). The planner
+ * position is synced to the current G-code position. */
+void gcode_set_planner(gcode_state_t *gc, planner_queue_t *planner,
+                       gcode_planner_wait_t wait, void *wait_user);
+
+/* Report spindle changes (NULL: track the modal state only) */
+void gcode_set_spindle_sync(gcode_state_t *gc, gcode_spindle_sync_t sync, void *sync_user);
+
 /* Parse a single G-code line (already normalized by protocol layer) */
 gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block);
 
@@ -140,6 +174,7 @@ float gcode_get_feedrate(const gcode_state_t *gc);
 float gcode_get_spindle_speed(const gcode_state_t *gc);
 gcode_spindle_state_t gcode_get_spindle_state(const gcode_state_t *gc);
 bool gcode_is_program_complete(const gcode_state_t *gc);
+uint32_t gcode_get_ignored_words(const gcode_state_t *gc);
 
 /* Get error message for a status code */
 const char *gcode_status_string(gcode_status_t status);
@@ -109,6 +109,18 @@
   #define GRBL_FEATURE_SD_STREAM 0
 #endif
 
+/* Hot-path cycle profiling zones and the $P report (profile.h). Define it
+ * on the compiler command line: modules include profile.h, not this file. */
+#ifndef GRBL_FEATURE_PROFILE
+  #define GRBL_FEATURE_PROFILE 0
+#endif
+
+/* Step ISR entry latency histogram and the $L / $LR commands
+ * (isr_latency.h). Command line only, as above. */
+#ifndef GRBL_FEATURE_ISR_LATENCY
+  #define GRBL_FEATURE_ISR_LATENCY 0
+#endif
+
 /* ----------------------------- Module selection ----------------------------- */
 /* Choose which kinematics implementation to compile in (one active at runtime). */
 
@@ -120,6 +132,11 @@
   #define GRBL_KINEMATICS_CARTESIAN 0
 #endif
 
+/* GRBL_KINEMATICS binds the per-move conversions to one implementation at
+ * compile time: GRBL_KIN_RUNTIME (default) goes through g_kin,
+ * GRBL_KIN_COREXY inlines the CoreXY math. Defined in kinematics.h; set
+ * it on the command line, like the feature flags. */
+
 /* ----------------------------- Sanity checks ----------------------------- */
 
 #if (GRBL_CART_AXES == 0u) || (GRBL_CART_AXES > 6u)
@@ -159,6 +176,8 @@
 
 #if GRBL_KINEMATICS_COREXY
   #include "kin_corexy.h"
+#elif GRBL_KINEMATICS == GRBL_KIN_COREXY
+  #error "GRBL_KINEMATICS=GRBL_KIN_COREXY needs GRBL_KINEMATICS_COREXY"
 #endif
 
 /* Add more core modules as you create them:
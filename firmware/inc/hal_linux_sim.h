@@ -0,0 +1,134 @@
+/* hal_linux_sim.h - Linux simulation HAL (GRBL_PLATFORM_LINUX_SIM)
+ *
+ * Purpose:
+ *  - Run the unmodified core on a Linux host against a deterministic
+ *    virtual clock
+ *  - Record step and direction output as a timestamped binary trace so
+ *    step rates, jitter, pulse widths and cycle times can be measured
+ *    off-target
+ *
+ * Time model:
+ *  - Virtual time counts step timer ticks (HAL_STEP_TIMER_HZ per second)
+ *    and only moves when the simulation says so: HAL_SIM_POLL_TICKS per
+ *    hal_poll() (the foreground loop), the full wait in hal_delay_ms(), or
+ *    hal_sim_advance()
+ *  - The step timer "ISR" runs at its exact deadlines while time advances,
+ *    in order, however coarse the advance. A period written from the
+ *    callback applies to the interval that has just started, as on TIM2.
+ *  - A latency hook can delay each ISR entry past its deadline, standing
+ *    in for interrupts that hold off the step timer. The timer itself
+ *    keeps its schedule: the next deadline still counts from the missed
+ *    one, and hal_step_timer_latency() reports the delay.
+ *  - Step pins stay high for the width set with hal_stepper_set_pulse_width()
+ *    and drop at that exact time, or on hal_stepper_step_clear() with a
+ *    zero width
+ *  - Nothing reads the wall clock, so a run is repeatable bit for bit.
+ *    The one exception is hal_cycles(), host nanoseconds for profiling.
+ *
+ * Trace format (little-endian):
+ *  - Header: 8-byte magic "GRBLSIM1", u32 step timer Hz
+ *  - Records of 6 bytes: u8 type, u8 data, u32 ticks since the previous
+ *    record (the first record counts from time zero)
+ *      HAL_SIM_REC_STEP     data = axis mask of one hal_stepper_pulse_mask()
+ *      HAL_SIM_REC_STEP_END data = axis mask of step pins going low
+ *      HAL_SIM_REC_DIR      data = axis | 0x80 if positive; changes only
+ *      HAL_SIM_REC_ENABLE   data = 0/1
+ *      HAL_SIM_REC_SPINDLE  data = PWM * 255, 0 when off
+ *      HAL_SIM_REC_GAP      data = 0; a delta too large for u32 is split
+ *                           into GAP records
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cnc_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Virtual time charged to each hal_poll() call (step timer ticks) */
+#ifndef HAL_SIM_POLL_TICKS
+#define HAL_SIM_POLL_TICKS 100u
+#endif
+
+#define HAL_SIM_TRACE_MAGIC   "GRBLSIM1"
+#define HAL_SIM_TRACE_HEADER_SIZE 12u
+#define HAL_SIM_TRACE_RECORD_SIZE 6u
+
+typedef enum {
+    HAL_SIM_REC_STEP = 1,
+    HAL_SIM_REC_DIR = 2,
+    HAL_SIM_REC_ENABLE = 3,
+    HAL_SIM_REC_SPINDLE = 4,
+    HAL_SIM_REC_GAP = 5,
+    HAL_SIM_REC_STEP_END = 6,
+} hal_sim_record_t;
+
+/* Output counters, kept whether or not a trace is open */
+typedef struct {
+    uint64_t steps[HAL_AXIS_MAX];       /* Step pulses per axis */
+    int64_t position[HAL_AXIS_MAX];     /* Steps along the direction pins */
+    uint32_t dir_changes[HAL_AXIS_MAX]; /* Direction pin changes per axis */
+    uint64_t first_step_ticks;          /* Time of the first step pulse */
+    uint64_t last_step_ticks;           /* Time of the last step pulse */
+    uint64_t isr_calls;                 /* Step timer callbacks run */
+    uint64_t isr_late_ticks;            /* Sum of injected ISR entry delays */
+} hal_sim_stats_t;
+
+/* Called for every hal_stepper_pulse_mask() with the virtual time */
+typedef void (*hal_sim_step_hook_t)(void *user, uint64_t ticks, uint32_t axis_mask);
+
+/* Asked once per step timer deadline for how many ticks late to enter the ISR */
+typedef uint32_t (*hal_sim_latency_hook_t)(void *user, uint64_t deadline);
+
+/* Back to time zero: timer stopped, outputs cleared, stats zeroed.
+ * An open trace is kept. */
+void hal_sim_reset(void);
+
+/* Current virtual time (step timer ticks) */
+uint64_t hal_sim_now(void);
+
+/* Move virtual time forward, running every step timer deadline on the way */
+void hal_sim_advance(uint64_t ticks);
+
+/* Virtual time charged per hal_poll() (default HAL_SIM_POLL_TICKS) */
+void hal_sim_set_poll_ticks(uint32_t ticks);
+
+/* True while the step timer is armed */
+bool hal_sim_timer_running(void);
+
+/* Start recording to path (truncates). Returns false if it can't be opened. */
+bool hal_sim_trace_open(const char *path);
+
+/* Record to an already open stream (not closed by hal_sim_trace_close) */
+bool hal_sim_trace_attach(FILE *stream);
+
+/* Flush and stop recording */
+void hal_sim_trace_close(void);
+
+void hal_sim_get_stats(hal_sim_stats_t *out);
+void hal_sim_set_step_hook(hal_sim_step_hook_t hook, void *user);
+
+/* Inject step ISR entry latency (NULL: ISRs run on their deadlines) */
+void hal_sim_set_latency_hook(hal_sim_latency_hook_t hook, void *user);
+
+/* Inputs returned by hal_read_inputs() */
+void hal_sim_set_inputs(const hal_inputs_t *inputs);
+
+/* Bytes returned by hal_serial_read(HAL_PORT_GCODE). Returns bytes taken. */
+size_t hal_sim_serial_feed(const uint8_t *src, size_t len);
+
+/* Where hal_serial_write() goes (default stdout, NULL discards) */
+void hal_sim_set_serial_out(FILE *stream);
+
+/* Last hal_spindle_set() values */
+hal_spindle_dir_t hal_sim_spindle_dir(void);
+float hal_sim_spindle_pwm(void);
+
+#ifdef __cplusplus
+}
+#endif
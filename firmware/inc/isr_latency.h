@@ -0,0 +1,75 @@
+/* isr_latency.h - Step ISR entry latency histogram
+ *
+ * Purpose:
+ *  - Show whether other interrupts (UART, DMA, SysTick) hold off the step
+ *    timer: every step ISR records how late it was entered relative to its
+ *    scheduled timer update, in a log2 bucket histogram
+ *  - Also keeps the worst-case latency and the worst-case ISR duration
+ *  - Reported by the bridge's $L command and cleared by $LR
+ *
+ * Notes:
+ *  - Built in with GRBL_FEATURE_ISR_LATENCY=1, defined for the whole build.
+ *    Otherwise the macros expand to nothing.
+ *  - Latency is in step timer ticks (hal_step_timer_latency()), duration in
+ *    hal_cycles()
+ *  - Written only from the step ISR; a report taken mid-ISR can be one
+ *    sample out of step
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "cnc_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GRBL_FEATURE_ISR_LATENCY
+#define GRBL_FEATURE_ISR_LATENCY 0
+#endif
+
+/* Bucket 0 holds latency 0, bucket b holds [2^(b-1), 2^b) ticks and the last
+ * bucket everything from 2^(ISR_LATENCY_BUCKETS-2) up */
+#define ISR_LATENCY_BUCKETS 16u
+
+typedef struct {
+    uint32_t samples;                           /* ISR entries recorded */
+    uint32_t max_latency_ticks;
+    uint32_t max_duration_cycles;
+    uint32_t buckets[ISR_LATENCY_BUCKETS];
+} isr_latency_stats_t;
+
+typedef struct {
+    uint32_t late_ticks;
+    uint32_t start_cycles;
+} isr_latency_mark_t;
+
+#if GRBL_FEATURE_ISR_LATENCY
+/* First statement of the ISR: declares var holding the entry sample */
+#define ISR_LATENCY_ENTER(var) \
+    const isr_latency_mark_t var = { hal_step_timer_latency(), hal_cycles() }
+/* Last statement of the ISR */
+#define ISR_LATENCY_EXIT(var) \
+    isr_latency_record((var).late_ticks, hal_cycles() - (var).start_cycles)
+#else
+#define ISR_LATENCY_ENTER(var) ((void)0)
+#define ISR_LATENCY_EXIT(var) ((void)0)
+#endif
+
+/* Add one ISR entry */
+void isr_latency_record(uint32_t late_ticks, uint32_t duration_cycles);
+
+/* Clear the histogram and maxima */
+void isr_latency_reset(void);
+
+void isr_latency_get(isr_latency_stats_t *out);
+
+/* Bucket index for a latency, and the smallest latency a bucket holds */
+uint8_t isr_latency_bucket(uint32_t late_ticks);
+uint32_t isr_latency_bucket_floor(uint8_t bucket);
+
+#ifdef __cplusplus
+}
+#endif
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include "kinematics.h"
@@ -47,6 +48,19 @@ typedef struct {
     float home_slow_mm_min;
 } kin_corexy_cfg_t;
 
+/* Active config plus values kin_corexy_set_cfg() derives from it, so the
+ * conversions take no divisions and no per-axis invert branches.
+ * Read-only outside kin_corexy.c. Starts out with the defaults
+ * (80/80/400 steps/mm), so it is valid before kin_corexy_install(). */
+typedef struct {
+    kin_corexy_cfg_t cfg;
+    float cart_sign[KIN_MAX_CART_AXES];          /* -1 where invert_cart, else +1 */
+    float joint_sign[KIN_MAX_JOINT_AXES];        /* -1 where invert_joint, else +1 */
+    float joint_mm_per_step[KIN_MAX_JOINT_AXES]; /* joint_sign / steps_per_mm (0 if unset) */
+} kin_corexy_t;
+
+extern kin_corexy_t g_kin_corexy;
+
 /* Install CoreXY implementation into global g_kin and keep config internally. */
 void kin_corexy_install(const kin_corexy_cfg_t *cfg);
 
@@ -54,6 +68,87 @@ void kin_corexy_install(const kin_corexy_cfg_t *cfg);
 void kin_corexy_set_cfg(const kin_corexy_cfg_t *cfg);
 void kin_corexy_get_cfg(kin_corexy_cfg_t *out);
 
+/* ----------------- CoreXY math (shared by the vtable and inline paths) ----------------- */
+
+/* Motor steps -> machine Cartesian position (joints without steps/mm read as 0) */
+static inline void kin_corexy_steps_to_cart(const kin_corexy_t *k, const kin_steps_t *steps,
+                                            kin_cart_t *out_cart)
+{
+    const float a = (float)steps->v[0] * k->joint_mm_per_step[0];
+    const float b = (float)steps->v[1] * k->joint_mm_per_step[1];
+    const float z = (float)steps->v[2] * k->joint_mm_per_step[2];
+
+    out_cart->v[0] = k->cart_sign[0] * (0.5f * (a + b)); /* X */
+    out_cart->v[1] = k->cart_sign[1] * (0.5f * (a - b)); /* Y */
+    out_cart->v[2] = k->cart_sign[2] * z;                /* Z */
+}
+
+/* Cartesian -> joint mm: A = X + Y, B = X - Y, Z passes through, AUX = 0 */
+static inline bool kin_corexy_cart_to_joint(const kin_corexy_t *k, const kin_cart_t *cart,
+                                            kin_joint_t *out_joint)
+{
+    const float x = k->cart_sign[0] * cart->v[0];
+    const float y = k->cart_sign[1] * cart->v[1];
+
+    out_joint->v[0] = k->joint_sign[0] * (x + y);
+    out_joint->v[1] = k->joint_sign[1] * (x - y);
+    out_joint->v[2] = k->joint_sign[2] * (k->cart_sign[2] * cart->v[2]);
+    out_joint->v[3] = 0.0f; /* AUX unused by default */
+    return true;
+}
+
+/* Joint mm -> Cartesian */
+static inline bool kin_corexy_joint_to_cart(const kin_corexy_t *k, const kin_joint_t *joint,
+                                            kin_cart_t *out_cart)
+{
+    const float a = k->joint_sign[0] * joint->v[0];
+    const float b = k->joint_sign[1] * joint->v[1];
+
+    out_cart->v[0] = k->cart_sign[0] * (0.5f * (a + b));
+    out_cart->v[1] = k->cart_sign[1] * (0.5f * (a - b));
+    out_cart->v[2] = k->cart_sign[2] * (k->joint_sign[2] * joint->v[2]);
+    return true;
+}
+
+/* Cartesian -> absolute joint steps in one pass: transform, scale by the
+ * caller's steps/mm (the planner's $100..) and round to nearest. Gives the
+ * same steps as kin_corexy_cart_to_joint() followed by lroundf(mm * steps/mm). */
+static inline bool kin_corexy_cart_to_steps(const kin_corexy_t *k, const kin_cart_t *cart,
+                                            const float steps_per_mm[KIN_MAX_JOINT_AXES],
+                                            kin_steps_t *out_steps)
+{
+    const float x = k->cart_sign[0] * cart->v[0];
+    const float y = k->cart_sign[1] * cart->v[1];
+    const float z = k->cart_sign[2] * cart->v[2];
+
+    out_steps->v[0] = (int32_t)lroundf(k->joint_sign[0] * (x + y) * steps_per_mm[0]);
+    out_steps->v[1] = (int32_t)lroundf(k->joint_sign[1] * (x - y) * steps_per_mm[1]);
+    out_steps->v[2] = (int32_t)lroundf(k->joint_sign[2] * z * steps_per_mm[2]);
+    out_steps->v[3] = 0;
+    return true;
+}
+
+#if GRBL_KINEMATICS == GRBL_KIN_COREXY
+/* Compile-time selection: the per-move conversions skip g_kin */
+static inline void kinematics_steps_to_cart(const kin_steps_t *steps, kin_cart_t *out_cart) {
+    kin_corexy_steps_to_cart(&g_kin_corexy, steps, out_cart);
+}
+
+static inline bool kinematics_cart_to_joint(const kin_cart_t *cart, kin_joint_t *out_joint) {
+    return kin_corexy_cart_to_joint(&g_kin_corexy, cart, out_joint);
+}
+
+static inline bool kinematics_joint_to_cart(const kin_joint_t *joint, kin_cart_t *out_cart) {
+    return kin_corexy_joint_to_cart(&g_kin_corexy, joint, out_cart);
+}
+
+static inline bool kinematics_cart_to_steps(const kin_cart_t *cart,
+                                            const float steps_per_mm[KIN_MAX_JOINT_AXES],
+                                            kin_steps_t *out_steps) {
+    return kin_corexy_cart_to_steps(&g_kin_corexy, cart, steps_per_mm, out_steps);
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
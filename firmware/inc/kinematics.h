@@ -8,10 +8,14 @@
  * Notes:
  *  - "joint" means motor/joint axes (could match X/Y/Z for Cartesian, or be A/B/C for CoreXY, etc.)
  *  - This header intentionally avoids tying to a specific planner struct; you can adapt types later.
+ *  - The per-move conversions (kinematics_cart_to_steps() and friends) go through g_kin by
+ *    default. Building with GRBL_KINEMATICS=GRBL_KIN_COREXY binds them to the CoreXY math at
+ *    compile time so they inline; g_kin then only serves the other hooks.
  */
 
 #pragma once
 
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -28,6 +32,14 @@ extern "C" {
 #define KIN_MAX_JOINT_AXES 4u  /* motors/joints; e.g., CoreXY uses 2 for XY, plus Z/A */
 #endif
 
+/* Compile-time kinematics selection (define GRBL_KINEMATICS for the whole build) */
+#define GRBL_KIN_RUNTIME 0     /* Conversions through the g_kin vtable */
+#define GRBL_KIN_COREXY  1     /* Conversions inline to kin_corexy.h */
+
+#ifndef GRBL_KINEMATICS
+#define GRBL_KINEMATICS GRBL_KIN_RUNTIME
+#endif
+
 typedef struct { float v[KIN_MAX_CART_AXES]; } kin_cart_t;   /* mm or user units */
 typedef struct { float v[KIN_MAX_JOINT_AXES]; } kin_joint_t; /* joint-space mm-equivalent */
 typedef struct { int32_t v[KIN_MAX_JOINT_AXES]; } kin_steps_t;
@@ -112,6 +124,46 @@ void kinematics_install(const kin_iface_t *impl);
 static inline uint8_t kinematics_cart_axes(void)  { return g_kin.cart_axes; }
 static inline uint8_t kinematics_joint_axes(void) { return g_kin.joint_axes; }
 
+#if GRBL_KINEMATICS == GRBL_KIN_RUNTIME
+/* Per-move conversions; false (or a zero pose) when the hook is missing.
+ * The GRBL_KIN_COREXY versions live in kin_corexy.h. */
+static inline void kinematics_steps_to_cart(const kin_steps_t *steps, kin_cart_t *out_cart) {
+    if (g_kin.steps_to_cart) {
+        g_kin.steps_to_cart(steps, out_cart);
+    } else {
+        for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) out_cart->v[i] = 0.0f;
+    }
+}
+
+static inline bool kinematics_cart_to_joint(const kin_cart_t *cart, kin_joint_t *out_joint) {
+    return g_kin.cart_to_joint != NULL && g_kin.cart_to_joint(cart, out_joint);
+}
+
+static inline bool kinematics_joint_to_cart(const kin_joint_t *joint, kin_cart_t *out_cart) {
+    return g_kin.joint_to_cart != NULL && g_kin.joint_to_cart(joint, out_cart);
+}
+
+/* Cartesian -> absolute joint steps, rounded to nearest */
+static inline bool kinematics_cart_to_steps(const kin_cart_t *cart,
+                                            const float steps_per_mm[KIN_MAX_JOINT_AXES],
+                                            kin_steps_t *out_steps) {
+    kin_joint_t joint;
+    if (!kinematics_cart_to_joint(cart, &joint)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        out_steps->v[i] = (int32_t)lroundf(joint.v[i] * steps_per_mm[i]);
+    }
+    return true;
+}
+#elif GRBL_KINEMATICS != GRBL_KIN_COREXY
+#error "GRBL_KINEMATICS must be GRBL_KIN_RUNTIME or GRBL_KIN_COREXY"
+#endif
+
 #ifdef __cplusplus
 }
+#endif
+
+#if GRBL_KINEMATICS == GRBL_KIN_COREXY
+#include "kin_corexy.h"
 #endif
\ No newline at end of file
@@ -2,6 +2,48 @@
 #define PLANNER_H
 
 #include <stdint.h>
+#include "kinematics.h"
+
+// Block storage: a power-of-two ring owned by the queue
+#ifndef PLANNER_BUFFER_SIZE
+#define PLANNER_BUFFER_SIZE 16u
+#endif
+
+#if (PLANNER_BUFFER_SIZE < 2u) || ((PLANNER_BUFFER_SIZE & (PLANNER_BUFFER_SIZE - 1u)) != 0u)
+#error "PLANNER_BUFFER_SIZE must be a power of two >= 2"
+#endif
+
+#define PLANNER_MIN_JUNCTION_SPEED 0.0f    // Speed through a full reversal (mm/min)
+
+// Planner settings (mirrors grbl $11, $100..$102, $110..$112 and $120..$122)
+typedef struct {
+    float junction_deviation_mm;                  // $11 junction deviation (mm)
+    float accel_mm_per_s2[KIN_MAX_CART_AXES];     // $120..$122 per-axis acceleration (mm/s^2)
+    float max_rate_mm_per_min[KIN_MAX_CART_AXES]; // $110..$112 per-axis max rate (mm/min, 0 = unlimited)
+    float steps_per_mm[KIN_MAX_JOINT_AXES];       // $100..$102 steps per joint mm
+} planner_settings_t;
+
+// Velocity ramps the stepper runs; entry and exit speeds are planned so every
+// ramp fits its block (stepper_set_planner() keeps it in step with the stepper)
+typedef struct {
+    uint8_t scurve;           // Smoothstep ramps: peak acceleration 1.5x the mean
+    float jerk_mm_per_s3;     // S-curve peak jerk limit (0 = none)
+} planner_ramp_t;
+
+// Motion parameters for planner_line_to()
+typedef struct {
+    float feed_rate;          // Requested feed (mm/min), ignored for rapids
+    uint8_t rapid;            // Move at the axis max rates (G0)
+    float spindle_speed;      // Programmed spindle speed (RPM) while the line runs
+    uint8_t spindle_dir;      // HAL_SPINDLE_* direction (0 = off)
+} planner_line_data_t;
+
+// planner_line_to() results
+typedef enum {
+    PLANNER_LINE_OK = 0,      // Block queued, or the move is shorter than a step
+    PLANNER_LINE_FULL,        // Queue full: let the stepper drain and retry
+    PLANNER_LINE_INVALID,     // Kinematics rejected the target or no usable speed
+} planner_line_status_t;
 
 // Planner block structure
 // This structure contains all the information needed for motion planning
@@ -10,6 +52,7 @@ typedef struct {
     float entry_speed;        // Entry speed for this block (mm/min)
     float nominal_speed;      // Maximum speed this block can achieve (mm/min)
     float exit_speed;         // Exit speed for this block (mm/min)
+    float rapid_rate;         // Axis-limited top speed along the block (mm/min, 0 = unlimited); caps overrides
     
     // Acceleration parameters
     float acceleration;       // Maximum acceleration for this block (mm/min^2)
@@ -19,24 +62,40 @@ typedef struct {
     float millimeters;        // Total distance to travel in this block (mm)
     
     // Direction and step counts
-    uint8_t direction_bits;   // Direction bits for each axis
-    uint32_t step_event_count; // Number of step events for this block
+    uint8_t direction_bits;   // Direction bits for each axis (bit set = positive)
+    uint32_t steps[KIN_MAX_JOINT_AXES]; // Steps per joint axis (absolute)
+    uint32_t step_event_count; // Number of step events for this block (max of steps[])
     
     // Status flags
     uint8_t recalculate_flag; // Flag to indicate block needs recalculation
     uint8_t nominal_length_flag; // Flag to indicate block is running at nominal speed
+    uint8_t rapid_flag;       // Rapid (G0) move: the rapid override applies, not the feed override
     
-    // Pointer to next block (for linked list)
-    void *next;               // Pointer to next planner block
+    // Spindle state for the block (used per segment in laser mode)
+    float spindle_speed;      // Programmed spindle speed (RPM)
+    uint8_t spindle_dir;      // HAL_SPINDLE_* direction (0 = off)
     
 } planner_block_t;
 
 // Queue structure for managing planner blocks
+// Blocks live in the ring; head/tail/planned are ring indices.
 typedef struct {
-    planner_block_t *head;    // Pointer to the front of the queue
-    planner_block_t *tail;    // Pointer to the back of the queue
+    planner_block_t blocks[PLANNER_BUFFER_SIZE];
+    uint32_t head;            // Index of the front (oldest) block
+    uint32_t tail;            // Index of the next free slot, one past the back block
+    uint32_t planned;         // First block whose entry speed may still be replanned
     uint32_t size;            // Current number of blocks in the queue
-    uint32_t capacity;        // Maximum number of blocks allowed in the queue
+    uint32_t capacity;        // Maximum number of blocks allowed in the queue (<= PLANNER_BUFFER_SIZE)
+    
+    // Look-ahead state
+    planner_settings_t settings;                    // Junction/acceleration limits
+    planner_ramp_t ramp;                            // Ramp shape speeds are planned for
+    float prev_unit_vec[KIN_MAX_CART_AXES];         // Direction of the last planned block
+    float prev_nominal_speed;                       // Nominal speed of the last planned block (mm/min)
+    
+    // Position at the end of the queue (planner_line_to)
+    kin_steps_t position_steps;                     // Joint step counts
+    kin_cart_t position;                            // Cartesian target of the last line (mm)
 } planner_queue_t;
 
 // Function declarations - Block operations
@@ -45,11 +104,32 @@ int planner_block_validate(const planner_block_t *block);
 
 // Function declarations - Queue operations
 void planner_queue_init(planner_queue_t *queue, uint32_t capacity);
-int planner_enqueue(planner_queue_t *queue, planner_block_t *block);
+planner_block_t* planner_alloc_block(planner_queue_t *queue);
+int planner_enqueue(planner_queue_t *queue, const planner_block_t *block);
 planner_block_t* planner_dequeue(planner_queue_t *queue);
+void planner_discard_front(planner_queue_t *queue);
 planner_block_t* planner_peek_front(const planner_queue_t *queue);
 planner_block_t* planner_peek_back(const planner_queue_t *queue);
 int planner_is_empty(const planner_queue_t *queue);
 void planner_queue_clear(planner_queue_t *queue);
 
+// Function declarations - Look-ahead
+void planner_set_settings(planner_queue_t *queue, const planner_settings_t *settings);
+void planner_set_ramp(planner_queue_t *queue, const planner_ramp_t *ramp);
+
+// Ramp model shared with the stepper: duration (s) of a speed change dv (mm/s)
+// at peak acceleration accel (mm/s^2), and the distance (mm) from va to vb
+float planner_ramp_time(const planner_ramp_t *ramp, float accel, float dv);
+float planner_ramp_mm(const planner_ramp_t *ramp, float accel, float va, float vb);
+int planner_plan_block(planner_queue_t *queue, const planner_block_t *block,
+                       const float delta_mm[KIN_MAX_CART_AXES]);
+void planner_recalculate(planner_queue_t *queue);
+
+// Function declarations - Cartesian motion
+planner_line_status_t planner_line_to(planner_queue_t *queue, const kin_cart_t *target,
+                                      const planner_line_data_t *data);
+void planner_set_position(planner_queue_t *queue, const kin_cart_t *position);
+void planner_sync_position(planner_queue_t *queue, const kin_steps_t *steps);
+void planner_get_position(const planner_queue_t *queue, kin_cart_t *out_position);
+
 #endif // PLANNER_H
@@ -0,0 +1,73 @@
+/* profile.h - Hot-path cycle profiling zones
+ *
+ * Purpose:
+ *  - Show where MCU time goes: each zone keeps a call count and the
+ *    min / max / total hal_cycles() spent in it, in a static table
+ *  - The table is reported by the bridge's $P command
+ *
+ * Notes:
+ *  - Built in with GRBL_FEATURE_PROFILE=1, defined for the whole build so
+ *    every module agrees. Otherwise the zone macros expand to nothing and
+ *    no module references the table or hal_cycles().
+ *  - Zones are inclusive: interrupts taken inside a zone count towards it
+ *  - Each zone is written from one context only (the step ISR zone from
+ *    the ISR, the rest from the main loop), so updates take no lock; a
+ *    report can see a step ISR entry half updated
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "cnc_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GRBL_FEATURE_PROFILE
+#define GRBL_FEATURE_PROFILE 0
+#endif
+
+typedef enum {
+    PROFILE_ZONE_RX_FEED = 0,   /* Received bytes into the line buffers (per chunk) */
+    PROFILE_ZONE_FRAMING,       /* Line framing out of the RX ring (per line) */
+    PROFILE_ZONE_PARSE,         /* gcode_parse_line() */
+    PROFILE_ZONE_PLAN,          /* planner_line_to(): enqueue + replan (queue full not counted) */
+    PROFILE_ZONE_SEGMENT_PREP,  /* Slicing blocks into step segments (calls that queue one) */
+    PROFILE_ZONE_STEP_ISR,      /* Step timer interrupt */
+    PROFILE_ZONE_COUNT
+} profile_zone_t;
+
+typedef struct {
+    uint32_t count;         /* Timed calls */
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;  /* Average = total_cycles / count */
+} profile_stats_t;
+
+#if GRBL_FEATURE_PROFILE
+/* Open a zone: declares var holding the start timestamp */
+#define PROFILE_BEGIN(var) const uint32_t var = hal_cycles()
+/* Close a zone opened with PROFILE_BEGIN(var) */
+#define PROFILE_END(zone, var) profile_record((zone), hal_cycles() - (var))
+#else
+#define PROFILE_BEGIN(var) ((void)0)
+#define PROFILE_END(zone, var) ((void)0)
+#endif
+
+/* Add one timed call of the given length to a zone */
+void profile_record(profile_zone_t zone, uint32_t cycles);
+
+/* Clear every zone */
+void profile_reset(void);
+
+/* Copy out a zone's statistics (all zero until its first call) */
+void profile_get(profile_zone_t zone, profile_stats_t *out);
+
+/* Short zone name used in reports ("parse", "step_isr", ...) */
+const char *profile_zone_name(profile_zone_t zone);
+
+#ifdef __cplusplus
+}
+#endif
@@ -34,7 +34,37 @@ typedef enum {
     PROTO_RT_CYCLE_START,      /* '~' */
     PROTO_RT_RESET,            /* Ctrl-X (0x18) */
     PROTO_RT_ESTOP,            /* Optional: user-defined emergency stop */
+    /* Overrides (Grbl 1.1 extended ASCII codes) */
+    PROTO_RT_FEED_OVR_RESET,         /* 0x90: feed 100% */
+    PROTO_RT_FEED_OVR_COARSE_PLUS,   /* 0x91: feed +10% */
+    PROTO_RT_FEED_OVR_COARSE_MINUS,  /* 0x92: feed -10% */
+    PROTO_RT_FEED_OVR_FINE_PLUS,     /* 0x93: feed +1% */
+    PROTO_RT_FEED_OVR_FINE_MINUS,    /* 0x94: feed -1% */
+    PROTO_RT_RAPID_OVR_RESET,        /* 0x95: rapids 100% */
+    PROTO_RT_RAPID_OVR_MEDIUM,       /* 0x96: rapids 50% */
+    PROTO_RT_RAPID_OVR_LOW,          /* 0x97: rapids 25% */
+    PROTO_RT_SPINDLE_OVR_RESET,      /* 0x99: spindle 100% */
+    PROTO_RT_SPINDLE_OVR_COARSE_PLUS,  /* 0x9A: spindle +10% */
+    PROTO_RT_SPINDLE_OVR_COARSE_MINUS, /* 0x9B: spindle -10% */
+    PROTO_RT_SPINDLE_OVR_FINE_PLUS,    /* 0x9C: spindle +1% */
+    PROTO_RT_SPINDLE_OVR_FINE_MINUS,   /* 0x9D: spindle -1% */
 } proto_rt_cmd_t;
+
+/* Override limits (percent of the programmed value) */
+#define PROTO_OVR_DEFAULT     100u
+#define PROTO_OVR_FEED_MIN    10u
+#define PROTO_OVR_FEED_MAX    200u
+#define PROTO_OVR_SPINDLE_MIN 10u
+#define PROTO_OVR_SPINDLE_MAX 200u
+#define PROTO_OVR_RAPID_MEDIUM 50u
+#define PROTO_OVR_RAPID_LOW    25u
+
+/* Current overrides, in percent. */
+typedef struct {
+    uint8_t feed;
+    uint8_t rapid;
+    uint8_t spindle;
+} proto_overrides_t;
 
 /* Line-level errors (not motion errors). */
 typedef enum {
@@ -101,6 +131,21 @@ bool protocol_pop_line(protocol_t *p, char *out, size_t out_cap, proto_line_stat
 /* Utility: returns true if there are pending completed lines buffered. */
 bool protocol_has_line(const protocol_t *p);
 
+/* Classify one received byte: PROTO_RT_NONE for line data, otherwise the
+ * realtime command it carries. Pure and ISR-safe, so receive paths can pull
+ * realtime bytes out of the stream before they reach any line buffer. */
+proto_rt_cmd_t protocol_rt_classify(uint8_t c);
+
+/* True for the PROTO_RT_*_OVR_* commands. */
+bool protocol_rt_is_override(proto_rt_cmd_t cmd);
+
+/* Set all overrides to 100%. */
+void protocol_overrides_init(proto_overrides_t *ovr);
+
+/* Step ovr by one override command, clamped to the limits above.
+ * Returns true if any value changed. */
+bool protocol_apply_override(proto_overrides_t *ovr, proto_rt_cmd_t cmd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,7 +6,9 @@
 #include <stdint.h>
 
 #include "gcode.h"
+#include "planner.h"
 #include "protocol.h"
+#include "stepper.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +36,7 @@ typedef struct {
     float homing_pull_off_mm;              /* $27 */
     uint32_t spindle_max_rpm;              /* $30 */
     uint32_t spindle_min_rpm;              /* $31 */
+    bool laser_mode;                       /* $32 */
     float max_rate_mm_per_min[3];          /* $110..$112 */
     float accel_mm_per_s2[3];              /* $120..$122 */
     float max_travel_mm[3];                /* $130..$132 */
@@ -57,6 +60,19 @@ typedef struct {
                            const float *steps_per_mm,
                            uint32_t step_pulse_delay_us);
     void *motion_backend_ctx;
+    /* Motion pipeline: lines are planned into the queue and executed by
+     * the stepper in the background. The bridge must not be copied after
+     * serial_gcode_bridge_init() (the stepper and timer hold pointers). */
+    planner_queue_t planner;
+    stepper_context_t stepper;
+    /* Realtime commands posted by serial_gcode_bridge_realtime() and
+     * serviced by the next serial_gcode_bridge_poll() */
+    volatile uint8_t rt_pending;
+    volatile uint16_t ovr_pending; /* Bit n: override command PROTO_RT_FEED_OVR_RESET + n */
+    proto_overrides_t overrides;   /* Feed/rapid go to the stepper; spindle is reported only */
+    bool line_aborted; /* A reset dropped the line being processed */
+    void (*report)(void *ctx, const char *msg);
+    void *report_ctx;
 } serial_gcode_bridge_t;
 
 void serial_gcode_bridge_init(serial_gcode_bridge_t *bridge);
@@ -70,11 +86,33 @@ void serial_gcode_bridge_set_motion_backend(serial_gcode_bridge_t *bridge,
                                                             uint32_t step_pulse_delay_us),
                                             void *backend_ctx);
 
+/* Where asynchronous messages (status reports, reset banner) go */
+void serial_gcode_bridge_set_report(serial_gcode_bridge_t *bridge,
+                                    void (*report)(void *ctx, const char *msg),
+                                    void *report_ctx);
+
+/* Handle a realtime command at receive time (ISR-safe). A reset parks the
+ * step ISR before this returns; feed hold and cycle start begin their ramp,
+ * overrides take effect, and the rest of the work and the status report
+ * happen, in the next poll - including polls made while a line waits for
+ * planner room. Repeats of one override between two polls count once. */
+void serial_gcode_bridge_realtime(serial_gcode_bridge_t *bridge, proto_rt_cmd_t cmd);
+
+/* Parse and plan one line. Motion returns as soon as it is queued; the call
+ * only waits while the planner queue is full or the command must run after
+ * queued motion ($H, M18, custom motion backend). */
 gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
                                                 const char *line,
                                                 char *response,
                                                 size_t response_len);
 
+/* Background motion work - call frequently from the main loop.
+ * Returns false if queued motion was aborted by a safety input. */
+bool serial_gcode_bridge_poll(serial_gcode_bridge_t *bridge);
+
+/* True when no motion is queued or executing */
+bool serial_gcode_bridge_is_idle(const serial_gcode_bridge_t *bridge);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,22 +20,37 @@ extern "C" {
 #define UART_LINE_MAX 120u
 #endif
 
+/* Ring indices are free-running uint16_t counters masked on access */
+#if (UART_RX_BUFFER_SIZE < 2u) || (UART_RX_BUFFER_SIZE > 32768u) || \
+    ((UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1u)) != 0u)
+#error "UART_RX_BUFFER_SIZE must be a power of two in 2..32768"
+#endif
+
+#if (UART_TX_BUFFER_SIZE < 2u) || (UART_TX_BUFFER_SIZE > 32768u) || \
+    ((UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1u)) != 0u)
+#error "UART_TX_BUFFER_SIZE must be a power of two in 2..32768"
+#endif
+
 typedef enum {
     UART_LINE_NONE = 0,
     UART_LINE_READY,
     UART_LINE_OVERFLOW,
 } uart_line_status_t;
 
+/* RX and TX are single-producer/single-consumer rings. Each index is
+ * written by one side only: the producer advances *_tail after copying
+ * data in, the consumer advances *_head after copying data out, and the
+ * fill level is tail - head. The RX producer (UART ISR/DMA callback) and
+ * consumer (main loop) can therefore run concurrently without masking
+ * interrupts; the same holds for TX in the other direction. */
 typedef struct {
     uint8_t rx_buf[UART_RX_BUFFER_SIZE];
-    uint16_t rx_head;
-    uint16_t rx_tail;
-    uint16_t rx_count;
+    volatile uint16_t rx_head;  /* Consumer: main loop */
+    volatile uint16_t rx_tail;  /* Producer: UART ISR / DMA callback */
 
     uint8_t tx_buf[UART_TX_BUFFER_SIZE];
-    uint16_t tx_head;
-    uint16_t tx_tail;
-    uint16_t tx_count;
+    volatile uint16_t tx_head;  /* Consumer: UART TX path */
+    volatile uint16_t tx_tail;  /* Producer: main loop */
 
     char line_buf[UART_LINE_MAX + 1];
     uint16_t line_len;
@@ -43,14 +58,25 @@ typedef struct {
 } serial_uart_t;
 
 void serial_uart_init(serial_uart_t *uart);
+
+/* RX producer side */
 bool serial_uart_rx_push_byte(serial_uart_t *uart, uint8_t byte);
 size_t serial_uart_rx_push(serial_uart_t *uart, const uint8_t *data, size_t len);
+
+/* RX consumer side */
 bool serial_uart_rx_pop_byte(serial_uart_t *uart, uint8_t *out_byte);
+size_t serial_uart_rx_pop(serial_uart_t *uart, uint8_t *out, size_t cap);
+size_t serial_uart_rx_count(const serial_uart_t *uart);
 
 uart_line_status_t serial_uart_read_line(serial_uart_t *uart, char *out_line, size_t out_cap);
 
+/* TX producer side */
 size_t serial_uart_tx_enqueue(serial_uart_t *uart, const uint8_t *data, size_t len);
+
+/* TX consumer side */
 bool serial_uart_tx_pop_byte(serial_uart_t *uart, uint8_t *out_byte);
+size_t serial_uart_tx_pop(serial_uart_t *uart, uint8_t *out, size_t cap);
+size_t serial_uart_tx_count(const serial_uart_t *uart);
 
 #ifdef __cplusplus
 }
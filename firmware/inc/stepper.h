@@ -11,6 +11,17 @@
  *  - Uses kinematics to convert positions to joint/step space
  *  - Uses HAL functions to control physical stepper motors
  *  - Manages step timing and direction control
+ *
+ * Execution model:
+ *  - stepper_update() runs in the foreground and slices blocks into short
+ *    fixed-time segments following a trapezoid or S-curve velocity profile;
+ *    each segment carries a step count and a timer period
+ *  - stepper_isr() runs from the HAL step timer, pops segments and emits one
+ *    step event per timer period via hal_stepper_pulse_mask(); it only does
+ *    integer math on data copied out of the planner
+ *  - The foreground never waits on step timing
+ *  - In laser mode each segment also carries a spindle PWM proportional to
+ *    its speed, which the ISR applies as the segment starts
  */
 
 #pragma once
@@ -31,10 +42,90 @@ extern "C" {
 typedef enum {
     STEPPER_IDLE = 0,       /* No motion in progress */
     STEPPER_RUNNING,        /* Executing a motion block */
+    STEPPER_HOLDING,        /* Decelerating into a feed hold */
     STEPPER_HOLD,           /* Motion paused (feed hold) */
     STEPPER_STOPPING,       /* Decelerating to stop */
 } stepper_state_t;
 
+/* Realtime requests, posted from any context with stepper_rt_request() */
+#define STEPPER_RT_HOLD    (1u << 0)  /* Decelerate into a hold */
+#define STEPPER_RT_RESUME  (1u << 1)  /* Leave a hold */
+#define STEPPER_RT_STOP    (1u << 2)  /* Park now, then drop all queued motion */
+
+/* Step segment buffer */
+#define STEPPER_SEGMENT_BUFFER_SIZE 8u      /* Segments queued ahead of the ISR */
+#define STEPPER_BLOCK_BUFFER_SIZE   STEPPER_SEGMENT_BUFFER_SIZE /* Blocks referenced by queued segments */
+#define STEPPER_SEGMENT_TIME_US     10000u  /* Nominal duration of one segment */
+#define STEPPER_MIN_PERIOD_TICKS    10u     /* Floor on the step timer period */
+#define STEPPER_MIN_STEP_LOW_US     2u      /* Floor on step low time before the next rising edge */
+
+/* Adaptive Multi-Axis Step Smoothing (AMASS)
+ * Below each threshold step rate the ISR runs 2x faster again and the DDA
+ * is oversampled to match, so minor-axis pulses are spaced evenly in time.
+ * Thresholds are step periods in step timer ticks.
+ */
+#define STEPPER_AMASS_MAX_LEVEL  3u
+#define STEPPER_AMASS_LEVEL1     (HAL_STEP_TIMER_HZ / 8000u)  /* Below 8 kHz */
+#define STEPPER_AMASS_LEVEL2     (HAL_STEP_TIMER_HZ / 4000u)  /* Below 4 kHz */
+#define STEPPER_AMASS_LEVEL3     (HAL_STEP_TIMER_HZ / 2000u)  /* Below 2 kHz */
+
+/* Velocity profile used to slice blocks into segments */
+typedef enum {
+    STEPPER_PROFILE_TRAPEZOID = 0,  /* Constant acceleration ramps */
+    STEPPER_PROFILE_SCURVE,         /* Smoothstep ramps: zero acceleration at the
+                                       ends, 1.5x longer so the peak stays at the
+                                       limit, longer still under a jerk limit */
+} stepper_profile_t;
+
+/* Block data needed by the ISR, copied out of the planner block so the ISR
+ * never reads planner memory. Counts are scaled by 2^STEPPER_AMASS_MAX_LEVEL.
+ */
+typedef struct {
+    uint32_t steps[HAL_AXIS_MAX];   /* Steps per axis */
+    uint32_t step_event_count;      /* Step events (max of steps[]) */
+    uint8_t direction_bits;         /* Bit set = positive direction */
+    uint8_t spindle_dir;            /* Laser mode: HAL_SPINDLE_* while the block runs */
+} stepper_block_t;
+
+/* A run of ISR ticks at a fixed step timer period.
+ * Prepared by stepper_update(), consumed by stepper_isr().
+ */
+typedef struct {
+    uint16_t n_step;        /* ISR ticks in this segment (step events << amass_level) */
+    uint32_t period_ticks;  /* Step timer period (HAL_STEP_TIMER_HZ ticks) */
+    uint8_t amass_level;    /* DDA oversampling level (0..STEPPER_AMASS_MAX_LEVEL) */
+    uint8_t block_index;    /* Entry in the stepper block buffer */
+    float spindle_pwm;      /* Laser mode: spindle PWM (0..1), < 0 leaves the spindle alone */
+} stepper_segment_t;
+
+/* Segment preparation state for the block being sliced (foreground only).
+ * Speeds in mm/s, distances in mm, times in s. The profile starts at
+ * mm_base into the block; it is recomputed when the planner changes the
+ * block's exit speed and on hold, stop and resume. While decelerating the
+ * profile is a stop ramp that may end part way into the block.
+ */
+typedef struct {
+    uint32_t events_total;   /* Step events in the block */
+    uint32_t events_done;    /* Step events already queued in segments */
+    float events_per_mm;     /* Step events per mm along the block */
+    float mm_total;          /* Block length */
+    float mm_base;           /* Distance covered before the current profile */
+    float time;              /* Time into the current profile */
+    float v_entry;           /* Profile entry speed */
+    float v_peak;            /* Cruise (or peak) speed */
+    float v_exit;            /* Profile exit speed */
+    float accel;             /* Acceleration (0 = constant speed) */
+    float t_accel;           /* Ramp up duration */
+    float t_cruise;          /* Cruise duration */
+    float t_decel;           /* Ramp down duration */
+    float mm_accel;          /* Ramp up distance */
+    float mm_cruise;         /* Cruise distance */
+    uint32_t events_end;     /* Step events done when the profile ends */
+    float exit_speed_used;   /* Planner exit speed the profile was built for (mm/min) */
+    float carry_speed;       /* Exit speed of the previous block (mm/s) */
+    bool carry_valid;        /* Motion continues from the previous block */
+} stepper_prep_t;
+
 /* Stepper configuration */
 typedef struct {
     /* Timing parameters */
@@ -48,6 +139,16 @@ typedef struct {
     bool motors_enabled;          /* Motors are enabled */
     bool idle_disable;            /* Disable motors when idle */
     uint32_t idle_timeout_ms;     /* Time before disabling motors when idle */
+    
+    /* Step smoothing */
+    bool amass_enabled;           /* Oversample the DDA at low step rates (AMASS) */
+    stepper_profile_t profile;    /* Acceleration profile shape */
+    float jerk_mm_per_s3;         /* S-curve peak jerk limit (0 = none) */
+    
+    /* Spindle */
+    bool laser_mode;              /* Spindle PWM follows speed, set per segment ($32) */
+    float spindle_max_rpm;        /* Speed for full PWM ($30) */
+    float spindle_min_rpm;        /* Lowest speed that turns the spindle on ($31) */
 } stepper_config_t;
 
 /* Current stepper execution context */
@@ -55,26 +156,58 @@ typedef struct {
     /* Current state */
     stepper_state_t state;
     
+    /* Pending STEPPER_RT_* bits (set by any context, taken by stepper_update) */
+    volatile uint8_t rt_request;
+    
     /* Configuration */
     stepper_config_t config;
     
-    /* Current block being executed */
+    /* Block source: planner queue (optional) or stepper_load_block() */
+    planner_queue_t *planner;
+    
+    /* Current block being sliced into segments (NULL once fully prepared) */
     planner_block_t *current_block;
+    bool current_from_planner;    /* current_block is the planner's front block */
     
-    /* Step counters for current block */
-    uint32_t step_count[HAL_AXIS_MAX];  /* Steps taken per axis */
-    uint32_t target_steps[HAL_AXIS_MAX]; /* Target steps per axis */
+    /* Segment preparation */
+    stepper_prep_t prep;
+    stepper_block_t block_buffer[STEPPER_BLOCK_BUFFER_SIZE];
+    uint8_t prep_block_index;     /* Block buffer entry being prepared */
     
-    /* Current position in steps */
-    kin_steps_t position;
+    /* Segment buffer (head written by foreground, tail by ISR) */
+    stepper_segment_t segment_buffer[STEPPER_SEGMENT_BUFFER_SIZE];
+    volatile uint8_t segment_head;
+    volatile uint8_t segment_tail;
+    
+    /* ISR execution state */
+    const stepper_block_t *exec_block; /* Block of the active segment */
+    uint32_t exec_steps_left;     /* ISR ticks left in the active segment */
+    uint32_t exec_period_ticks;   /* Timer period of the active segment */
+    uint32_t dda_steps[HAL_AXIS_MAX];   /* Block steps >> active AMASS level */
+    uint32_t dda_counter[HAL_AXIS_MAX]; /* Per-axis error accumulators */
+    int8_t dir_sign[HAL_AXIS_MAX];      /* Position increment per step (+1/-1) */
+    uint8_t dir_bits;             /* Direction currently on the pins */
+    bool dir_valid;               /* dir_bits reflects the pins */
+    uint32_t dir_setup_ticks;     /* dir_setup_us in step timer ticks */
+    bool pulse_active;            /* Step pins were raised on the last tick */
+    volatile bool timer_running;  /* Step timer is armed */
+    float spindle_pwm;            /* Laser mode: PWM currently on the spindle output */
+    uint8_t spindle_dir;          /* Laser mode: direction currently on the spindle output */
     
-    /* Timing */
-    uint32_t last_step_time_us;   /* Time of last step pulse */
-    uint32_t step_interval_us;    /* Current interval between steps */
+    /* Current position in steps (written by the ISR) */
+    kin_steps_t position;
     
     /* Speed tracking */
     float current_speed;          /* Current speed in mm/min */
     
+    /* Overrides in percent of the planned nominal speed, applied while
+     * slicing (rapid_flag blocks use rapid_override) */
+    uint8_t feed_override;
+    uint8_t rapid_override;
+    /* Spindle override in percent of the programmed S, applied to the
+     * laser power of each new segment */
+    uint8_t spindle_override;
+    
     /* Idle tracking */
     uint32_t idle_start_time_ms;  /* Time when idle state started */
 } stepper_context_t;
@@ -87,12 +220,19 @@ void stepper_init(stepper_context_t *ctx, const stepper_config_t *config);
 /* Reset stepper to safe state */
 void stepper_reset(stepper_context_t *ctx);
 
-/* Start executing a new block from the planner */
+/* Start executing a single block (owned by the caller until the stepper is idle) */
 bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block);
 
-/* Update stepper state - call frequently from main loop or timer ISR */
+/* Feed blocks from a planner queue; blocks are discarded once fully prepared.
+ * The planner then plans its speeds for this stepper's ramp profile. */
+void stepper_set_planner(stepper_context_t *ctx, planner_queue_t *planner);
+
+/* Refill the segment buffer and arm the step timer - call frequently from main loop */
 void stepper_update(stepper_context_t *ctx);
 
+/* Step timer interrupt body - emits at most one step event per call */
+void stepper_isr(stepper_context_t *ctx);
+
 /* ----------------------------- Motion control ----------------------------- */
 
 /* Enable/disable stepper motors */
@@ -101,15 +241,30 @@ void stepper_enable_motors(stepper_context_t *ctx, bool enable);
 /* Check if motors are enabled */
 bool stepper_motors_enabled(const stepper_context_t *ctx);
 
-/* Pause motion (feed hold) */
+/* Feed hold: decelerate along the path and pause (HOLDING, then HOLD once
+ * stepper_update() sees the last step out). No steps are dropped. */
 void stepper_hold(stepper_context_t *ctx);
 
-/* Resume motion from hold */
+/* Resume motion from a hold, accelerating from the current speed */
 void stepper_resume(stepper_context_t *ctx);
 
-/* Stop motion immediately */
+/* Decelerate to rest like a hold, then drop all queued motion */
 void stepper_stop(stepper_context_t *ctx);
 
+/* Change the feed, rapid and spindle overrides (percent). The block being
+ * sliced is replanned from its current speed, so the change shows up within
+ * a few segments; queued planner blocks pick it up as they are sliced. */
+void stepper_set_overrides(stepper_context_t *ctx, uint8_t feed_percent, uint8_t rapid_percent,
+                           uint8_t spindle_percent);
+
+/* Spindle PWM (0..1) for a speed in RPM, scaled to the $30/$31 range */
+float stepper_spindle_pwm(const stepper_context_t *ctx, float rpm);
+
+/* Post STEPPER_RT_* bits. Safe from interrupts: the step ISR parks on a
+ * pending stop at its next tick, and the next stepper_update() applies the
+ * request. HOLD and RESUME cancel each other. */
+void stepper_rt_request(stepper_context_t *ctx, uint8_t bits);
+
 /* check stepper state for status */
 void stepper_status(stepper_context_t *ctx);
 
@@ -132,7 +287,7 @@ void stepper_get_cart_position(const stepper_context_t *ctx, kin_cart_t *out_car
 
 /* ----------------------------- Configuration ----------------------------- */
 
-/* Update stepper configuration */
+/* Update stepper configuration (and the planner's ramp profile) */
 void stepper_set_config(stepper_context_t *ctx, const stepper_config_t *config);
 
 /* Get current configuration */
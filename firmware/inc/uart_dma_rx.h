@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "serial_uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Circular DMA receive buffer. Half of it is one HT/TC event, so it also
+ * bounds how long a burst can outrun the idle-line interrupt. */
+#ifndef UART_DMA_RX_SIZE
+#define UART_DMA_RX_SIZE 128u
+#endif
+
+/* The DMA channel writes buf in circular mode; the reader (the UART
+ * receive-event callback) hands each newly written span to serial_uart as
+ * at most two chunks: up to the end of buf, then from the start. */
+typedef struct {
+    uint8_t buf[UART_DMA_RX_SIZE];
+    uint16_t read_pos;         /* Next byte not yet handed to serial_uart */
+    uint32_t dropped;          /* Bytes lost because the RX ring was full */
+    /* Optional: sees every byte first; bytes it returns true for are
+     * handled out of band and never reach serial_uart */
+    bool (*realtime)(void *ctx, uint8_t byte);
+    void *realtime_ctx;
+} uart_dma_rx_t;
+
+void uart_dma_rx_init(uart_dma_rx_t *rx);
+
+/* Install the realtime filter (after uart_dma_rx_init, which clears it) */
+void uart_dma_rx_set_realtime(uart_dma_rx_t *rx, bool (*realtime)(void *ctx, uint8_t byte), void *ctx);
+
+/* Forward everything the DMA wrote since the last call. write_pos is the
+ * DMA write index (UART_DMA_RX_SIZE minus the channel's remaining count;
+ * UART_DMA_RX_SIZE itself is taken as 0). CR is stored as LF, as the
+ * byte-interrupt path did, so CR-only terminals still end lines.
+ * Returns the number of bytes accepted by uart. */
+size_t uart_dma_rx_service(uart_dma_rx_t *rx, uint16_t write_pos, serial_uart_t *uart);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,17 @@ uint32_t hal_micros(void)
     return (uint32_t)(HAL_GetTick() * 1000u);
 }
 
+/* DWT cycle counter at SystemCoreClock, switched on at the first read */
+uint32_t hal_cycles(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0u) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0u;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+}
+
 void hal_poll(void)
 {
 }
@@ -21,9 +32,18 @@ void hal_stepper_set_dir(hal_axis_t axis, bool dir_positive)
     (void)dir_positive;
 }
 
+/* Pulse end: TIM2 compare channel 1, armed pulse width ticks after the
+ * pins rise. The step period floor keeps it inside the current interval. */
+static uint32_t s_pulse_width;
+
 void hal_stepper_pulse_mask(uint32_t axis_mask)
 {
     (void)axis_mask;
+    if (s_pulse_width > 0u) {
+        TIM2->CCR1 = TIM2->CNT + s_pulse_width;
+        TIM2->SR = ~TIM_SR_CC1IF;
+        TIM2->DIER |= TIM_DIER_CC1IE;
+    }
 }
 
 void hal_stepper_step_clear(hal_axis_t axis)
@@ -31,6 +51,11 @@ void hal_stepper_step_clear(hal_axis_t axis)
     (void)axis;
 }
 
+void hal_stepper_set_pulse_width(uint32_t ticks)
+{
+    s_pulse_width = ticks;
+}
+
 void hal_read_inputs(hal_inputs_t *out)
 {
     if (!out) return;
@@ -40,3 +65,83 @@ void hal_read_inputs(hal_inputs_t *out)
     out->estop   = false;
     out->probe   = false;
 }
+
+void hal_spindle_set(hal_spindle_dir_t dir, float pwm_0_to_1)
+{
+    (void)dir;
+    (void)pwm_0_to_1;
+}
+
+/* Step timer: TIM2 (32-bit, APB1) counting at HAL_STEP_TIMER_HZ.
+ * The update interrupt calls the stepper core once per step period.
+ * ARR is not preloaded so a period written from the callback applies to the
+ * interval that has just started.
+ */
+static hal_step_timer_cb_t s_step_cb;
+static void *s_step_user;
+
+void hal_step_timer_init(hal_step_timer_cb_t cb, void *user)
+{
+    s_step_cb = cb;
+    s_step_user = user;
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    TIM2->CR1 = TIM_CR1_URS;
+    TIM2->PSC = (SystemCoreClock / HAL_STEP_TIMER_HZ) - 1u;
+    TIM2->ARR = 0xFFFFFFFFu;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->SR = 0u;
+    TIM2->DIER = TIM_DIER_UIE;
+
+    /* Step timing outranks UART RX so pulses stay on time during streaming. */
+    HAL_NVIC_SetPriority(TIM2_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+void hal_step_timer_start(uint32_t period_ticks)
+{
+    if (period_ticks == 0u) period_ticks = 1u;
+    TIM2->CR1 &= ~TIM_CR1_CEN;
+    TIM2->CNT = 0u;
+    TIM2->ARR = period_ticks - 1u;
+    TIM2->SR = 0u;
+    TIM2->CR1 |= TIM_CR1_CEN;
+}
+
+void hal_step_timer_set_period(uint32_t period_ticks)
+{
+    if (period_ticks == 0u) period_ticks = 1u;
+    TIM2->ARR = period_ticks - 1u;
+    /* Counter already past the new top: restart the interval instead of
+     * letting it wrap through the full 32-bit range. */
+    if (TIM2->CNT >= TIM2->ARR) {
+        TIM2->CNT = 0u;
+    }
+}
+
+void hal_step_timer_stop(void)
+{
+    TIM2->CR1 &= ~TIM_CR1_CEN;
+    TIM2->SR = 0u;
+}
+
+/* The counter restarts from 0 at the update event, so at ISR entry it
+ * holds the ticks since the interrupt was raised. */
+uint32_t hal_step_timer_latency(void)
+{
+    return TIM2->CNT;
+}
+
+void TIM2_IRQHandler(void)
+{
+    if ((TIM2->DIER & TIM_DIER_CC1IE) != 0u && (TIM2->SR & TIM_SR_CC1IF) != 0u) {
+        TIM2->SR = ~TIM_SR_CC1IF;
+        TIM2->DIER &= ~TIM_DIER_CC1IE;
+        for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
+            hal_stepper_step_clear(axis);
+        }
+    }
+    if ((TIM2->SR & TIM_SR_UIF) == 0u) return;
+    TIM2->SR = ~TIM_SR_UIF;
+    if (s_step_cb) s_step_cb(s_step_user);
+}
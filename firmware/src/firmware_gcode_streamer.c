@@ -1,67 +1,98 @@
-#include "firmware_gcode_streamer.h"
-
-#include <string.h>
-
-static void enqueue_line(serial_uart_t *uart, const char *s) {
-    if (!uart || !s) return;
-    (void)serial_uart_tx_enqueue(uart, (const uint8_t *)s, strlen(s));
-    (void)serial_uart_tx_enqueue(uart, (const uint8_t *)"\r\n", 2u);
-}
-
-void fw_gcode_streamer_init(fw_gcode_streamer_t *s) {
-    if (!s) return;
-    memset(s, 0, sizeof(*s));
-
-    serial_uart_init(&s->uart);
-    serial_gcode_bridge_init(&s->bridge);
-
-    /* Optional: if you want to override motion backend:
-     * serial_gcode_bridge_set_motion_backend(&s->bridge, my_backend, my_ctx);
-     */
-}
-
-void fw_gcode_streamer_rx_bytes(fw_gcode_streamer_t *s, const uint8_t *data, size_t len) {
-    if (!s || !data || len == 0u) return;
-
-    /* Push into RX ring buffer (safe to call from ISR if you avoid races with pop;
-     * for a real MCU you may want to guard with IRQ disable or make head/tail volatile).
-     */
-    (void)serial_uart_rx_push(&s->uart, data, len);
-}
-
-void fw_gcode_streamer_poll(fw_gcode_streamer_t *s) {
-    if (!s) return;
-
-    /* Keep draining lines that are already complete in the RX ring. */
-    while (1) {
-        uart_line_status_t lst = serial_uart_read_line(&s->uart, s->line_buf, sizeof(s->line_buf));
-        if (lst == UART_LINE_NONE) {
-            break;
-        }
-
-        if (lst == UART_LINE_OVERFLOW) {
-            enqueue_line(&s->uart, "error: line overflow");
-            continue;
-        }
-
-        /* Process one complete G-code line (already stripped of CR/LF). */
-        s->resp_buf[0] = '\0';
-        (void)serial_gcode_bridge_process_line(&s->bridge,
-                                              s->line_buf,
-                                              s->resp_buf,
-                                              sizeof(s->resp_buf));
-
-        /* Typical CNC streaming behavior: respond per line. */
-        enqueue_line(&s->uart, s->resp_buf[0] ? s->resp_buf : "OK");
-    }
-}
-
-bool fw_gcode_streamer_tx_pop(fw_gcode_streamer_t *s, uint8_t *out_byte) {
-    if (!s) return false;
-    return serial_uart_tx_pop_byte(&s->uart, out_byte);
-}
-
-size_t fw_gcode_streamer_tx_write(fw_gcode_streamer_t *s, const char *str) {
-    if (!s || !str) return 0u;
-    return serial_uart_tx_enqueue(&s->uart, (const uint8_t *)str, strlen(str));
-}
+#include "firmware_gcode_streamer.h"
+
+#include <string.h>
+
+static void enqueue_line(serial_uart_t *uart, const char *s) {
+    if (!uart || !s) return;
+    (void)serial_uart_tx_enqueue(uart, (const uint8_t *)s, strlen(s));
+    (void)serial_uart_tx_enqueue(uart, (const uint8_t *)"\r\n", 2u);
+}
+
+/* Bridge report hook: status reports and the reset banner go out as lines */
+static void report_line(void *ctx, const char *msg) {
+    enqueue_line((serial_uart_t *)ctx, msg);
+}
+
+void fw_gcode_streamer_init(fw_gcode_streamer_t *s) {
+    if (!s) return;
+    memset(s, 0, sizeof(*s));
+
+    serial_uart_init(&s->uart);
+    serial_gcode_bridge_init(&s->bridge);
+    serial_gcode_bridge_set_report(&s->bridge, report_line, &s->uart);
+
+    /* Optional: if you want to override motion backend:
+     * serial_gcode_bridge_set_motion_backend(&s->bridge, my_backend, my_ctx);
+     */
+}
+
+void fw_gcode_streamer_rx_bytes(fw_gcode_streamer_t *s, const uint8_t *data, size_t len) {
+    if (!s || !data || len == 0u) return;
+
+    /* Push line data in runs between realtime bytes. RX ring is SPSC:
+     * safe from an ISR while the main loop polls. */
+    size_t start = 0u;
+    for (size_t i = 0u; i < len; i++) {
+        proto_rt_cmd_t rt = protocol_rt_classify(data[i]);
+        if (rt == PROTO_RT_NONE) continue;
+        if (i > start) (void)serial_uart_rx_push(&s->uart, &data[start], i - start);
+        serial_gcode_bridge_realtime(&s->bridge, rt);
+        start = i + 1u;
+    }
+    if (len > start) (void)serial_uart_rx_push(&s->uart, &data[start], len - start);
+}
+
+bool fw_gcode_streamer_rx_realtime(void *streamer, uint8_t byte) {
+    fw_gcode_streamer_t *s = (fw_gcode_streamer_t *)streamer;
+    proto_rt_cmd_t rt = protocol_rt_classify(byte);
+    if (!s || rt == PROTO_RT_NONE) return false;
+    serial_gcode_bridge_realtime(&s->bridge, rt);
+    return true;
+}
+
+void fw_gcode_streamer_poll(fw_gcode_streamer_t *s) {
+    if (!s) return;
+
+    /* Keep the segment buffer topped up for the step timer ISR. */
+    if (!serial_gcode_bridge_poll(&s->bridge)) {
+        enqueue_line(&s->uart, "error: safety input active");
+    }
+
+    /* Keep draining lines that are already complete in the RX ring. */
+    while (1) {
+        uart_line_status_t lst = serial_uart_read_line(&s->uart, s->line_buf, sizeof(s->line_buf));
+        if (lst == UART_LINE_NONE) {
+            break;
+        }
+
+        if (lst == UART_LINE_OVERFLOW) {
+            enqueue_line(&s->uart, "error: line overflow");
+            continue;
+        }
+
+        /* Process one complete G-code line (already stripped of CR/LF). */
+        s->resp_buf[0] = '\0';
+        (void)serial_gcode_bridge_process_line(&s->bridge,
+                                              s->line_buf,
+                                              s->resp_buf,
+                                              sizeof(s->resp_buf));
+
+        /* Typical CNC streaming behavior: respond per line. */
+        enqueue_line(&s->uart, s->resp_buf[0] ? s->resp_buf : "OK");
+    }
+}
+
+bool fw_gcode_streamer_tx_pop(fw_gcode_streamer_t *s, uint8_t *out_byte) {
+    if (!s) return false;
+    return serial_uart_tx_pop_byte(&s->uart, out_byte);
+}
+
+size_t fw_gcode_streamer_tx_read(fw_gcode_streamer_t *s, uint8_t *out, size_t cap) {
+    if (!s) return 0u;
+    return serial_uart_tx_pop(&s->uart, out, cap);
+}
+
+size_t fw_gcode_streamer_tx_write(fw_gcode_streamer_t *s, const char *str) {
+    if (!s || !str) return 0u;
+    return serial_uart_tx_enqueue(&s->uart, (const uint8_t *)str, strlen(str));
+}
@@ -3,9 +3,9 @@
 #include "gcode.h"
 #include "arc.h"
 #include "kinematics.h"
+#include "profile.h"
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
 #include <math.h>
 
 /* NAN helper for optional parameters */
@@ -41,7 +41,47 @@ void gcode_init(gcode_state_t *gc) {
 }
 
 void gcode_reset(gcode_state_t *gc) {
+    if (!gc) return;
+    planner_queue_t *planner = gc->planner;
+    gcode_planner_wait_t wait = gc->planner_wait;
+    void *wait_user = gc->planner_wait_user;
+    gcode_spindle_sync_t sync = gc->spindle_sync;
+    void *sync_user = gc->spindle_sync_user;
+    
     gcode_init(gc);
+    gcode_set_planner(gc, planner, wait, wait_user);
+    gcode_set_spindle_sync(gc, sync, sync_user);
+}
+
+/* Planner continues from the current G-code position */
+static void sync_planner_position(gcode_state_t *gc) {
+    if (!gc->planner) return;
+    kin_cart_t position = {{ gc->position_x, gc->position_y, 0.0f }};
+    planner_set_position(gc->planner, &position);
+}
+
+void gcode_set_planner(gcode_state_t *gc, planner_queue_t *planner,
+                       gcode_planner_wait_t wait, void *wait_user) {
+    if (!gc) return;
+    gc->planner = planner;
+    gc->planner_wait = wait;
+    gc->planner_wait_user = wait_user;
+    sync_planner_position(gc);
+}
+
+void gcode_set_spindle_sync(gcode_state_t *gc, gcode_spindle_sync_t sync, void *sync_user) {
+    if (!gc) return;
+    gc->spindle_sync = sync;
+    gc->spindle_sync_user = sync_user;
+}
+
+/* Hand the current spindle state to the output */
+static gcode_status_t sync_spindle(gcode_state_t *gc) {
+    if (gc->spindle_sync &&
+        !gc->spindle_sync(gc->spindle_sync_user, gc->spindle_state, gc->spindle_speed)) {
+        return GCODE_ERR_MOTION_ABORTED;
+    }
+    return GCODE_OK;
 }
 
 /* ----------------------------- Parsing helpers ----------------------------- */
@@ -53,35 +93,127 @@ static float units_to_mm(const gcode_state_t *gc, float value) {
     return value;
 }
 
+/* Whitespace, without the locale lookup of isspace() */
+static inline bool is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static inline bool is_digit(char c) {
+    return (unsigned char)(c - '0') <= 9u;
+}
+
 /* Skip whitespace */
 static const char *skip_ws(const char *s) {
-    while (*s && isspace((unsigned char)*s)) s++;
+    while (is_ws(*s)) s++;
     return s;
 }
 
+/* Decimal word value as a scaled integer: value = mantissa / 10^scale */
+typedef struct {
+    uint32_t mantissa;
+    uint8_t scale;         /* Digits after the decimal point kept in mantissa */
+    uint8_t shift;         /* Integer digits dropped past the mantissa (x10^shift) */
+    bool negative;
+} gcode_decimal_t;
+
+/* Significant digits kept; 999999999 still fits in uint32_t */
+#define DECIMAL_MAX_DIGITS 9u
+/* Largest power of ten that is exact in a float */
+#define DECIMAL_POW10_MAX 10u
+
+static const float pow10_table[DECIMAL_POW10_MAX + 1u] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+/* Scan [sign] digits [. digits] in one pass. Digits past the ninth
+ * significant one only move the decimal point. No exponent, hex, inf or
+ * nan forms: G-code numbers are plain decimals. */
+static bool scan_decimal(const char **ptr, gcode_decimal_t *out) {
+    const char *p = skip_ws(*ptr);
+    uint32_t mantissa = 0;
+    uint32_t digits = 0;        /* Significant digits in mantissa */
+    uint32_t scale = 0;
+    uint32_t shift = 0;
+    bool any = false;
+    
+    out->negative = false;
+    if (*p == '-' || *p == '+') {
+        out->negative = (*p == '-');
+        p++;
+    }
+    
+    for (; is_digit(*p); p++) {
+        any = true;
+        if (digits < DECIMAL_MAX_DIGITS) {
+            mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+            if (mantissa != 0u) digits++;
+        } else {
+            shift++;
+        }
+    }
+    if (*p == '.') {
+        p++;
+        for (; is_digit(*p); p++) {
+            any = true;
+            if (digits < DECIMAL_MAX_DIGITS) {
+                mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+                if (mantissa != 0u) digits++;
+                scale++;
+            }
+        }
+    }
+    
+    if (!any) return false;  /* no conversion */
+    if (shift > DECIMAL_POW10_MAX || scale > 255u) return false;
+    
+    out->mantissa = mantissa;
+    out->scale = (uint8_t)scale;
+    out->shift = (uint8_t)shift;
+    *ptr = p;
+    return true;
+}
+
+static float decimal_to_float(const gcode_decimal_t *d) {
+    /* Mantissa and power of ten are both exact below 2^24, so the common
+     * short words ("19.126") round exactly like strtof */
+    float val = (float)d->mantissa;
+    uint32_t scale = d->scale;
+    
+    while (scale > DECIMAL_POW10_MAX) {
+        val /= pow10_table[DECIMAL_POW10_MAX];
+        scale -= DECIMAL_POW10_MAX;
+    }
+    val /= pow10_table[scale];
+    val *= pow10_table[d->shift];
+    return d->negative ? -val : val;
+}
+
 /* Parse a floating point number after a letter code */
 static bool parse_float(const char **ptr, float *out) {
-    char *end;
-    float val = strtof(*ptr, &end);
-    if (end == *ptr) return false;  /* no conversion */
-    *out = val;
-    *ptr = end;
+    gcode_decimal_t d;
+    if (!scan_decimal(ptr, &d)) return false;
+    *out = decimal_to_float(&d);
     return true;
 }
 
-/* Parse an integer number after a letter code */
-static bool parse_int(const char **ptr, int *out) {
-    char *end;
-    long val = strtol(*ptr, &end, 10);
-    if (end == *ptr) return false;  /* no conversion */
-    *out = (int)val;
-    *ptr = end;
-    return true;
+/* Command number after G or M. Returns GCODE_ERR_INVALID_PARAM when there
+ * is no number and GCODE_ERR_UNSUPPORTED_CMD for subcodes such as G38.2. */
+static gcode_status_t parse_command(const char **ptr, int *out) {
+    gcode_decimal_t d;
+    if (!scan_decimal(ptr, &d) || d.shift != 0u) return GCODE_ERR_INVALID_PARAM;
+    
+    uint32_t value = d.mantissa;
+    for (uint32_t n = 0; n < d.scale; n++) {
+        if (value % 10u != 0u) return GCODE_ERR_UNSUPPORTED_CMD;
+        value /= 10u;
+    }
+    *out = d.negative ? -(int)value : (int)value;
+    return GCODE_OK;
 }
 
 /* ----------------------------- Line parsing ----------------------------- */
 
-gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
+static gcode_status_t parse_line(const char *line, gcode_block_t *block) {
     if (!line || !block) return GCODE_ERR_INVALID_PARAM;
     
     /* Initialize block */
@@ -94,92 +226,100 @@ gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
     /* Empty line */
     if (*ptr == '\0') return GCODE_OK;
     
-    /* Parse word by word */
+    /* Parse word by word; every character is visited once */
     while (*ptr) {
         ptr = skip_ws(ptr);
         if (*ptr == '\0') break;
         
-        char letter = toupper((unsigned char)*ptr);
+        char letter = *ptr;
+        if (letter >= 'a' && letter <= 'z') letter = (char)(letter - 'a' + 'A');
         ptr++;
         
+        float *value = NULL;
+        bool *present = NULL;
+        
         switch (letter) {
-            case 'G': {
-                int gnum;
-                if (!parse_int(&ptr, &gnum)) return GCODE_ERR_INVALID_PARAM;
-                block->g_code = gnum;
-                block->has_g = true;
-                break;
-            }
-            
+            case 'G':
             case 'M': {
-                int mnum;
-                if (!parse_int(&ptr, &mnum)) return GCODE_ERR_INVALID_PARAM;
-                block->m_code = mnum;
-                block->has_m = true;
-                break;
-            }
-            
-            case 'X': {
-                if (!parse_float(&ptr, &block->x)) return GCODE_ERR_INVALID_PARAM;
-                block->has_x = true;
-                break;
-            }
-            
-            case 'Y': {
-                if (!parse_float(&ptr, &block->y)) return GCODE_ERR_INVALID_PARAM;
-                block->has_y = true;
-                break;
-            }
-            
-            case 'F': {
-                if (!parse_float(&ptr, &block->f)) return GCODE_ERR_INVALID_PARAM;
-                block->has_f = true;
-                break;
-            }
-            
-            case 'S': {
-                if (!parse_float(&ptr, &block->s)) return GCODE_ERR_INVALID_PARAM;
-                block->has_s = true;
-                break;
-            }
-            
-            case 'P': {
-                if (!parse_float(&ptr, &block->p)) return GCODE_ERR_INVALID_PARAM;
-                block->has_p = true;
+                int num;
+                gcode_status_t st = parse_command(&ptr, &num);
+                if (st != GCODE_OK) return st;
+                if (letter == 'G') {
+                    block->g_code = num;
+                    block->has_g = true;
+                } else {
+                    block->m_code = num;
+                    block->has_m = true;
+                }
                 break;
             }
             
-            case 'I': {
-                if (!parse_float(&ptr, &block->i)) return GCODE_ERR_INVALID_PARAM;
-                block->has_i = true;
-                break;
-            }
+            case 'X': value = &block->x; present = &block->has_x; break;
+            case 'Y': value = &block->y; present = &block->has_y; break;
+            case 'F': value = &block->f; present = &block->has_f; break;
+            case 'S': value = &block->s; present = &block->has_s; break;
+            case 'P': value = &block->p; present = &block->has_p; break;
+            case 'I': value = &block->i; present = &block->has_i; break;
+            case 'J': value = &block->j; present = &block->has_j; break;
+            case 'R': value = &block->r; present = &block->has_r; break;
             
-            case 'J': {
-                if (!parse_float(&ptr, &block->j)) return GCODE_ERR_INVALID_PARAM;
-                block->has_j = true;
-                break;
-            }
-            
-            case 'R': {
-                if (!parse_float(&ptr, &block->r)) return GCODE_ERR_INVALID_PARAM;
-                block->has_r = true;
-                break;
-            }
-            
-            /* Ignore other letters for now */
             default:
-                /* Skip to next space or end */
-                while (*ptr && !isspace((unsigned char)*ptr)) ptr++;
+                if (letter >= 'A' && letter <= 'Z') {
+                    /* Other words (N, Z, T, ...) are recorded and their
+                     * value skipped in the same pass */
+                    float ignored;
+                    block->unsupported_words |= 1u << (letter - 'A');
+                    (void)parse_float(&ptr, &ignored);
+                } else {
+                    /* Not a word: skip to next space or end */
+                    while (*ptr && !is_ws(*ptr)) ptr++;
+                }
                 break;
         }
+        
+        if (value != NULL) {
+            if (!parse_float(&ptr, value)) return GCODE_ERR_INVALID_PARAM;
+            *present = true;
+        }
     }
     
     return GCODE_OK;
 }
 
+gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
+    PROFILE_BEGIN(t0);
+    gcode_status_t st = parse_line(line, block);
+    PROFILE_END(PROFILE_ZONE_PARSE, t0);
+    return st;
+}
+
 /* ----------------------------- Execution ----------------------------- */
 
+/* Queue one straight segment ending at (x, y) and move the G-code position
+ * there. Without a planner only the position is tracked. */
+static gcode_status_t queue_line(gcode_state_t *gc, float x, float y, bool rapid) {
+    if (gc->planner) {
+        kin_cart_t target = {{ x, y, 0.0f }};
+        planner_line_data_t data = {
+            .feed_rate = gc->feedrate,
+            .rapid = rapid ? 1u : 0u,
+            .spindle_speed = gc->spindle_speed,
+            .spindle_dir = (uint8_t)gc->spindle_state
+        };
+        planner_line_status_t st;
+        while ((st = planner_line_to(gc->planner, &target, &data)) == PLANNER_LINE_FULL) {
+            if (!gc->planner_wait || !gc->planner_wait(gc->planner_wait_user)) {
+                return GCODE_ERR_MOTION_ABORTED;
+            }
+        }
+        if (st != PLANNER_LINE_OK) return GCODE_ERR_INVALID_TARGET;
+    }
+    
+    gc->position_x = x;
+    gc->position_y = y;
+    return GCODE_OK;
+}
+
 /* Execute motion command - integrates with kinematics for segmentation */
 static gcode_status_t execute_motion(gcode_state_t *gc, const gcode_block_t *block) {
     float target_x = gc->position_x;
@@ -211,13 +351,15 @@ static gcode_status_t execute_motion(gcode_state_t *gc, const gcode_block_t *blo
     
     /* Use kinematics segment_move for path segmentation when available.
      * This subdivides long moves into shorter segments as needed by the
-     * machine geometry (e.g., CoreXY with max_segment_len set).
+     * machine geometry (e.g., CoreXY with max_segment_len set). Each
+     * segment is queued to the planner.
      */
+    bool rapid = (gc->motion_mode == GCODE_MOTION_RAPID);
     if (g_kin.segment_move) {
         kin_cart_t cart_current = {{ gc->position_x, gc->position_y, 0.0f }};
         kin_cart_t cart_target  = {{ target_x, target_y, 0.0f }};
         kin_motion_hint_t hint = {
-            .feed_mm_min = (gc->motion_mode == GCODE_MOTION_RAPID) ? 0.0f : gc->feedrate,
+            .feed_mm_min = rapid ? 0.0f : gc->feedrate,
             .accel_mm_s2 = 0.0f,
             .junction_dev_mm = 0.0f
         };
@@ -226,13 +368,13 @@ static gcode_status_t execute_motion(gcode_state_t *gc, const gcode_block_t *blo
         
         while (g_kin.segment_move(&cart_target, &cart_current, &hint, init, &cart_next)) {
             init = false;
-            /* Each segment endpoint could be converted to joint space and queued:
-             *   kin_joint_t joint;
-             *   g_kin.cart_to_joint(&cart_next, &joint);
-             *   planner_enqueue_joint(&joint, feedrate);
-             */
+            gcode_status_t st = queue_line(gc, cart_next.v[0], cart_next.v[1], rapid);
+            if (st != GCODE_OK) return st;
             cart_current = cart_next;
         }
+    } else {
+        gcode_status_t st = queue_line(gc, target_x, target_y, rapid);
+        if (st != GCODE_OK) return st;
     }
     
     /* Update position */
@@ -261,18 +403,12 @@ typedef struct {
     gcode_status_t status;
 } arc_cb_ctx_t;
 
-/* Callback for each arc segment - updates position */
+/* Callback for each arc segment - queues it and updates position */
 static bool arc_segment_handler(float x, float y, void *user) {
     arc_cb_ctx_t *ctx = (arc_cb_ctx_t *)user;
     
-    /* Update position for each segment endpoint.
-     * In a real system, each segment would be queued to the planner:
-     *   planner_line_to(x, y, ctx->gc->feedrate);
-     */
-    ctx->gc->position_x = x;
-    ctx->gc->position_y = y;
-    
-    return true;
+    ctx->status = queue_line(ctx->gc, x, y, false);
+    return ctx->status == GCODE_OK;
 }
 
 /* Execute arc command (G02/G03) */
@@ -325,7 +461,7 @@ static gcode_status_t execute_arc(gcode_state_t *gc, const gcode_block_t *block,
         return GCODE_ERR_MISSING_PARAM;
     }
     
-    if (!ok) return GCODE_ERR_INVALID_TARGET;
+    if (!ok) return (ctx.status != GCODE_OK) ? ctx.status : GCODE_ERR_INVALID_TARGET;
     
     return ctx.status;
 }
@@ -334,7 +470,8 @@ static gcode_status_t execute_arc(gcode_state_t *gc, const gcode_block_t *block,
 static gcode_status_t execute_program_end(gcode_state_t *gc, int m_code) {
     /* Turn off spindle for safety */
     gc->spindle_state = GCODE_SPINDLE_OFF;
-    /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_OFF, 0.0f); */
+    gcode_status_t status = sync_spindle(gc);
+    if (status != GCODE_OK) return status;
     
     /* Mark program as complete */
     gc->program_complete = true;
@@ -343,6 +480,7 @@ static gcode_status_t execute_program_end(gcode_state_t *gc, int m_code) {
         /* M30 additionally resets position to origin (program rewind) */
         gc->position_x = 0.0f;
         gc->position_y = 0.0f;
+        sync_planner_position(gc);
     }
     
     return GCODE_OK;
@@ -356,7 +494,6 @@ static gcode_status_t execute_spindle(gcode_state_t *gc, int m_code, const gcode
             if (block->has_s) {
                 gc->spindle_speed = block->s;
             }
-            /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_CW, speed_to_pwm(gc->spindle_speed)); */
             break;
             
         case 4:  /* M04 - spindle on, CCW */
@@ -364,19 +501,17 @@ static gcode_status_t execute_spindle(gcode_state_t *gc, int m_code, const gcode
             if (block->has_s) {
                 gc->spindle_speed = block->s;
             }
-            /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_CCW, speed_to_pwm(gc->spindle_speed)); */
             break;
             
         case 5:  /* M05 - spindle off */
             gc->spindle_state = GCODE_SPINDLE_OFF;
-            /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_OFF, 0.0f); */
             break;
             
         default:
             return GCODE_ERR_UNKNOWN_CMD;
     }
     
-    return GCODE_OK;
+    return sync_spindle(gc);
 }
 
 gcode_status_t gcode_execute_block(gcode_state_t *gc, const gcode_block_t *block) {
@@ -384,6 +519,19 @@ gcode_status_t gcode_execute_block(gcode_state_t *gc, const gcode_block_t *block
     
     gcode_status_t status = GCODE_OK;
     
+    /* Spindle changes apply to this line's motion (M02/M30 run last) */
+    if (block->has_m && block->m_code != 2 && block->m_code != 30) {
+        status = execute_spindle(gc, block->m_code, block);
+        if (status != GCODE_OK) return status;
+    } else if (block->has_s && !block->has_m) {
+        /* Standalone S word: spindle speed change without M code */
+        gc->spindle_speed = block->s;
+        if (gc->spindle_state != GCODE_SPINDLE_OFF) {
+            status = sync_spindle(gc);
+            if (status != GCODE_OK) return status;
+        }
+    }
+    
     /* Process G-code commands */
     if (block->has_g) {
         switch (block->g_code) {
@@ -444,29 +592,12 @@ gcode_status_t gcode_execute_block(gcode_state_t *gc, const gcode_block_t *block
         if (status != GCODE_OK) return status;
     }
     
-    /* Process M-code commands */
-    if (block->has_m) {
-        switch (block->m_code) {
-            case 2:  /* M02 - program end */
-            case 30: /* M30 - program end and rewind */
-                status = execute_program_end(gc, block->m_code);
-                break;
-            default:
-                status = execute_spindle(gc, block->m_code, block);
-                break;
-        }
+    /* Program end: M02 - program end, M30 - program end and rewind */
+    if (block->has_m && (block->m_code == 2 || block->m_code == 30)) {
+        status = execute_program_end(gc, block->m_code);
         if (status != GCODE_OK) return status;
     }
     
-    /* Process standalone S word (spindle speed change without M code) */
-    if (block->has_s && !block->has_m) {
-        gc->spindle_speed = block->s;
-        /* Update spindle if it's already running */
-        if (gc->spindle_state != GCODE_SPINDLE_OFF) {
-            /* Interface with HAL to update speed */
-        }
-    }
-    
     return GCODE_OK;
 }
 
@@ -474,10 +605,15 @@ gcode_status_t gcode_process_line(gcode_state_t *gc, const char *line) {
     gcode_block_t block;
     gcode_status_t status;
     
+    if (gc) gc->ignored_words = 0u;
+    
     status = gcode_parse_line(line, &block);
     if (status != GCODE_OK) return status;
     
     status = gcode_execute_block(gc, &block);
+    if (status == GCODE_OK) {
+        gc->ignored_words = block.unsupported_words & ~(1u << ('N' - 'A'));
+    }
     return status;
 }
 
@@ -505,6 +641,10 @@ bool gcode_is_program_complete(const gcode_state_t *gc) {
     return gc ? gc->program_complete : false;
 }
 
+uint32_t gcode_get_ignored_words(const gcode_state_t *gc) {
+    return gc ? gc->ignored_words : 0u;
+}
+
 const char *gcode_status_string(gcode_status_t status) {
     switch (status) {
         case GCODE_OK:                  return "OK";
@@ -514,6 +654,7 @@ const char *gcode_status_string(gcode_status_t status) {
         case GCODE_ERR_UNSUPPORTED_CMD: return "Unsupported command";
         case GCODE_ERR_INVALID_TARGET:  return "Invalid target";
         case GCODE_ERR_OVERFLOW:        return "Overflow";
+        case GCODE_ERR_MOTION_ABORTED:  return "Motion aborted";
         default:                        return "Unknown error";
     }
 }
@@ -0,0 +1,492 @@
+/* hal_linux_sim.c - Linux simulation HAL with virtual time and step trace */
+
+#define _POSIX_C_SOURCE 199309L  /* clock_gettime() for hal_cycles() */
+
+#include "hal_linux_sim.h"
+
+#if defined(GRBL_PLATFORM_LINUX_SIM)
+
+#include <string.h>
+#include <time.h>
+
+#define SIM_GPIO_PINS   32u
+#define SIM_SERIAL_RX   1024u
+#define SIM_TRACE_BUF   (HAL_SIM_TRACE_RECORD_SIZE * 682u)  /* ~4 KB */
+
+/* Virtual clock */
+static uint64_t s_now;
+static uint32_t s_poll_ticks = HAL_SIM_POLL_TICKS;
+
+/* Step timer */
+static hal_step_timer_cb_t s_timer_cb;
+static void *s_timer_user;
+static bool s_timer_running;
+static uint32_t s_timer_period;
+static uint64_t s_timer_deadline;
+static uint32_t s_timer_late;       /* Entry delay of the current/next ISR */
+static bool s_timer_late_drawn;     /* s_timer_late chosen for this deadline */
+static hal_sim_latency_hook_t s_latency_hook;
+static void *s_latency_hook_user;
+
+/* Outputs */
+static hal_sim_stats_t s_stats;
+static bool s_dir_positive[HAL_AXIS_MAX];
+static bool s_dir_known[HAL_AXIS_MAX];
+static bool s_enabled;
+static hal_spindle_dir_t s_spindle_dir;
+static float s_spindle_pwm;
+static hal_pin_state_t s_gpio[SIM_GPIO_PINS];
+static hal_inputs_t s_inputs;
+static hal_sim_step_hook_t s_step_hook;
+static void *s_step_hook_user;
+static uint32_t s_step_high;        /* Step pins currently high */
+static uint32_t s_pulse_width;      /* hal_stepper_set_pulse_width() */
+static uint64_t s_pulse_end;        /* When the high pins drop */
+
+/* Serial: RX ring fed by the simulation, TX to a stream */
+static uint8_t s_rx[SIM_SERIAL_RX];
+static size_t s_rx_head;
+static size_t s_rx_tail;
+static FILE *s_serial_out;
+static bool s_serial_out_set;
+
+/* Trace */
+static FILE *s_trace;
+static bool s_trace_owned;
+static uint8_t s_trace_buf[SIM_TRACE_BUF];
+static size_t s_trace_len;
+static uint64_t s_trace_last;
+
+/* ----------------------------- Trace ----------------------------- */
+
+static void trace_flush(void) {
+    if (s_trace && s_trace_len > 0u) {
+        (void)fwrite(s_trace_buf, 1u, s_trace_len, s_trace);
+    }
+    s_trace_len = 0u;
+}
+
+static void trace_put(uint8_t type, uint8_t data, uint32_t delta) {
+    if (s_trace_len + HAL_SIM_TRACE_RECORD_SIZE > sizeof(s_trace_buf)) {
+        trace_flush();
+    }
+    uint8_t *rec = &s_trace_buf[s_trace_len];
+    rec[0] = type;
+    rec[1] = data;
+    rec[2] = (uint8_t)delta;
+    rec[3] = (uint8_t)(delta >> 8);
+    rec[4] = (uint8_t)(delta >> 16);
+    rec[5] = (uint8_t)(delta >> 24);
+    s_trace_len += HAL_SIM_TRACE_RECORD_SIZE;
+}
+
+static void trace_record(hal_sim_record_t type, uint8_t data) {
+    if (!s_trace) {
+        return;
+    }
+
+    uint64_t delta = s_now - s_trace_last;
+    while (delta > 0xFFFFFFFFu) {
+        trace_put(HAL_SIM_REC_GAP, 0u, 0xFFFFFFFFu);
+        delta -= 0xFFFFFFFFu;
+    }
+    trace_put((uint8_t)type, data, (uint32_t)delta);
+    s_trace_last = s_now;
+}
+
+static bool trace_start(FILE *stream, bool owned) {
+    hal_sim_trace_close();
+    if (!stream) {
+        return false;
+    }
+
+    uint8_t header[HAL_SIM_TRACE_HEADER_SIZE];
+    const uint32_t hz = HAL_STEP_TIMER_HZ;
+    memcpy(header, HAL_SIM_TRACE_MAGIC, 8u);
+    header[8] = (uint8_t)hz;
+    header[9] = (uint8_t)(hz >> 8);
+    header[10] = (uint8_t)(hz >> 16);
+    header[11] = (uint8_t)(hz >> 24);
+    if (fwrite(header, 1u, sizeof(header), stream) != sizeof(header)) {
+        if (owned) {
+            fclose(stream);
+        }
+        return false;
+    }
+
+    s_trace = stream;
+    s_trace_owned = owned;
+    s_trace_len = 0u;
+    s_trace_last = 0u;
+    return true;
+}
+
+bool hal_sim_trace_open(const char *path) {
+    return path ? trace_start(fopen(path, "wb"), true) : false;
+}
+
+bool hal_sim_trace_attach(FILE *stream) {
+    return trace_start(stream, false);
+}
+
+void hal_sim_trace_close(void) {
+    if (!s_trace) {
+        return;
+    }
+    trace_flush();
+    if (s_trace_owned) {
+        fclose(s_trace);
+    } else {
+        fflush(s_trace);
+    }
+    s_trace = NULL;
+    s_trace_owned = false;
+}
+
+/* ----------------------------- Virtual time ----------------------------- */
+
+void hal_sim_reset(void) {
+    s_now = 0u;
+    s_poll_ticks = HAL_SIM_POLL_TICKS;
+    s_timer_running = false;
+    s_timer_period = 0u;
+    s_timer_deadline = 0u;
+    s_timer_late = 0u;
+    s_timer_late_drawn = false;
+    s_step_high = 0u;
+    s_pulse_width = 0u;
+    s_pulse_end = 0u;
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(s_dir_positive, 0, sizeof(s_dir_positive));
+    memset(s_dir_known, 0, sizeof(s_dir_known));
+    s_enabled = false;
+    s_spindle_dir = HAL_SPINDLE_OFF;
+    s_spindle_pwm = 0.0f;
+    memset(s_gpio, 0, sizeof(s_gpio));
+    memset(&s_inputs, 0, sizeof(s_inputs));
+    s_rx_head = 0u;
+    s_rx_tail = 0u;
+    s_trace_last = 0u;
+}
+
+uint64_t hal_sim_now(void) {
+    return s_now;
+}
+
+static void step_pins_drop(uint32_t axis_mask) {
+    axis_mask &= s_step_high;
+    if (axis_mask == 0u) {
+        return;
+    }
+    s_step_high &= ~axis_mask;
+    trace_record(HAL_SIM_REC_STEP_END, (uint8_t)axis_mask);
+}
+
+/* End a timed pulse due by t, at its own time */
+static void pulse_end_until(uint64_t t) {
+    if (s_step_high != 0u && s_pulse_width > 0u && s_pulse_end <= t) {
+        s_now = s_pulse_end;
+        step_pins_drop(s_step_high);
+    }
+}
+
+void hal_sim_advance(uint64_t ticks) {
+    const uint64_t target = s_now + ticks;
+
+    /* Each callback may stop, restart or re-period the timer */
+    while (s_timer_running && s_timer_deadline <= target) {
+        if (!s_timer_late_drawn) {
+            s_timer_late = s_latency_hook ? s_latency_hook(s_latency_hook_user, s_timer_deadline) : 0u;
+            s_timer_late_drawn = true;
+        }
+        /* An ISR still running when the next update comes is re-entered
+         * straight away */
+        uint64_t entry = s_timer_deadline + s_timer_late;
+        if (entry < s_now) {
+            entry = s_now;
+        }
+        if (entry > target) {
+            break;
+        }
+
+        const uint64_t deadline = s_timer_deadline;
+        pulse_end_until(entry);
+        s_now = entry;
+        s_timer_late = (uint32_t)(entry - deadline);
+        s_stats.isr_calls++;
+        s_stats.isr_late_ticks += s_timer_late;
+        s_timer_cb(s_timer_user);
+        if (s_timer_running && s_timer_deadline == deadline) {
+            s_timer_deadline = deadline + s_timer_period;
+        }
+        s_timer_late_drawn = false;
+    }
+    pulse_end_until(target);
+    s_now = target;
+}
+
+void hal_sim_set_poll_ticks(uint32_t ticks) {
+    s_poll_ticks = ticks;
+}
+
+bool hal_sim_timer_running(void) {
+    return s_timer_running;
+}
+
+void hal_sim_get_stats(hal_sim_stats_t *out) {
+    if (out) {
+        *out = s_stats;
+    }
+}
+
+void hal_sim_set_step_hook(hal_sim_step_hook_t hook, void *user) {
+    s_step_hook = hook;
+    s_step_hook_user = user;
+}
+
+void hal_sim_set_latency_hook(hal_sim_latency_hook_t hook, void *user) {
+    s_latency_hook = hook;
+    s_latency_hook_user = user;
+}
+
+void hal_sim_set_inputs(const hal_inputs_t *inputs) {
+    if (inputs) {
+        s_inputs = *inputs;
+    } else {
+        memset(&s_inputs, 0, sizeof(s_inputs));
+    }
+}
+
+size_t hal_sim_serial_feed(const uint8_t *src, size_t len) {
+    size_t n = 0u;
+    while (src && n < len && (s_rx_head + 1u) % SIM_SERIAL_RX != s_rx_tail) {
+        s_rx[s_rx_head] = src[n++];
+        s_rx_head = (s_rx_head + 1u) % SIM_SERIAL_RX;
+    }
+    return n;
+}
+
+void hal_sim_set_serial_out(FILE *stream) {
+    s_serial_out = stream;
+    s_serial_out_set = true;
+}
+
+hal_spindle_dir_t hal_sim_spindle_dir(void) {
+    return s_spindle_dir;
+}
+
+float hal_sim_spindle_pwm(void) {
+    return s_spindle_pwm;
+}
+
+/* ----------------------------- Core lifecycle ----------------------------- */
+
+hal_status_t hal_init(void) {
+    hal_sim_reset();
+    return CORE_HAL_OK;
+}
+
+void hal_start(void) {
+}
+
+void hal_deinit(void) {
+    hal_sim_trace_close();
+}
+
+/* ----------------------------- Time base ----------------------------- */
+
+uint32_t hal_millis(void) {
+    return (uint32_t)(s_now / (HAL_STEP_TIMER_HZ / 1000u));
+}
+
+uint32_t hal_micros(void) {
+    return (uint32_t)((s_now * 1000000u) / HAL_STEP_TIMER_HZ);
+}
+
+void hal_delay_ms(uint32_t ms) {
+    hal_sim_advance((uint64_t)ms * (HAL_STEP_TIMER_HZ / 1000u));
+}
+
+/* Stand-in for the MCU cycle counter: host monotonic nanoseconds. Virtual
+ * time does not move while code runs, so it can't time code. */
+uint32_t hal_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+/* ----------------------------- Serial I/O ----------------------------- */
+
+size_t hal_serial_read(hal_port_t port, uint8_t *dst, size_t cap) {
+    size_t n = 0u;
+    if (port != HAL_PORT_GCODE || !dst) {
+        return 0u;
+    }
+    while (n < cap && s_rx_tail != s_rx_head) {
+        dst[n++] = s_rx[s_rx_tail];
+        s_rx_tail = (s_rx_tail + 1u) % SIM_SERIAL_RX;
+    }
+    return n;
+}
+
+size_t hal_serial_write(hal_port_t port, const uint8_t *src, size_t len) {
+    (void)port;
+    FILE *out = s_serial_out_set ? s_serial_out : stdout;
+    if (!src) {
+        return 0u;
+    }
+    if (out) {
+        (void)fwrite(src, 1u, len, out);
+    }
+    return len;
+}
+
+size_t hal_serial_write_str(hal_port_t port, const char *s) {
+    return hal_serial_write(port, (const uint8_t *)s, s ? strlen(s) : 0u);
+}
+
+size_t hal_serial_encode32(hal_port_t port, const char *s) {
+    return hal_serial_write_str(port, s);
+}
+
+/* ----------------------------- Digital I/O ----------------------------- */
+
+void hal_gpio_write(uint32_t pin_id, hal_pin_state_t state) {
+    if (pin_id < SIM_GPIO_PINS) {
+        s_gpio[pin_id] = state;
+    }
+}
+
+hal_pin_state_t hal_gpio_read(uint32_t pin_id) {
+    return pin_id < SIM_GPIO_PINS ? s_gpio[pin_id] : HAL_PIN_LOW;
+}
+
+/* ----------------------------- Motion outputs ----------------------------- */
+
+void hal_stepper_enable(bool en) {
+    if (en != s_enabled) {
+        s_enabled = en;
+        trace_record(HAL_SIM_REC_ENABLE, en ? 1u : 0u);
+    }
+}
+
+void hal_stepper_set_dir(hal_axis_t axis, bool dir_positive) {
+    if (axis >= HAL_AXIS_MAX) {
+        return;
+    }
+    if (s_dir_known[axis] && s_dir_positive[axis] == dir_positive) {
+        return;
+    }
+    if (s_dir_known[axis]) {
+        s_stats.dir_changes[axis]++;
+    }
+    s_dir_known[axis] = true;
+    s_dir_positive[axis] = dir_positive;
+    trace_record(HAL_SIM_REC_DIR, (uint8_t)((uint8_t)axis | (dir_positive ? 0x80u : 0u)));
+}
+
+void hal_stepper_pulse_mask(uint32_t axis_mask) {
+    axis_mask &= (1u << HAL_AXIS_MAX) - 1u;
+    if (axis_mask == 0u) {
+        return;
+    }
+
+    for (uint8_t axis = 0; axis < HAL_AXIS_MAX; axis++) {
+        if (axis_mask & (1u << axis)) {
+            s_stats.steps[axis]++;
+            s_stats.position[axis] += s_dir_positive[axis] ? 1 : -1;
+        }
+    }
+    if (s_stats.first_step_ticks == 0u && s_stats.last_step_ticks == 0u) {
+        s_stats.first_step_ticks = s_now;
+    }
+    s_stats.last_step_ticks = s_now;
+    s_step_high |= axis_mask;
+    s_pulse_end = s_now + s_pulse_width;
+    trace_record(HAL_SIM_REC_STEP, (uint8_t)axis_mask);
+
+    if (s_step_hook) {
+        s_step_hook(s_step_hook_user, s_now, axis_mask);
+    }
+}
+
+void hal_stepper_step_pulse(hal_axis_t axis) {
+    if (axis < HAL_AXIS_MAX) {
+        hal_stepper_pulse_mask(1u << axis);
+    }
+}
+
+void hal_stepper_step_clear(hal_axis_t axis) {
+    if (axis < HAL_AXIS_MAX) {
+        step_pins_drop(1u << axis);
+    }
+}
+
+/* Takes effect from the next pulse */
+void hal_stepper_set_pulse_width(uint32_t ticks) {
+    s_pulse_width = ticks;
+}
+
+/* ----------------------------- Step timer ----------------------------- */
+
+void hal_step_timer_init(hal_step_timer_cb_t cb, void *user) {
+    s_timer_cb = cb;
+    s_timer_user = user;
+    s_timer_running = false;
+}
+
+void hal_step_timer_start(uint32_t period_ticks) {
+    s_timer_period = period_ticks > 0u ? period_ticks : 1u;
+    s_timer_deadline = s_now + s_timer_period;
+    s_timer_late_drawn = false;
+    s_timer_running = s_timer_cb != NULL;
+}
+
+void hal_step_timer_set_period(uint32_t period_ticks) {
+    s_timer_period = period_ticks > 0u ? period_ticks : 1u;
+}
+
+void hal_step_timer_stop(void) {
+    s_timer_running = false;
+}
+
+uint32_t hal_step_timer_latency(void) {
+    return s_timer_late;
+}
+
+/* ----------------------------- Spindle / coolant ----------------------------- */
+
+void hal_spindle_set(hal_spindle_dir_t dir, float pwm_0_to_1) {
+    if (pwm_0_to_1 < 0.0f) pwm_0_to_1 = 0.0f;
+    if (pwm_0_to_1 > 1.0f) pwm_0_to_1 = 1.0f;
+    s_spindle_dir = dir;
+    s_spindle_pwm = pwm_0_to_1;
+    trace_record(HAL_SIM_REC_SPINDLE,
+                 dir == HAL_SPINDLE_OFF ? 0u : (uint8_t)(pwm_0_to_1 * 255.0f + 0.5f));
+}
+
+void hal_coolant_mist(bool on) {
+    (void)on;
+}
+
+void hal_coolant_flood(bool on) {
+    (void)on;
+}
+
+/* ----------------------------- Inputs / scheduling ----------------------------- */
+
+void hal_read_inputs(hal_inputs_t *out) {
+    if (out) {
+        *out = s_inputs;
+    }
+}
+
+/* One pass of the foreground loop takes s_poll_ticks of virtual time */
+void hal_poll(void) {
+    hal_sim_advance(s_poll_ticks);
+}
+
+void hal_tick_1khz_isr(void) {
+}
+
+#endif /* GRBL_PLATFORM_LINUX_SIM */
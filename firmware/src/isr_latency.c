@@ -0,0 +1,46 @@
+/* isr_latency.c - Step ISR entry latency histogram */
+
+#include "isr_latency.h"
+
+#include <string.h>
+
+uint8_t isr_latency_bucket(uint32_t late_ticks) {
+    if (late_ticks == 0u) {
+        return 0u;
+    }
+    const uint8_t bits = (uint8_t)(32 - __builtin_clz(late_ticks));
+    return bits < ISR_LATENCY_BUCKETS ? bits : (uint8_t)(ISR_LATENCY_BUCKETS - 1u);
+}
+
+uint32_t isr_latency_bucket_floor(uint8_t bucket) {
+    if (bucket == 0u) {
+        return 0u;
+    }
+    if (bucket >= ISR_LATENCY_BUCKETS) {
+        bucket = ISR_LATENCY_BUCKETS - 1u;
+    }
+    return 1u << (bucket - 1u);
+}
+
+#if GRBL_FEATURE_ISR_LATENCY
+
+static isr_latency_stats_t s_stats;
+
+void isr_latency_record(uint32_t late_ticks, uint32_t duration_cycles) {
+    s_stats.buckets[isr_latency_bucket(late_ticks)]++;
+    s_stats.samples++;
+    if (late_ticks > s_stats.max_latency_ticks) s_stats.max_latency_ticks = late_ticks;
+    if (duration_cycles > s_stats.max_duration_cycles) s_stats.max_duration_cycles = duration_cycles;
+}
+
+void isr_latency_reset(void) {
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void isr_latency_get(isr_latency_stats_t *out) {
+    if (out) {
+        *out = s_stats;
+    }
+}
+
+#endif /* GRBL_FEATURE_ISR_LATENCY */
@@ -4,89 +4,48 @@
 #include "planner.h"
 #include "cnc_hal.h"
 #include <math.h>
-#include <string.h>
 
-/* Internal config + internal machine pose.
- * In a real firmware you might store machine pose elsewhere; here we keep it simple.
- */
-static kin_corexy_cfg_t s_cfg;
-static kin_cart_t s_machine_pose_cart; /* current machine position in Cartesian */
-
-/* ----------------- small helpers ----------------- */
+#define COREXY_DEFAULT_STEPS_AB 80.0f   /* A, B */
+#define COREXY_DEFAULT_STEPS_Z  400.0f  /* Z (AUX unused) */
 
-static float maybe_invert(bool inv, float x) { return inv ? -x : x; }
-
-static void apply_cart_invert(const kin_corexy_cfg_t *c, kin_cart_t *p) {
-    for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) p->v[i] = maybe_invert(c->invert_cart[i], p->v[i]);
+#define COREXY_DEFAULT_CFG {                                                                \
+    .steps_per_mm = { COREXY_DEFAULT_STEPS_AB, COREXY_DEFAULT_STEPS_AB, COREXY_DEFAULT_STEPS_Z, 0.0f }, \
+    .max_segment_len_mm = 0.0f, /* disabled by default */                                   \
+    .home_fast_mm_min = 800.0f,                                                              \
+    .home_slow_mm_min = 200.0f,                                                              \
 }
 
-static void apply_joint_invert(const kin_corexy_cfg_t *c, kin_joint_t *p) {
-    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) p->v[i] = maybe_invert(c->invert_joint[i], p->v[i]);
-}
+static const kin_corexy_cfg_t s_default_cfg = COREXY_DEFAULT_CFG;
 
-static void apply_joint_invert_steps(const kin_corexy_cfg_t *c, kin_steps_t *p) {
-    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
-        if (c->invert_joint[i]) p->v[i] = -p->v[i];
-    }
-}
+/* Config (with what kin_corexy_set_cfg() would derive from the defaults)
+ * + internal machine pose.
+ * In a real firmware you might store machine pose elsewhere; here we keep it simple.
+ */
+kin_corexy_t g_kin_corexy = {
+    .cfg = COREXY_DEFAULT_CFG,
+    .cart_sign = { 1.0f, 1.0f, 1.0f },
+    .joint_sign = { 1.0f, 1.0f, 1.0f, 1.0f },
+    .joint_mm_per_step = { 1.0f / COREXY_DEFAULT_STEPS_AB, 1.0f / COREXY_DEFAULT_STEPS_AB,
+                           1.0f / COREXY_DEFAULT_STEPS_Z, 0.0f },
+};
+static kin_cart_t s_machine_pose_cart; /* current machine position in Cartesian */
 
 /* ----------------- interface functions ----------------- */
 
+/* The math is in kin_corexy.h so GRBL_KIN_COREXY builds can inline it */
 static void corexy_steps_to_cart(const kin_steps_t *steps, kin_cart_t *out_cart)
 {
-    /* steps -> joint mm -> cart mm */
-    kin_steps_t st = *steps;
-    apply_joint_invert_steps(&s_cfg, &st);
-
-    /* Convert steps to "joint mm-equivalent" */
-    float a = 0.0f, b = 0.0f, z = 0.0f;
-
-    if (s_cfg.steps_per_mm[0] != 0.0f) a = (float)st.v[0] / s_cfg.steps_per_mm[0];
-    if (s_cfg.steps_per_mm[1] != 0.0f) b = (float)st.v[1] / s_cfg.steps_per_mm[1];
-    if (s_cfg.steps_per_mm[2] != 0.0f) z = (float)st.v[2] / s_cfg.steps_per_mm[2];
-
-    /* Inverse CoreXY */
-    out_cart->v[0] = 0.5f * (a + b); /* X */
-    out_cart->v[1] = 0.5f * (a - b); /* Y */
-    out_cart->v[2] = z;              /* Z passes through */
-
-    apply_cart_invert(&s_cfg, out_cart);
+    kin_corexy_steps_to_cart(&g_kin_corexy, steps, out_cart);
 }
 
 static bool corexy_cart_to_joint(const kin_cart_t *cart_in, kin_joint_t *out_joint)
 {
-    kin_cart_t cart = *cart_in;
-    apply_cart_invert(&s_cfg, &cart); /* bring into "mechanism space" */
-
-    const float x = cart.v[0];
-    const float y = cart.v[1];
-    const float z = cart.v[2];
-
-    /* Forward CoreXY */
-    out_joint->v[0] = x + y; /* A */
-    out_joint->v[1] = x - y; /* B */
-    out_joint->v[2] = z;     /* Z */
-    out_joint->v[3] = 0.0f;  /* AUX unused by default */
-
-    apply_joint_invert(&s_cfg, out_joint);
-    return true;
+    return kin_corexy_cart_to_joint(&g_kin_corexy, cart_in, out_joint);
 }
 
 static bool corexy_joint_to_cart(const kin_joint_t *joint_in, kin_cart_t *out_cart)
 {
-    kin_joint_t j = *joint_in;
-    apply_joint_invert(&s_cfg, &j); /* back to mechanism direction */
-
-    const float a = j.v[0];
-    const float b = j.v[1];
-    const float z = j.v[2];
-
-    out_cart->v[0] = 0.5f * (a + b);
-    out_cart->v[1] = 0.5f * (a - b);
-    out_cart->v[2] = z;
-
-    apply_cart_invert(&s_cfg, out_cart);
-    return true;
+    return kin_corexy_joint_to_cart(&g_kin_corexy, joint_in, out_cart);
 }
 
 static bool corexy_segment_move(const kin_cart_t *cart_target,
@@ -107,7 +66,7 @@ static bool corexy_segment_move(const kin_cart_t *cart_target,
 
     if (!cart_target || !cart_current || !out_cart_next) return false;
 
-    if (s_cfg.max_segment_len_mm <= 0.0f) {
+    if (g_kin_corexy.cfg.max_segment_len_mm <= 0.0f) {
         if (init) { *out_cart_next = *cart_target; return true; }
         return false;
     }
@@ -126,7 +85,7 @@ static bool corexy_segment_move(const kin_cart_t *cart_target,
         float ay = dy; if (ay < 0) ay = -ay; if (ay > maxd) maxd = ay;
         float az = dz; if (az < 0) az = -az; if (az > maxd) maxd = az;
 
-        s_n = (uint16_t)(maxd / s_cfg.max_segment_len_mm);
+        s_n = (uint16_t)(maxd / g_kin_corexy.cfg.max_segment_len_mm);
         if (s_n == 0) s_n = 1;
         if (s_n > 10000u) s_n = 10000u; /* sanity clamp */
     }
@@ -182,8 +141,9 @@ static float corexy_homing_feedrate(kin_axis_mask_t axes, float req, kin_home_mo
 {
     (void)axes;
 
-    if (mode == KIN_HOME_FAST && s_cfg.home_fast_mm_min > 0.0f) return s_cfg.home_fast_mm_min;
-    if (mode == KIN_HOME_SLOW && s_cfg.home_slow_mm_min > 0.0f) return s_cfg.home_slow_mm_min;
+    const kin_corexy_cfg_t *c = &g_kin_corexy.cfg;
+    if (mode == KIN_HOME_FAST && c->home_fast_mm_min > 0.0f) return c->home_fast_mm_min;
+    if (mode == KIN_HOME_SLOW && c->home_slow_mm_min > 0.0f) return c->home_slow_mm_min;
     return req;
 }
 
@@ -192,28 +152,31 @@ static float corexy_homing_feedrate(kin_axis_mask_t axes, float req, kin_home_mo
 void kin_corexy_set_cfg(const kin_corexy_cfg_t *cfg)
 {
     if (!cfg) return;
-    s_cfg = *cfg;
+    kin_corexy_t *k = &g_kin_corexy;
+    k->cfg = *cfg;
+
+    /* Fold inversion and 1/steps_per_mm into per-axis factors once here
+     * instead of per conversion */
+    for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        k->cart_sign[i] = cfg->invert_cart[i] ? -1.0f : 1.0f;
+    }
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        k->joint_sign[i] = cfg->invert_joint[i] ? -1.0f : 1.0f;
+        k->joint_mm_per_step[i] = (cfg->steps_per_mm[i] != 0.0f)
+                                      ? k->joint_sign[i] / cfg->steps_per_mm[i]
+                                      : 0.0f;
+    }
 }
 
 void kin_corexy_get_cfg(kin_corexy_cfg_t *out)
 {
     if (!out) return;
-    *out = s_cfg;
+    *out = g_kin_corexy.cfg;
 }
 
 void kin_corexy_install(const kin_corexy_cfg_t *cfg)
 {
-    /* Defaults */
-    memset(&s_cfg, 0, sizeof(s_cfg));
-    s_cfg.steps_per_mm[0] = 80.0f; /* A */
-    s_cfg.steps_per_mm[1] = 80.0f; /* B */
-    s_cfg.steps_per_mm[2] = 400.0f;/* Z */
-    s_cfg.steps_per_mm[3] = 0.0f;  /* AUX unused */
-    s_cfg.max_segment_len_mm = 0.0f; /* disabled by default */
-    s_cfg.home_fast_mm_min = 800.0f;
-    s_cfg.home_slow_mm_min = 200.0f;
-
-    if (cfg) s_cfg = *cfg;
+    kin_corexy_set_cfg(cfg ? cfg : &s_default_cfg);
 
     /* Build interface */
     kin_iface_t impl = {
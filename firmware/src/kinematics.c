@@ -1,4 +1,8 @@
-/* kinematics.c - minimal installer + safe defaults */
+/* kinematics.c - minimal installer + Cartesian defaults
+ *
+ * The default interface is a plain Cartesian machine: joint i is
+ * Cartesian axis i (mm), extra joints stay at 0.
+ */
 
 #include "kinematics.h"
 #include <string.h>
@@ -10,20 +14,20 @@ static void steps_to_cart_stub(const kin_steps_t *steps, kin_cart_t *out_cart) {
     }
 }
 
-static bool cart_to_joint_stub(const kin_cart_t *cart, kin_joint_t *out_joint) {
-    (void)cart;
-    if (out_joint) {
-        for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) out_joint->v[i] = 0.0f;
+static bool cart_to_joint_identity(const kin_cart_t *cart, kin_joint_t *out_joint) {
+    if (!cart || !out_joint) return false;
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        out_joint->v[i] = (i < KIN_MAX_CART_AXES) ? cart->v[i] : 0.0f;
     }
-    return false;
+    return true;
 }
 
-static bool joint_to_cart_stub(const kin_joint_t *joint, kin_cart_t *out_cart) {
-    (void)joint;
-    if (out_cart) {
-        for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) out_cart->v[i] = 0.0f;
+static bool joint_to_cart_identity(const kin_joint_t *joint, kin_cart_t *out_cart) {
+    if (!joint || !out_cart) return false;
+    for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        out_cart->v[i] = (i < KIN_MAX_JOINT_AXES) ? joint->v[i] : 0.0f;
     }
-    return false;
+    return true;
 }
 
 static bool segment_move_stub(const kin_cart_t *t, const kin_cart_t *c,
@@ -65,14 +69,14 @@ static float homing_feedrate_stub(kin_axis_mask_t axes, float req, kin_home_mode
     return req;
 }
 
-/* Active interface (defaults to safe stubs) */
+/* Active interface (defaults to Cartesian identity + safe stubs) */
 kin_iface_t g_kin = {
     .cart_axes = (uint8_t)KIN_MAX_CART_AXES,
     .joint_axes = (uint8_t)KIN_MAX_JOINT_AXES,
 
     .steps_to_cart = steps_to_cart_stub,
-    .cart_to_joint = cart_to_joint_stub,
-    .joint_to_cart = joint_to_cart_stub,
+    .cart_to_joint = cart_to_joint_identity,
+    .joint_to_cart = joint_to_cart_identity,
     .segment_move = segment_move_stub,
 
     .limit_index_to_axes = limit_index_to_axes_stub,
@@ -90,8 +94,8 @@ void kinematics_install(const kin_iface_t *impl) {
 
     /* Defensive defaults if user left any hooks NULL. */
     if (!g_kin.steps_to_cart)        g_kin.steps_to_cart = steps_to_cart_stub;
-    if (!g_kin.cart_to_joint)        g_kin.cart_to_joint = cart_to_joint_stub;
-    if (!g_kin.joint_to_cart)        g_kin.joint_to_cart = joint_to_cart_stub;
+    if (!g_kin.cart_to_joint)        g_kin.cart_to_joint = cart_to_joint_identity;
+    if (!g_kin.joint_to_cart)        g_kin.joint_to_cart = joint_to_cart_identity;
     if (!g_kin.segment_move)         g_kin.segment_move = segment_move_stub;
     if (!g_kin.limit_index_to_axes)  g_kin.limit_index_to_axes = limit_index_to_axes_stub;
     if (!g_kin.on_limit_trigger)     g_kin.on_limit_trigger = on_limit_trigger_stub;
@@ -24,8 +24,10 @@
 #include <string.h>
 #include <stdio.h>
 #include "firmware_gcode_streamer.h"
+#include "uart_dma_rx.h"
 
 fw_gcode_streamer_t g_streamer;
+uart_dma_rx_t g_uart_dma_rx;
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -44,6 +46,7 @@ fw_gcode_streamer_t g_streamer;
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef hlpuart1;
+DMA_HandleTypeDef hdma_lpuart1_rx;
 
 /* USER CODE BEGIN PV */
 volatile uint8_t rx_byte;
@@ -60,6 +63,7 @@ volatile uint8_t last_char_was_cr = 0;
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_LPUART1_UART_Init(void);
 /* USER CODE BEGIN PFP */
 void shell_process_line(const char *line);
@@ -69,6 +73,7 @@ static void boot_print_banner_and_checks(void);
 static uint8_t boot_check_irq_ok(char *err, size_t err_sz);
 static uint8_t boot_check_usart_ok(char *err, size_t err_sz);
 static uint8_t boot_check_rxit_priming_ok(char *err, size_t err_sz);
+static void uart_rx_dma_start(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -78,6 +83,21 @@ void App_Init(void)
   fw_gcode_streamer_init(&g_streamer);
 }
 
+/* Circular DMA receive; HT, TC and idle-line events all land in
+ * HAL_UARTEx_RxEventCallback with the current write position */
+static void uart_rx_dma_start(void)
+{
+  /* Noise errors leave the receive running; stop it before re-arming */
+  (void)HAL_UART_AbortReceive(&hlpuart1);
+  uart_dma_rx_init(&g_uart_dma_rx);
+  /* ?, !, ~ and Ctrl-X act from the receive callback, ahead of queued lines */
+  uart_dma_rx_set_realtime(&g_uart_dma_rx, fw_gcode_streamer_rx_realtime, &g_streamer);
+  if (HAL_UARTEx_ReceiveToIdle_DMA(&hlpuart1, g_uart_dma_rx.buf, UART_DMA_RX_SIZE) != HAL_OK)
+  {
+    rx_restart_error = 1;
+  }
+}
+
 void shell_send(const char *s)
 {
   HAL_UART_Transmit(&hlpuart1, (uint8_t *)s, (uint16_t)strlen(s), SHELL_TX_TIMEOUT_MS);
@@ -219,6 +239,7 @@ int main(void)
   SystemClock_Config();
 
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_LPUART1_UART_Init();
 
   /* USER CODE BEGIN 2 */
@@ -226,10 +247,11 @@ int main(void)
 
   App_Init();
 
-  /* Start RX interrupt for real (1 byte at a time) */
-  if (HAL_UART_Receive_IT(&hlpuart1, (uint8_t *)&rx_byte, 1) != HAL_OK)
+  /* Start RX for real: DMA into a circular buffer, chunks on idle line */
+  uart_rx_dma_start();
+  if (rx_restart_error)
   {
-    shell_send_line("FATAL: HAL_UART_Receive_IT start failed");
+    shell_send_line("FATAL: HAL_UARTEx_ReceiveToIdle_DMA start failed");
     Error_Handler();
   }
   /* USER CODE END 2 */
@@ -238,15 +260,17 @@ int main(void)
   {
     fw_gcode_streamer_poll(&g_streamer);
 
-    uint8_t out;
-    while (fw_gcode_streamer_tx_pop(&g_streamer, &out))
+    uint8_t out[64];
+    size_t out_len;
+    while ((out_len = fw_gcode_streamer_tx_read(&g_streamer, out, sizeof(out))) > 0u)
     {
-      HAL_UART_Transmit(&hlpuart1, &out, 1, 10);
+      HAL_UART_Transmit(&hlpuart1, out, (uint16_t)out_len, SHELL_TX_TIMEOUT_MS);
     }
 
     if (rx_restart_error)
     {
       rx_restart_error = 0;
+      uart_rx_dma_start();
     }
   }
 }
@@ -319,6 +343,20 @@ static void MX_LPUART1_UART_Init(void)
   }
 }
 
+/**
+  * @brief DMA controller clock and interrupt setup (LPUART1 RX on DMA1 channel 1)
+  * @param None
+  * @retval None
+  */
+static void MX_DMA_Init(void)
+{
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -330,19 +368,22 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
 {
   if (huart->Instance == LPUART1)
   {
-    /* Treat Enter (CR) as newline (LF) for the streamer */
-    if (rx_byte == '\r') rx_byte = '\n';
-
-    fw_gcode_streamer_rx_bytes(&g_streamer, (uint8_t *)&rx_byte, 1);
+    /* Size is the DMA write position in the circular buffer */
+    (void)uart_dma_rx_service(&g_uart_dma_rx, Size, &g_streamer.uart);
+  }
+}
 
-    if (HAL_UART_Receive_IT(&hlpuart1, (uint8_t *)&rx_byte, 1) != HAL_OK)
-    {
-      rx_restart_error = 1;
-    }
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if (huart->Instance == LPUART1)
+  {
+    /* Overrun/noise/framing errors stop the DMA receive: restart it
+     * from the main loop */
+    rx_restart_error = 1;
   }
 }
 /* USER CODE END 4 */
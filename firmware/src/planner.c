@@ -1,169 +1,616 @@
-#include "planner.h"
-#include "protocol.h"
-#include <string.h>
-
-// Initialize a planner block with default values
-void planner_block_init(planner_block_t *block) {
-    if (block == NULL) {
-        return;
-    }
-    
-    // Clear all memory to zero
-    memset(block, 0, sizeof(planner_block_t));
-}
-
-// Validate that a planner block has all required information
-// Returns 1 if valid, 0 if invalid
-int planner_block_validate(const planner_block_t *block) {
-    if (block == NULL) {
-        return 0; // Invalid: NULL pointer
-    }
-    
-    // Check that speeds are non-negative
-    if (block->entry_speed < 0.0f) {
-        return 0; // Invalid: negative entry speed
-    }
-    
-    if (block->nominal_speed < 0.0f) {
-        return 0; // Invalid: negative nominal speed
-    }
-    
-    if (block->exit_speed < 0.0f) {
-        return 0; // Invalid: negative exit speed
-    }
-    
-    // Check that acceleration is non-negative
-    if (block->acceleration < 0.0f) {
-        return 0; // Invalid: negative acceleration
-    }
-    
-    // Check that max_entry_speed is non-negative
-    if (block->max_entry_speed < 0.0f) {
-        return 0; // Invalid: negative max entry speed
-    }
-    
-    // Check that millimeters is non-negative
-    if (block->millimeters < 0.0f) {
-        return 0; // Invalid: negative distance
-    }
-    
-    // Check that entry_speed does not exceed max_entry_speed (if max is set)
-    if (block->max_entry_speed > 0.0f && block->entry_speed > block->max_entry_speed) {
-        return 0; // Invalid: entry speed exceeds maximum
-    }
-    
-    // Check that entry_speed and exit_speed do not exceed nominal_speed
-    if (block->nominal_speed > 0.0f) {
-        if (block->entry_speed > block->nominal_speed) {
-            return 0; // Invalid: entry speed exceeds nominal speed
-        }
-        if (block->exit_speed > block->nominal_speed) {
-            return 0; // Invalid: exit speed exceeds nominal speed
-        }
-    }
-    
-    return 1; // Valid block
-}
-
-// Initialize a planner queue with given capacity
-void planner_queue_init(planner_queue_t *queue, uint32_t capacity) {
-    if (queue == NULL) {
-        return;
-    }
-    
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->size = 0;
-    queue->capacity = capacity;
-}
-
-// Add a new block to the end of the queue
-// Returns 1 on success, 0 on failure (queue full or NULL parameters)
-int planner_enqueue(planner_queue_t *queue, planner_block_t *block) {
-    if (queue == NULL || block == NULL) {
-        return 0;
-    }
-    
-    // Check if queue is full
-    if (queue->capacity > 0 && queue->size >= queue->capacity) {
-        return 0; // Queue is full
-    }
-    
-    // Clear the next pointer of the new block
-    block->next = NULL;
-    
-    if (queue->tail == NULL) {
-        // Queue is empty, set both head and tail to the new block
-        queue->head = block;
-        queue->tail = block;
-    } else {
-        // Add block to the end of the queue
-        queue->tail->next = block;
-        queue->tail = block;
-    }
-    
-    queue->size++;
-    return 1;
-}
-
-// Remove and return the block at the front of the queue
-// Returns pointer to the block on success, NULL if queue is empty
-planner_block_t* planner_dequeue(planner_queue_t *queue) {
-    if (queue == NULL || queue->head == NULL) {
-        return NULL;
-    }
-    
-    planner_block_t *block = queue->head;
-    queue->head = queue->head->next;
-    
-    if (queue->head == NULL) {
-        // Queue is now empty, update tail
-        queue->tail = NULL;
-    }
-    
-    queue->size--;
-    block->next = NULL; // Clear the next pointer
-    return block;
-}
-
-// Peek at the block at the front of the queue without removing it
-// Returns pointer to the front block, NULL if queue is empty
-planner_block_t* planner_peek_front(const planner_queue_t *queue) {
-    if (queue == NULL) {
-        return NULL;
-    }
-    
-    return queue->head;
-}
-
-// Peek at the block at the back of the queue without removing it
-// Returns pointer to the back block, NULL if queue is empty
-planner_block_t* planner_peek_back(const planner_queue_t *queue) {
-    if (queue == NULL) {
-        return NULL;
-    }
-    
-    return queue->tail;
-}
-
-// Check if the queue is empty
-// Returns 1 if empty, 0 if not empty or NULL queue
-int planner_is_empty(const planner_queue_t *queue) {
-    if (queue == NULL) {
-        return 1;
-    }
-    
-    return queue->size == 0;
-}
-
-// Clear the queue, removing all blocks
-// Note: This does not free the blocks themselves, only removes them from the queue
-void planner_queue_clear(planner_queue_t *queue) {
-    if (queue == NULL) {
-        return;
-    }
-    
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->size = 0;
-}
+#include "planner.h"
+#include "profile.h"
+#include "protocol.h"
+#include <string.h>
+#include <math.h>
+
+// Defaults match the serial bridge's grbl settings ($11, $120..$122)
+#define PLANNER_DEFAULT_JUNCTION_DEVIATION_MM 0.010f
+#define PLANNER_DEFAULT_ACCEL_XY_MM_PER_S2    200.0f
+#define PLANNER_DEFAULT_ACCEL_Z_MM_PER_S2     50.0f
+#define PLANNER_DEFAULT_MAX_RATE_XY_MM_PER_MIN 3000.0f
+#define PLANNER_DEFAULT_MAX_RATE_Z_MM_PER_MIN  500.0f
+#define PLANNER_DEFAULT_STEPS_PER_MM          80.0f
+
+#define SECONDS_SQ_PER_MINUTE_SQ 3600.0f
+
+// Initialize a planner block with default values
+void planner_block_init(planner_block_t *block) {
+    if (block == NULL) {
+        return;
+    }
+    
+    // Clear all memory to zero
+    memset(block, 0, sizeof(planner_block_t));
+}
+
+// Validate that a planner block has all required information
+// Returns 1 if valid, 0 if invalid
+int planner_block_validate(const planner_block_t *block) {
+    if (block == NULL) {
+        return 0; // Invalid: NULL pointer
+    }
+    
+    // Check that speeds are non-negative
+    if (block->entry_speed < 0.0f) {
+        return 0; // Invalid: negative entry speed
+    }
+    
+    if (block->nominal_speed < 0.0f) {
+        return 0; // Invalid: negative nominal speed
+    }
+    
+    if (block->exit_speed < 0.0f) {
+        return 0; // Invalid: negative exit speed
+    }
+    
+    // Check that acceleration is non-negative
+    if (block->acceleration < 0.0f) {
+        return 0; // Invalid: negative acceleration
+    }
+    
+    // Check that max_entry_speed is non-negative
+    if (block->max_entry_speed < 0.0f) {
+        return 0; // Invalid: negative max entry speed
+    }
+    
+    // Check that millimeters is non-negative
+    if (block->millimeters < 0.0f) {
+        return 0; // Invalid: negative distance
+    }
+    
+    // Check that entry_speed does not exceed max_entry_speed (if max is set)
+    if (block->max_entry_speed > 0.0f && block->entry_speed > block->max_entry_speed) {
+        return 0; // Invalid: entry speed exceeds maximum
+    }
+    
+    // Check that entry_speed and exit_speed do not exceed nominal_speed
+    if (block->nominal_speed > 0.0f) {
+        if (block->entry_speed > block->nominal_speed) {
+            return 0; // Invalid: entry speed exceeds nominal speed
+        }
+        if (block->exit_speed > block->nominal_speed) {
+            return 0; // Invalid: exit speed exceeds nominal speed
+        }
+    }
+    
+    return 1; // Valid block
+}
+
+// Ring index helpers
+static uint32_t next_index(uint32_t index) {
+    return (index + 1u) & (PLANNER_BUFFER_SIZE - 1u);
+}
+
+static uint32_t prev_index(uint32_t index) {
+    return (index - 1u) & (PLANNER_BUFFER_SIZE - 1u);
+}
+
+// Initialize a planner queue with given capacity
+// A capacity of 0 or above PLANNER_BUFFER_SIZE uses the whole ring
+void planner_queue_init(planner_queue_t *queue, uint32_t capacity) {
+    if (queue == NULL) {
+        return;
+    }
+    
+    queue->head = 0;
+    queue->tail = 0;
+    queue->planned = 0;
+    queue->size = 0;
+    queue->capacity = (capacity == 0 || capacity > PLANNER_BUFFER_SIZE) ? PLANNER_BUFFER_SIZE : capacity;
+    
+    queue->settings.junction_deviation_mm = PLANNER_DEFAULT_JUNCTION_DEVIATION_MM;
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        queue->settings.accel_mm_per_s2[i] = (i < 2) ? PLANNER_DEFAULT_ACCEL_XY_MM_PER_S2
+                                                     : PLANNER_DEFAULT_ACCEL_Z_MM_PER_S2;
+        queue->settings.max_rate_mm_per_min[i] = (i < 2) ? PLANNER_DEFAULT_MAX_RATE_XY_MM_PER_MIN
+                                                         : PLANNER_DEFAULT_MAX_RATE_Z_MM_PER_MIN;
+        queue->prev_unit_vec[i] = 0.0f;
+        queue->position.v[i] = 0.0f;
+    }
+    for (uint32_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        queue->settings.steps_per_mm[i] = PLANNER_DEFAULT_STEPS_PER_MM;
+        queue->position_steps.v[i] = 0;
+    }
+    queue->prev_nominal_speed = 0.0f;
+    queue->ramp.scurve = 0;
+    queue->ramp.jerk_mm_per_s3 = 0.0f;
+}
+
+// Get the next free slot so a block can be built in place
+// The slot is not part of the queue until planner_enqueue() is called with it
+// Returns pointer to the slot, NULL if the queue is full
+planner_block_t* planner_alloc_block(planner_queue_t *queue) {
+    if (queue == NULL || queue->size >= queue->capacity) {
+        return NULL;
+    }
+    
+    return &queue->blocks[queue->tail];
+}
+
+// Add a block to the end of the queue
+// The block is copied into the ring unless it is the slot from planner_alloc_block()
+// Returns 1 on success, 0 on failure (queue full or NULL parameters)
+int planner_enqueue(planner_queue_t *queue, const planner_block_t *block) {
+    if (queue == NULL || block == NULL) {
+        return 0;
+    }
+    
+    // Check if queue is full
+    if (queue->size >= queue->capacity) {
+        return 0; // Queue is full
+    }
+    
+    planner_block_t *slot = &queue->blocks[queue->tail];
+    if (slot != block) {
+        *slot = *block;
+    }
+    
+    if (queue->size == 0) {
+        queue->planned = queue->tail;
+    }
+    queue->tail = next_index(queue->tail);
+    queue->size++;
+    return 1;
+}
+
+// Remove and return the block at the front of the queue
+// The returned slot stays valid until a later enqueue reuses it
+// Returns pointer to the block on success, NULL if queue is empty
+planner_block_t* planner_dequeue(planner_queue_t *queue) {
+    if (queue == NULL || queue->size == 0) {
+        return NULL;
+    }
+    
+    planner_block_t *block = &queue->blocks[queue->head];
+    planner_discard_front(queue);
+    return block;
+}
+
+// Drop the front block once it has been fully executed
+void planner_discard_front(planner_queue_t *queue) {
+    if (queue == NULL || queue->size == 0) {
+        return;
+    }
+    
+    if (queue->planned == queue->head) {
+        queue->planned = next_index(queue->head);
+    }
+    queue->head = next_index(queue->head);
+    queue->size--;
+}
+
+// Peek at the block at the front of the queue without removing it
+// Returns pointer to the front block, NULL if queue is empty
+planner_block_t* planner_peek_front(const planner_queue_t *queue) {
+    if (queue == NULL || queue->size == 0) {
+        return NULL;
+    }
+    
+    return (planner_block_t *)&queue->blocks[queue->head];
+}
+
+// Peek at the block at the back of the queue without removing it
+// Returns pointer to the back block, NULL if queue is empty
+planner_block_t* planner_peek_back(const planner_queue_t *queue) {
+    if (queue == NULL || queue->size == 0) {
+        return NULL;
+    }
+    
+    return (planner_block_t *)&queue->blocks[prev_index(queue->tail)];
+}
+
+// Check if the queue is empty
+// Returns 1 if empty, 0 if not empty or NULL queue
+int planner_is_empty(const planner_queue_t *queue) {
+    if (queue == NULL) {
+        return 1;
+    }
+    
+    return queue->size == 0;
+}
+
+// Clear the queue, removing all blocks
+// Look-ahead history is kept; the next block still starts from rest
+void planner_queue_clear(planner_queue_t *queue) {
+    if (queue == NULL) {
+        return;
+    }
+    
+    queue->head = 0;
+    queue->tail = 0;
+    queue->planned = 0;
+    queue->size = 0;
+}
+
+// ===== Look-ahead =====
+
+// Replace the junction deviation and per-axis acceleration limits
+void planner_set_settings(planner_queue_t *queue, const planner_settings_t *settings) {
+    if (queue == NULL || settings == NULL) {
+        return;
+    }
+    
+    queue->settings = *settings;
+}
+
+// Replace the ramp shape; takes effect for blocks planned from now on
+void planner_set_ramp(planner_queue_t *queue, const planner_ramp_t *ramp) {
+    if (queue == NULL || ramp == NULL) {
+        return;
+    }
+    
+    queue->ramp = *ramp;
+}
+
+// The S-curve (smoothstep) peaks at 1.5x its mean acceleration and has jerk
+// 6 dv / T^2 at its ends; its ramps stretch until both are within limits
+float planner_ramp_time(const planner_ramp_t *ramp, float accel, float dv) {
+    if (!ramp->scurve) {
+        return dv / accel;
+    }
+    float t = 1.5f * dv / accel;
+    if (ramp->jerk_mm_per_s3 > 0.0f) {
+        float t_jerk = sqrtf(6.0f * dv / ramp->jerk_mm_per_s3);
+        if (t_jerk > t) {
+            t = t_jerk;
+        }
+    }
+    return t;
+}
+
+// Both shapes cover half the speed change on top of the starting speed
+float planner_ramp_mm(const planner_ramp_t *ramp, float accel, float va, float vb) {
+    return 0.5f * (va + vb) * planner_ramp_time(ramp, accel, fabsf(vb - va));
+}
+
+// Largest acceleration (mm/min^2) along a unit vector that keeps every axis
+// within its own limit
+static float limit_accel_by_axis(const planner_settings_t *settings,
+                                 const float unit_vec[KIN_MAX_CART_AXES]) {
+    float limit = 0.0f;
+    
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        float component = fabsf(unit_vec[i]);
+        if (component > 0.0f) {
+            float axis_limit = settings->accel_mm_per_s2[i] / component;
+            if (limit == 0.0f || axis_limit < limit) {
+                limit = axis_limit;
+            }
+        }
+    }
+    
+    return limit * SECONDS_SQ_PER_MINUTE_SQ;
+}
+
+// Highest speed from which the block can reach target_speed over distance_mm
+// (acceleration in mm/min^2, speeds in mm/min) with the queue's ramps
+static float max_allowable_speed(const planner_ramp_t *ramp, float acceleration,
+                                 float target_speed, float distance_mm) {
+    float mean_accel = ramp->scurve ? acceleration / 1.5f : acceleration;
+    float speed = sqrtf(target_speed * target_speed + 2.0f * mean_accel * distance_mm);
+    if (!ramp->scurve || ramp->jerk_mm_per_s3 <= 0.0f) {
+        return speed;
+    }
+    
+    // Jerk-limited ramps have no closed form: bisect in mm/s
+    float accel = acceleration / SECONDS_SQ_PER_MINUTE_SQ;
+    float target = target_speed / 60.0f;
+    float lo = target;
+    float hi = speed / 60.0f;
+    if (planner_ramp_mm(ramp, accel, hi, target) <= distance_mm) {
+        return speed;
+    }
+    for (int i = 0; i < 20; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (planner_ramp_mm(ramp, accel, mid, target) <= distance_mm) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo * 60.0f;
+}
+
+// Fill in length, acceleration and junction entry limit for a block moving
+// by delta_mm, then enqueue it and replan the queue.
+// The caller sets nominal_speed (mm/min) and the step fields beforehand;
+// src may be the slot returned by planner_alloc_block().
+// Returns 1 on success, 0 on failure (NULL parameters, zero length or queue full)
+int planner_plan_block(planner_queue_t *queue, const planner_block_t *src,
+                       const float delta_mm[KIN_MAX_CART_AXES]) {
+    if (queue == NULL || src == NULL || delta_mm == NULL) {
+        return 0;
+    }
+    
+    // Plan straight into the free slot
+    planner_block_t *block = planner_alloc_block(queue);
+    if (block == NULL) {
+        return 0; // Queue is full
+    }
+    if (block != src) {
+        *block = *src;
+    }
+    
+    float length_sq = 0.0f;
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        length_sq += delta_mm[i] * delta_mm[i];
+    }
+    if (length_sq <= 0.0f) {
+        return 0; // Nothing to move
+    }
+    
+    float unit_vec[KIN_MAX_CART_AXES];
+    float inv_length = 1.0f / sqrtf(length_sq);
+    block->millimeters = sqrtf(length_sq);
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        unit_vec[i] = delta_mm[i] * inv_length;
+    }
+    
+    block->acceleration = limit_accel_by_axis(&queue->settings, unit_vec);
+    
+    // Junction speed with the previous block. Starting from an empty queue
+    // means starting from rest.
+    float max_entry = 0.0f;
+    if (queue->size > 0) {
+        // Cosine of the angle between the two moves, flipped so that
+        // 1 is a full reversal and -1 is a straight continuation
+        float cos_theta = 0.0f;
+        for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+            cos_theta -= queue->prev_unit_vec[i] * unit_vec[i];
+        }
+        
+        if (cos_theta > 0.999999f) {
+            max_entry = PLANNER_MIN_JUNCTION_SPEED;
+        } else if (cos_theta < -0.999999f) {
+            max_entry = block->nominal_speed; // Collinear: no junction limit
+        } else {
+            // Centripetal acceleration along the junction, limited per axis
+            float junction_vec[KIN_MAX_CART_AXES];
+            float junction_len_sq = 0.0f;
+            for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+                junction_vec[i] = unit_vec[i] - queue->prev_unit_vec[i];
+                junction_len_sq += junction_vec[i] * junction_vec[i];
+            }
+            float inv_junction_len = 1.0f / sqrtf(junction_len_sq);
+            for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+                junction_vec[i] *= inv_junction_len;
+            }
+            float junction_accel = limit_accel_by_axis(&queue->settings, junction_vec);
+            
+            float sin_theta_d2 = sqrtf(0.5f * (1.0f - cos_theta));
+            float v_sq = junction_accel * queue->settings.junction_deviation_mm *
+                         sin_theta_d2 / (1.0f - sin_theta_d2);
+            max_entry = sqrtf(v_sq);
+            if (max_entry < PLANNER_MIN_JUNCTION_SPEED) {
+                max_entry = PLANNER_MIN_JUNCTION_SPEED;
+            }
+        }
+        
+        if (max_entry > queue->prev_nominal_speed) {
+            max_entry = queue->prev_nominal_speed;
+        }
+    }
+    if (max_entry > block->nominal_speed) {
+        max_entry = block->nominal_speed;
+    }
+    
+    block->max_entry_speed = max_entry;
+    block->entry_speed = 0.0f;
+    block->exit_speed = 0.0f;
+    block->recalculate_flag = 1;
+    
+    // Block can stop from nominal speed within its own length: the backward
+    // pass never needs to limit its entry below max_entry_speed
+    block->nominal_length_flag =
+        (block->nominal_speed <= max_allowable_speed(&queue->ramp, block->acceleration, 0.0f, block->millimeters));
+    
+    if (!planner_enqueue(queue, block)) {
+        return 0;
+    }
+    
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        queue->prev_unit_vec[i] = unit_vec[i];
+    }
+    queue->prev_nominal_speed = block->nominal_speed;
+    
+    planner_recalculate(queue);
+    return 1;
+}
+
+// Replan entry and exit speeds from the newest block back to the planned index.
+// Blocks before queue->planned are already optimal; the front block may be
+// executing, so planned never points before it and its entry is left as is.
+void planner_recalculate(planner_queue_t *queue) {
+    if (queue == NULL || queue->size == 0) {
+        return;
+    }
+    
+    uint32_t last = prev_index(queue->tail);
+    
+    // Backward pass: the newest block must be able to stop, every block must
+    // be able to decelerate to its successor's entry speed
+    uint32_t index = last;
+    float next_entry = 0.0f;
+    while (index != queue->planned) {
+        planner_block_t *current = &queue->blocks[index];
+        if (current->entry_speed != current->max_entry_speed || index == last) {
+            if (!current->nominal_length_flag && current->max_entry_speed > next_entry) {
+                float limit = max_allowable_speed(&queue->ramp, current->acceleration, next_entry,
+                                                  current->millimeters);
+                current->entry_speed = (limit < current->max_entry_speed) ? limit : current->max_entry_speed;
+            } else {
+                current->entry_speed = current->max_entry_speed;
+            }
+            current->recalculate_flag = 1;
+        }
+        next_entry = current->entry_speed;
+        index = prev_index(index);
+    }
+    
+    // Forward pass: a block cannot enter faster than its predecessor can
+    // accelerate to. Blocks fixed by acceleration or at their junction limit
+    // can no longer improve, so planned moves past them.
+    index = queue->planned;
+    while (index != last) {
+        planner_block_t *previous = &queue->blocks[index];
+        uint32_t next = next_index(index);
+        planner_block_t *current = &queue->blocks[next];
+        if (previous->entry_speed < current->entry_speed) {
+            float limit = max_allowable_speed(&queue->ramp, previous->acceleration, previous->entry_speed,
+                                              previous->millimeters);
+            if (limit < current->entry_speed) {
+                current->entry_speed = limit;
+                current->recalculate_flag = 1;
+                queue->planned = next;
+            }
+        }
+        if (current->entry_speed == current->max_entry_speed) {
+            queue->planned = next;
+        }
+        
+        // Exit speed of each block is the entry speed of the next
+        previous->exit_speed = current->entry_speed;
+        previous->recalculate_flag = 0;
+        index = next;
+    }
+    queue->blocks[last].exit_speed = 0.0f;
+    queue->blocks[last].recalculate_flag = 0;
+}
+
+// Nominal speed for a move along unit_vec: the requested feed (or the max
+// rate for rapids), limited so no axis exceeds its own max rate
+static float limit_speed_by_axis(const planner_settings_t *settings,
+                                 const float unit_vec[KIN_MAX_CART_AXES],
+                                 const planner_line_data_t *data) {
+    float speed = (!data->rapid && data->feed_rate > 0.0f) ? data->feed_rate : 0.0f;
+    
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        float component = fabsf(unit_vec[i]);
+        if (component > 0.0f && settings->max_rate_mm_per_min[i] > 0.0f) {
+            float axis_limit = settings->max_rate_mm_per_min[i] / component;
+            if (speed == 0.0f || axis_limit < speed) {
+                speed = axis_limit;
+            }
+        }
+    }
+    
+    return speed;
+}
+
+// Queue a straight move from the end of the queue to a Cartesian target.
+// The target goes through kinematics_cart_to_steps(), which rounds to absolute
+// joint steps, so rounding never accumulates across segments.
+static planner_line_status_t line_to(planner_queue_t *queue, const kin_cart_t *target,
+                                     const planner_line_data_t *data) {
+    if (queue == NULL || target == NULL || data == NULL) {
+        return PLANNER_LINE_INVALID;
+    }
+    if (queue->size >= queue->capacity) {
+        return PLANNER_LINE_FULL;
+    }
+    
+    kin_steps_t target_steps;
+    if (!kinematics_cart_to_steps(target, queue->settings.steps_per_mm, &target_steps)) {
+        return PLANNER_LINE_INVALID;
+    }
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    for (uint32_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        int32_t diff = target_steps.v[i] - queue->position_steps.v[i];
+        block.steps[i] = (uint32_t)((diff < 0) ? -diff : diff);
+        if (diff >= 0) {
+            block.direction_bits |= (uint8_t)(1u << i);
+        }
+        if (block.steps[i] > block.step_event_count) {
+            block.step_event_count = block.steps[i];
+        }
+    }
+    
+    // Shorter than a step: nothing to queue. The Cartesian position stays
+    // put so the distance carries into the next move.
+    if (block.step_event_count == 0) {
+        return PLANNER_LINE_OK;
+    }
+    
+    float delta_mm[KIN_MAX_CART_AXES];
+    float length_sq = 0.0f;
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        delta_mm[i] = target->v[i] - queue->position.v[i];
+        length_sq += delta_mm[i] * delta_mm[i];
+    }
+    if (length_sq <= 0.0f) {
+        return PLANNER_LINE_INVALID;
+    }
+    
+    float unit_vec[KIN_MAX_CART_AXES];
+    float inv_length = 1.0f / sqrtf(length_sq);
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        unit_vec[i] = delta_mm[i] * inv_length;
+    }
+    block.nominal_speed = limit_speed_by_axis(&queue->settings, unit_vec, data);
+    if (block.nominal_speed <= 0.0f) {
+        return PLANNER_LINE_INVALID;
+    }
+    const planner_line_data_t rapid = { .feed_rate = 0.0f, .rapid = 1u };
+    block.rapid_rate = limit_speed_by_axis(&queue->settings, unit_vec, &rapid);
+    block.rapid_flag = data->rapid ? 1u : 0u;
+    block.spindle_speed = data->spindle_speed;
+    block.spindle_dir = data->spindle_dir;
+    
+    if (!planner_plan_block(queue, &block, delta_mm)) {
+        return PLANNER_LINE_INVALID;
+    }
+    
+    queue->position_steps = target_steps;
+    queue->position = *target;
+    return PLANNER_LINE_OK;
+}
+
+planner_line_status_t planner_line_to(planner_queue_t *queue, const kin_cart_t *target,
+                                      const planner_line_data_t *data) {
+    PROFILE_BEGIN(t0);
+    planner_line_status_t st = line_to(queue, target, data);
+    if (st != PLANNER_LINE_FULL) {
+        PROFILE_END(PROFILE_ZONE_PLAN, t0);
+    }
+    return st;
+}
+
+// Redefine the end-of-queue position without moving (origin reset, homing)
+void planner_set_position(planner_queue_t *queue, const kin_cart_t *position) {
+    if (queue == NULL || position == NULL) {
+        return;
+    }
+    
+    kin_steps_t steps;
+    if (!kinematics_cart_to_steps(position, queue->settings.steps_per_mm, &steps)) {
+        return;
+    }
+    queue->position_steps = steps;
+    queue->position = *position;
+}
+
+// Resync the end-of-queue position to executed steps (after an abort)
+void planner_sync_position(planner_queue_t *queue, const kin_steps_t *steps) {
+    if (queue == NULL || steps == NULL) {
+        return;
+    }
+    
+    kin_joint_t joint;
+    for (uint32_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        float steps_per_mm = queue->settings.steps_per_mm[i];
+        joint.v[i] = (steps_per_mm > 0.0f) ? ((float)steps->v[i] / steps_per_mm) : 0.0f;
+    }
+    queue->position_steps = *steps;
+    (void)kinematics_joint_to_cart(&joint, &queue->position);
+}
+
+void planner_get_position(const planner_queue_t *queue, kin_cart_t *out_position) {
+    if (queue == NULL || out_position == NULL) {
+        return;
+    }
+    
+    *out_position = queue->position;
+}
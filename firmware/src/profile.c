@@ -0,0 +1,41 @@
+/* profile.c - Hot-path cycle profiling zones */
+
+#include "profile.h"
+
+#if GRBL_FEATURE_PROFILE
+
+#include <string.h>
+
+static profile_stats_t s_zones[PROFILE_ZONE_COUNT];
+
+static const char *const s_zone_names[PROFILE_ZONE_COUNT] = {
+    "rx_feed", "framing", "parse", "plan", "segment_prep", "step_isr",
+};
+
+void profile_record(profile_zone_t zone, uint32_t cycles) {
+    if ((unsigned)zone >= PROFILE_ZONE_COUNT) return;
+    profile_stats_t *z = &s_zones[zone];
+    if (z->count == 0u || cycles < z->min_cycles) z->min_cycles = cycles;
+    if (cycles > z->max_cycles) z->max_cycles = cycles;
+    z->total_cycles += cycles;
+    z->count++;
+}
+
+void profile_reset(void) {
+    memset(s_zones, 0, sizeof(s_zones));
+}
+
+void profile_get(profile_zone_t zone, profile_stats_t *out) {
+    if (!out) return;
+    if ((unsigned)zone >= PROFILE_ZONE_COUNT) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = s_zones[zone];
+}
+
+const char *profile_zone_name(profile_zone_t zone) {
+    return ((unsigned)zone < PROFILE_ZONE_COUNT) ? s_zone_names[zone] : "?";
+}
+
+#endif /* GRBL_FEATURE_PROFILE */
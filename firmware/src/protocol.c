@@ -1,6 +1,7 @@
 /* protocol.c */
 
 #include "protocol.h"
+#include "profile.h"
 #include <string.h>
 
 /* ---- helpers ---- */
@@ -19,8 +20,10 @@ static void queue_push(protocol_t *p, const char *line, proto_line_status_t st)
         /* Drop oldest (or newest). Here: drop newest by ignoring push. */
         return;
     }
-    strncpy(p->q[p->q_tail], line, PROTOCOL_LINE_MAX);
-    p->q[p->q_tail][PROTOCOL_LINE_MAX] = '\0';
+    size_t n = strlen(line);
+    if (n > PROTOCOL_LINE_MAX) n = PROTOCOL_LINE_MAX;
+    memcpy(p->q[p->q_tail], line, n);
+    p->q[p->q_tail][n] = '\0';
     p->qst[p->q_tail] = st;
 
     p->q_tail = (uint8_t)((p->q_tail + 1u) % PROTOCOL_LINE_QUEUE_DEPTH);
@@ -31,8 +34,10 @@ static bool queue_pop(protocol_t *p, char *out, size_t out_cap, proto_line_statu
     if (p->q_count == 0u) return false;
 
     if (out && out_cap) {
-        strncpy(out, p->q[p->q_head], out_cap - 1u);
-        out[out_cap - 1u] = '\0';
+        size_t n = strlen(p->q[p->q_head]);
+        if (n > out_cap - 1u) n = out_cap - 1u;
+        memcpy(out, p->q[p->q_head], n);
+        out[n] = '\0';
     }
     if (st) *st = p->qst[p->q_head];
 
@@ -135,19 +140,18 @@ void protocol_reset(protocol_t *p) {
 
 void protocol_feed_bytes(protocol_t *p, const uint8_t *data, size_t len) {
     if (!p || !data) return;
+    PROFILE_BEGIN(t0);
 
     for (size_t i = 0; i < len; i++) {
         uint8_t c = data[i];
 
         /* ---- realtime commands (handled immediately) ---- */
-        if (c == 0x18u) { /* Ctrl-X soft reset */
-            emit_rt(p, PROTO_RT_RESET);
-            protocol_reset(p);
+        proto_rt_cmd_t rt = protocol_rt_classify(c);
+        if (rt != PROTO_RT_NONE) {
+            emit_rt(p, rt);
+            if (rt == PROTO_RT_RESET) protocol_reset(p);
             continue;
         }
-        if (c == (uint8_t)'?') { emit_rt(p, PROTO_RT_STATUS_QUERY); continue; }
-        if (c == (uint8_t)'!') { emit_rt(p, PROTO_RT_FEED_HOLD);    continue; }
-        if (c == (uint8_t)'~') { emit_rt(p, PROTO_RT_CYCLE_START);  continue; }
 
         /* ---- line termination ---- */
         if (c == '\n') {
@@ -199,6 +203,7 @@ void protocol_feed_bytes(protocol_t *p, const uint8_t *data, size_t len) {
             p->cur_overflow = true; /* keep consuming until newline, then report overflow */
         }
     }
+    PROFILE_END(PROFILE_ZONE_RX_FEED, t0);
 }
 
 bool protocol_pop_line(protocol_t *p, char *out, size_t out_cap, proto_line_status_t *st) {
@@ -210,3 +215,68 @@ bool protocol_has_line(const protocol_t *p) {
     if (!p) return false;
     return (p->q_count != 0u);
 }
+
+proto_rt_cmd_t protocol_rt_classify(uint8_t c) {
+    switch (c) {
+        case 0x18u:         return PROTO_RT_RESET;        /* Ctrl-X soft reset */
+        case (uint8_t)'?':  return PROTO_RT_STATUS_QUERY;
+        case (uint8_t)'!':  return PROTO_RT_FEED_HOLD;
+        case (uint8_t)'~':  return PROTO_RT_CYCLE_START;
+        case 0x90u:         return PROTO_RT_FEED_OVR_RESET;
+        case 0x91u:         return PROTO_RT_FEED_OVR_COARSE_PLUS;
+        case 0x92u:         return PROTO_RT_FEED_OVR_COARSE_MINUS;
+        case 0x93u:         return PROTO_RT_FEED_OVR_FINE_PLUS;
+        case 0x94u:         return PROTO_RT_FEED_OVR_FINE_MINUS;
+        case 0x95u:         return PROTO_RT_RAPID_OVR_RESET;
+        case 0x96u:         return PROTO_RT_RAPID_OVR_MEDIUM;
+        case 0x97u:         return PROTO_RT_RAPID_OVR_LOW;
+        case 0x99u:         return PROTO_RT_SPINDLE_OVR_RESET;
+        case 0x9Au:         return PROTO_RT_SPINDLE_OVR_COARSE_PLUS;
+        case 0x9Bu:         return PROTO_RT_SPINDLE_OVR_COARSE_MINUS;
+        case 0x9Cu:         return PROTO_RT_SPINDLE_OVR_FINE_PLUS;
+        case 0x9Du:         return PROTO_RT_SPINDLE_OVR_FINE_MINUS;
+        default:            return PROTO_RT_NONE;
+    }
+}
+
+bool protocol_rt_is_override(proto_rt_cmd_t cmd) {
+    return cmd >= PROTO_RT_FEED_OVR_RESET && cmd <= PROTO_RT_SPINDLE_OVR_FINE_MINUS;
+}
+
+void protocol_overrides_init(proto_overrides_t *ovr) {
+    if (!ovr) return;
+    ovr->feed = PROTO_OVR_DEFAULT;
+    ovr->rapid = PROTO_OVR_DEFAULT;
+    ovr->spindle = PROTO_OVR_DEFAULT;
+}
+
+static uint8_t step_percent(uint8_t value, int delta, uint8_t min, uint8_t max) {
+    int v = (int)value + delta;
+    if (v < (int)min) v = (int)min;
+    if (v > (int)max) v = (int)max;
+    return (uint8_t)v;
+}
+
+bool protocol_apply_override(proto_overrides_t *ovr, proto_rt_cmd_t cmd) {
+    if (!ovr) return false;
+    proto_overrides_t old = *ovr;
+
+    switch (cmd) {
+        case PROTO_RT_FEED_OVR_RESET:           ovr->feed = PROTO_OVR_DEFAULT; break;
+        case PROTO_RT_FEED_OVR_COARSE_PLUS:     ovr->feed = step_percent(ovr->feed, 10, PROTO_OVR_FEED_MIN, PROTO_OVR_FEED_MAX); break;
+        case PROTO_RT_FEED_OVR_COARSE_MINUS:    ovr->feed = step_percent(ovr->feed, -10, PROTO_OVR_FEED_MIN, PROTO_OVR_FEED_MAX); break;
+        case PROTO_RT_FEED_OVR_FINE_PLUS:       ovr->feed = step_percent(ovr->feed, 1, PROTO_OVR_FEED_MIN, PROTO_OVR_FEED_MAX); break;
+        case PROTO_RT_FEED_OVR_FINE_MINUS:      ovr->feed = step_percent(ovr->feed, -1, PROTO_OVR_FEED_MIN, PROTO_OVR_FEED_MAX); break;
+        case PROTO_RT_RAPID_OVR_RESET:          ovr->rapid = PROTO_OVR_DEFAULT; break;
+        case PROTO_RT_RAPID_OVR_MEDIUM:         ovr->rapid = PROTO_OVR_RAPID_MEDIUM; break;
+        case PROTO_RT_RAPID_OVR_LOW:            ovr->rapid = PROTO_OVR_RAPID_LOW; break;
+        case PROTO_RT_SPINDLE_OVR_RESET:        ovr->spindle = PROTO_OVR_DEFAULT; break;
+        case PROTO_RT_SPINDLE_OVR_COARSE_PLUS:  ovr->spindle = step_percent(ovr->spindle, 10, PROTO_OVR_SPINDLE_MIN, PROTO_OVR_SPINDLE_MAX); break;
+        case PROTO_RT_SPINDLE_OVR_COARSE_MINUS: ovr->spindle = step_percent(ovr->spindle, -10, PROTO_OVR_SPINDLE_MIN, PROTO_OVR_SPINDLE_MAX); break;
+        case PROTO_RT_SPINDLE_OVR_FINE_PLUS:    ovr->spindle = step_percent(ovr->spindle, 1, PROTO_OVR_SPINDLE_MIN, PROTO_OVR_SPINDLE_MAX); break;
+        case PROTO_RT_SPINDLE_OVR_FINE_MINUS:   ovr->spindle = step_percent(ovr->spindle, -1, PROTO_OVR_SPINDLE_MIN, PROTO_OVR_SPINDLE_MAX); break;
+        default:                                return false;
+    }
+
+    return ovr->feed != old.feed || ovr->rapid != old.rapid || ovr->spindle != old.spindle;
+}
@@ -1,5 +1,5 @@
-#include "serial_gcode_bridge.h"
-
+#include "serial_gcode_bridge.h"
+
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
@@ -7,14 +7,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
-
+
+#include "arc.h"
 #include "cnc_hal.h"
+#include "isr_latency.h"
+#include "profile.h"
 
 static const char FW_IDENTITY[] = "[FW:STM32G4 CNC_machine_Proj]";
 enum { WCS_COUNT = 6 };
 static const char *WCS_NAMES[WCS_COUNT] = {"G54", "G55", "G56", "G57", "G58", "G59"};
 static const size_t SETTING_ID_BUF_SIZE = 8u;
 
+/* serial_gcode_bridge_t.rt_pending bits */
+enum {
+    BRIDGE_RT_STATUS = 1u << 0,
+    BRIDGE_RT_HOLD = 1u << 1,
+    BRIDGE_RT_RESUME = 1u << 2,
+    BRIDGE_RT_RESET = 1u << 3,
+};
+
 typedef enum {
     SETTING_U32 = 0,
     SETTING_BOOL,
@@ -70,6 +81,7 @@ static bool setting_type_for_id(uint32_t id, setting_type_t *type) {
         case 20u:
         case 21u:
         case 22u:
+        case 32u:
             *type = SETTING_BOOL;
             return true;
         case 11u:
@@ -133,6 +145,7 @@ static bool get_setting_value(const serial_gcode_bridge_t *bridge, uint32_t id,
         case 27u: *out_f = bridge->settings.homing_pull_off_mm; return true;
         case 30u: *out_u = bridge->settings.spindle_max_rpm; return true;
         case 31u: *out_u = bridge->settings.spindle_min_rpm; return true;
+        case 32u: *out_b = bridge->settings.laser_mode; return true;
         case 100u: *out_f = bridge->steps_per_mm[HAL_AXIS_X]; return true;
         case 101u: *out_f = bridge->steps_per_mm[HAL_AXIS_Y]; return true;
         case 102u: *out_f = bridge->steps_per_mm[HAL_AXIS_Z]; return true;
@@ -174,7 +187,12 @@ static bool set_setting_value(serial_gcode_bridge_t *bridge, uint32_t id, const
         case 6u: bridge->settings.probe_pin_invert = b; return true;
         case 10u: bridge->settings.status_report_mask = u32; return true;
         case 11u: bridge->settings.junction_deviation_mm = f; return true;
-        case 12u: bridge->settings.arc_tolerance_mm = f; return true;
+        case 12u:
+            if (!arc_set_tolerance_mm(f)) {
+                return false;
+            }
+            bridge->settings.arc_tolerance_mm = f;
+            return true;
         case 13u: bridge->settings.report_inches = b; return true;
         case 20u: bridge->settings.soft_limits_enable = b; return true;
         case 21u: bridge->settings.hard_limits_enable = b; return true;
@@ -186,6 +204,7 @@ static bool set_setting_value(serial_gcode_bridge_t *bridge, uint32_t id, const
         case 27u: bridge->settings.homing_pull_off_mm = f; return true;
         case 30u: bridge->settings.spindle_max_rpm = u32; return true;
         case 31u: bridge->settings.spindle_min_rpm = u32; return true;
+        case 32u: bridge->settings.laser_mode = b; return true;
         case 100u: bridge->steps_per_mm[HAL_AXIS_X] = f; return true;
         case 101u: bridge->steps_per_mm[HAL_AXIS_Y] = f; return true;
         case 102u: bridge->steps_per_mm[HAL_AXIS_Z] = f; return true;
@@ -238,7 +257,7 @@ static void write_settings_dump(const serial_gcode_bridge_t *bridge, char *respo
         0u, 1u, 2u, 3u, 4u, 5u, 6u,
         10u, 11u, 12u, 13u,
         20u, 21u, 22u, 23u, 24u, 25u, 26u, 27u,
-        30u, 31u,
+        30u, 31u, 32u,
         100u, 101u, 102u,
         110u, 111u, 112u,
         120u, 121u, 122u,
@@ -306,123 +325,334 @@ static const char *current_distance_word(const serial_gcode_bridge_t *bridge) {
 }
 
 static bool line_is_simple_cmd(const char *line, const char *cmd) {
-    if (!line || !cmd) {
-        return false;
-    }
-
-    while (*line && isspace((unsigned char)*line)) {
-        line++;
-    }
-
-    size_t idx = 0;
-    while (cmd[idx] != '\0') {
-        if (toupper((unsigned char)line[idx]) != cmd[idx]) {
-            return false;
-        }
-        idx++;
-    }
-
-    while (line[idx] && isspace((unsigned char)line[idx])) {
-        idx++;
-    }
-
-    return line[idx] == '\0';
-}
-
-static void wait_us(uint32_t delay_us) {
-    const uint32_t start = hal_micros();
-    while ((uint32_t)(hal_micros() - start) < delay_us) {
-        hal_poll();
-    }
-}
-
-static void clear_axes_by_mask(uint32_t axis_mask) {
-    for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
-        if ((axis_mask & (1u << axis)) != 0u) {
-            hal_stepper_step_clear(axis);
-        }
-    }
-}
-
-static bool drive_xy_motion(serial_gcode_bridge_t *bridge,
-                            float start_x,
-                            float start_y,
-                            float end_x,
-                            float end_y) {
-    const float dx = end_x - start_x;
-    const float dy = end_y - start_y;
-
-    const uint32_t x_steps = (uint32_t)lroundf(fabsf(dx) * bridge->steps_per_mm[HAL_AXIS_X]);
-    const uint32_t y_steps = (uint32_t)lroundf(fabsf(dy) * bridge->steps_per_mm[HAL_AXIS_Y]);
-
-    if (x_steps == 0u && y_steps == 0u) {
-        return true;
-    }
-
-    hal_stepper_enable(true);
-    hal_stepper_set_dir(HAL_AXIS_X, dx >= 0.0f);
-    hal_stepper_set_dir(HAL_AXIS_Y, dy >= 0.0f);
-
-    if (x_steps >= y_steps) {
-        uint32_t err = x_steps / 2u;
-        for (uint32_t i = 0; i < x_steps; i++) {
-            uint32_t pulse_mask = (1u << HAL_AXIS_X);
-
-            err += y_steps;
-            const bool pulse_y = (err >= x_steps && y_steps > 0u);
-            if (pulse_y) {
-                pulse_mask |= (1u << HAL_AXIS_Y);
-                err -= x_steps;
-            }
-
-            hal_stepper_pulse_mask(pulse_mask);
-            wait_us(bridge->step_pulse_delay_us);
-            clear_axes_by_mask(pulse_mask);
-
-            hal_poll();
-            hal_inputs_t inputs;
-            hal_read_inputs(&inputs);
-            if (inputs.estop || inputs.limit_x || inputs.limit_y || inputs.limit_z) {
-                hal_stepper_enable(false);
-                return false;
-            }
-        }
-    } else {
-        uint32_t err = y_steps / 2u;
-        for (uint32_t i = 0; i < y_steps; i++) {
-            uint32_t pulse_mask = (1u << HAL_AXIS_Y);
-
-            err += x_steps;
-            const bool pulse_x = (err >= y_steps && x_steps > 0u);
-            if (pulse_x) {
-                pulse_mask |= (1u << HAL_AXIS_X);
-                err -= y_steps;
-            }
-
-            hal_stepper_pulse_mask(pulse_mask);
-            wait_us(bridge->step_pulse_delay_us);
-            clear_axes_by_mask(pulse_mask);
-
-            hal_poll();
-            hal_inputs_t inputs;
-            hal_read_inputs(&inputs);
-            if (inputs.estop || inputs.limit_x || inputs.limit_y || inputs.limit_z) {
-                hal_stepper_enable(false);
-                return false;
-            }
-        }
-    }
-
-    return true;
-}
-
+    if (!line || !cmd) {
+        return false;
+    }
+
+    while (*line && isspace((unsigned char)*line)) {
+        line++;
+    }
+
+    size_t idx = 0;
+    while (cmd[idx] != '\0') {
+        if (toupper((unsigned char)line[idx]) != cmd[idx]) {
+            return false;
+        }
+        idx++;
+    }
+
+    while (line[idx] && isspace((unsigned char)line[idx])) {
+        idx++;
+    }
+
+    return line[idx] == '\0';
+}
+
+static bool safety_input_active(void) {
+    hal_inputs_t inputs;
+    hal_read_inputs(&inputs);
+    return inputs.estop || inputs.limit_x || inputs.limit_y || inputs.limit_z;
+}
+
+static void apply_motion_settings(serial_gcode_bridge_t *bridge) {
+    planner_settings_t planner_settings;
+    planner_settings.junction_deviation_mm = bridge->settings.junction_deviation_mm;
+    for (uint32_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        planner_settings.accel_mm_per_s2[i] = bridge->settings.accel_mm_per_s2[i];
+        planner_settings.max_rate_mm_per_min[i] = bridge->settings.max_rate_mm_per_min[i];
+    }
+    for (uint32_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        planner_settings.steps_per_mm[i] = (i < HAL_AXIS_MAX) ? bridge->steps_per_mm[i] : 0.0f;
+    }
+    planner_set_settings(&bridge->planner, &planner_settings);
+#if GRBL_KINEMATICS == GRBL_KIN_COREXY
+    /* Status reports convert steps with the kinematics' steps/mm */
+    kin_corexy_cfg_t kin_cfg;
+    kin_corexy_get_cfg(&kin_cfg);
+    for (uint32_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        kin_cfg.steps_per_mm[i] = planner_settings.steps_per_mm[i];
+    }
+    kin_corexy_set_cfg(&kin_cfg);
+#endif
+    (void)arc_set_tolerance_mm(bridge->settings.arc_tolerance_mm);
+
+    bridge->stepper.config.step_pulse_us = bridge->settings.step_pulse_time_us;
+    bridge->stepper.config.idle_disable = (bridge->settings.step_idle_delay_ms != 255u);
+    bridge->stepper.config.idle_timeout_ms = bridge->settings.step_idle_delay_ms;
+    bridge->stepper.config.laser_mode = bridge->settings.laser_mode;
+    bridge->stepper.config.spindle_max_rpm = (float)bridge->settings.spindle_max_rpm;
+    bridge->stepper.config.spindle_min_rpm = (float)bridge->settings.spindle_min_rpm;
+}
+
+/* Drive the spindle output from the modal state and the spindle override.
+ * In laser mode the laser stays off here: it only fires with motion, set
+ * per step segment. */
+static void apply_spindle(serial_gcode_bridge_t *bridge) {
+    const gcode_spindle_state_t state = gcode_get_spindle_state(&bridge->gcode);
+    if (bridge->settings.laser_mode || state == GCODE_SPINDLE_OFF) {
+        hal_spindle_set(HAL_SPINDLE_OFF, 0.0f);
+        return;
+    }
+    float rpm = gcode_get_spindle_speed(&bridge->gcode) * (float)bridge->overrides.spindle * 0.01f;
+    hal_spindle_set((hal_spindle_dir_t)state, stepper_spindle_pwm(&bridge->stepper, rpm));
+}
+
+/* Hand the override percentages to the stepper */
+static void push_overrides(serial_gcode_bridge_t *bridge) {
+    stepper_set_overrides(&bridge->stepper, bridge->overrides.feed, bridge->overrides.rapid,
+                          bridge->overrides.spindle);
+}
+
+/* Machine position follows the steps actually taken */
+static void sync_position_from_stepper(serial_gcode_bridge_t *bridge) {
+    kin_cart_t position;
+    planner_sync_position(&bridge->planner, &bridge->stepper.position);
+    planner_get_position(&bridge->planner, &position);
+    bridge->gcode.position_x = position.v[0];
+    bridge->gcode.position_y = position.v[1];
+}
+
+static void zero_machine_position(serial_gcode_bridge_t *bridge) {
+    memset(&bridge->stepper.position, 0, sizeof(bridge->stepper.position));
+    sync_position_from_stepper(bridge);
+}
+
+/* Stop the steppers now, drop queued motion and resync the parser */
+static void abort_motion(serial_gcode_bridge_t *bridge) {
+    stepper_rt_request(&bridge->stepper, STEPPER_RT_STOP);
+    stepper_update(&bridge->stepper);
+    planner_queue_clear(&bridge->planner);
+    stepper_enable_motors(&bridge->stepper, false);
+    sync_position_from_stepper(bridge);
+}
+
+/* Soft reset: drop all motion and return to the power-on parser state */
+static void soft_reset(serial_gcode_bridge_t *bridge) {
+    abort_motion(bridge);
+    gcode_reset(&bridge->gcode);
+    apply_spindle(bridge);
+    zero_machine_position(bridge);
+    bridge->feed_hold = false;
+    bridge->check_mode_enabled = false;
+    bridge->alarm_lock = true;
+    __atomic_store_n(&bridge->ovr_pending, 0u, __ATOMIC_RELAXED);
+    protocol_overrides_init(&bridge->overrides);
+    push_overrides(bridge);
+}
+
+/* Cartesian machine position from the steps taken. CoreXY builds go
+ * through the kinematics' cached reciprocals (kept on $100..$102 by
+ * apply_motion_settings()); otherwise the joints are scaled here and
+ * handed to whatever kinematics is installed. */
+static void machine_position(const serial_gcode_bridge_t *bridge, kin_cart_t *out) {
+#if GRBL_KINEMATICS == GRBL_KIN_COREXY
+    stepper_get_cart_position(&bridge->stepper, out);
+#else
+    kin_joint_t joint;
+    for (uint32_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        const float steps_per_mm = (i < HAL_AXIS_MAX) ? bridge->steps_per_mm[i] : 0.0f;
+        joint.v[i] = (steps_per_mm > 0.0f) ? (float)bridge->stepper.position.v[i] / steps_per_mm : 0.0f;
+    }
+    if (!kinematics_joint_to_cart(&joint, out)) {
+        memset(out, 0, sizeof(*out));
+    }
+#endif
+}
+
+/* Where the machine is now, not where the queue ends, and the live
+ * feed/rapid/spindle overrides */
+static void format_status(const serial_gcode_bridge_t *bridge, char *out, size_t out_len) {
+    kin_cart_t position;
+    machine_position(bridge, &position);
+
+    /* Report position in thousandths of mm to avoid printf float support. */
+    const int32_t x_milli = (int32_t)lroundf(position.v[0] * 1000.0f);
+    const int32_t y_milli = (int32_t)lroundf(position.v[1] * 1000.0f);
+
+    snprintf(out, out_len, "X:%ld Y:%ld (x0.001mm)|Ov:%u,%u,%u",
+             (long)x_milli, (long)y_milli,
+             (unsigned)bridge->overrides.feed,
+             (unsigned)bridge->overrides.rapid,
+             (unsigned)bridge->overrides.spindle);
+}
+
+static void report(const serial_gcode_bridge_t *bridge, const char *msg) {
+    if (bridge->report != NULL) {
+        bridge->report(bridge->report_ctx, msg);
+    }
+}
+
+/* Warn about words the parser skipped (Z, T, ...): the line still runs,
+ * so a host streaming 3-axis jobs is not stopped, but nothing is dropped
+ * silently */
+static void report_ignored_words(const serial_gcode_bridge_t *bridge) {
+    const uint32_t words = gcode_get_ignored_words(&bridge->gcode);
+    if (words == 0u) {
+        return;
+    }
+
+    char line[64] = "[MSG:Ignored";
+    size_t len = strlen(line);
+    for (uint32_t bit = 0u; bit < 26u && len + 3u < sizeof(line); bit++) {
+        if (words & (1u << bit)) {
+            line[len++] = ' ';
+            line[len++] = (char)('A' + bit);
+        }
+    }
+    line[len++] = ']';
+    line[len] = '\0';
+    report(bridge, line);
+}
+
+#if GRBL_FEATURE_PROFILE
+/* $P: one line per profiling zone, "[PRF:zone,count,min,avg,max]" in cycles */
+static void report_profile(const serial_gcode_bridge_t *bridge) {
+    char line[64];
+    for (profile_zone_t zone = (profile_zone_t)0; zone < PROFILE_ZONE_COUNT; zone++) {
+        profile_stats_t st;
+        profile_get(zone, &st);
+        const uint32_t avg = st.count ? (uint32_t)(st.total_cycles / st.count) : 0u;
+        snprintf(line, sizeof(line), "[PRF:%s,%lu,%lu,%lu,%lu]",
+                 profile_zone_name(zone),
+                 (unsigned long)st.count,
+                 (unsigned long)st.min_cycles,
+                 (unsigned long)avg,
+                 (unsigned long)st.max_cycles);
+        report(bridge, line);
+    }
+}
+#endif
+
+#if GRBL_FEATURE_ISR_LATENCY
+/* $L: "[ISR:samples,max_latency,max_duration]" then "[LAT:from,count]" for
+ * each non-empty histogram bucket (latency in step ticks from the bucket's
+ * lower bound, duration in cycles) */
+static void report_isr_latency(const serial_gcode_bridge_t *bridge) {
+    char line[64];
+    isr_latency_stats_t st;
+    isr_latency_get(&st);
+    snprintf(line, sizeof(line), "[ISR:%lu,%lu,%lu]",
+             (unsigned long)st.samples,
+             (unsigned long)st.max_latency_ticks,
+             (unsigned long)st.max_duration_cycles);
+    report(bridge, line);
+    for (uint8_t b = 0u; b < ISR_LATENCY_BUCKETS; b++) {
+        if (st.buckets[b] == 0u) {
+            continue;
+        }
+        snprintf(line, sizeof(line), "[LAT:%lu,%lu]",
+                 (unsigned long)isr_latency_bucket_floor(b),
+                 (unsigned long)st.buckets[b]);
+        report(bridge, line);
+    }
+}
+#endif
+
+/* Apply the override commands posted since the last poll. As in Grbl,
+ * repeats of one command between two polls count once. */
+static void service_overrides(serial_gcode_bridge_t *bridge) {
+    const uint16_t pending = __atomic_exchange_n(&bridge->ovr_pending, 0u, __ATOMIC_ACQ_REL);
+    if (pending == 0u) {
+        return;
+    }
+
+    const uint8_t spindle = bridge->overrides.spindle;
+    bool changed = false;
+    for (uint32_t bit = 0u; bit < 16u; bit++) {
+        if (pending & (1u << bit)) {
+            changed |= protocol_apply_override(&bridge->overrides,
+                                               (proto_rt_cmd_t)(PROTO_RT_FEED_OVR_RESET + bit));
+        }
+    }
+    if (changed) {
+        push_overrides(bridge);
+    }
+    if (bridge->overrides.spindle != spindle) {
+        apply_spindle(bridge);
+    }
+}
+
+/* Finish the realtime commands posted since the last poll */
+static void service_realtime(serial_gcode_bridge_t *bridge) {
+    service_overrides(bridge);
+
+    const uint8_t pending = __atomic_exchange_n(&bridge->rt_pending, 0u, __ATOMIC_ACQ_REL);
+    if (pending == 0u) {
+        return;
+    }
+
+    if (pending & BRIDGE_RT_RESET) {
+        soft_reset(bridge);
+        bridge->line_aborted = true;
+        report(bridge, "Grbl reset");
+    } else if (pending & BRIDGE_RT_HOLD) {
+        bridge->feed_hold = true;
+    } else if (pending & BRIDGE_RT_RESUME) {
+        bridge->feed_hold = false;
+    }
+
+    if (pending & BRIDGE_RT_STATUS) {
+        char status[64];
+        format_status(bridge, status, sizeof(status));
+        report(bridge, status);
+    }
+}
+
+/* Respond to a line whose motion was cut short by a safety input or reset */
+static gcode_status_t motion_aborted(const serial_gcode_bridge_t *bridge, char *response, size_t response_len) {
+    if (bridge->line_aborted) {
+        snprintf(response, response_len, "error: reset");
+        return GCODE_ERR_MOTION_ABORTED;
+    }
+    snprintf(response, response_len, "error: safety input active");
+    return GCODE_ERR_INVALID_TARGET;
+}
+
+/* Run background motion until all queued motion has finished */
+static bool wait_for_motion(serial_gcode_bridge_t *bridge) {
+    while (!serial_gcode_bridge_is_idle(bridge)) {
+        if (!serial_gcode_bridge_poll(bridge) || bridge->line_aborted) {
+            return false;
+        }
+        hal_poll();
+    }
+    return !bridge->line_aborted;
+}
+
+/* G-code planner_wait hook: keep motion running while the queue is full */
+static bool planner_wait_hook(void *user) {
+    serial_gcode_bridge_t *bridge = (serial_gcode_bridge_t *)user;
+    if (!serial_gcode_bridge_poll(bridge) || bridge->line_aborted) {
+        return false;
+    }
+    hal_poll();
+    return true;
+}
+
+/* G-code spindle hook. In laser mode the power rides on the planner blocks,
+ * so M3/M4/S queue without waiting; otherwise the spindle switches once the
+ * queued motion has finished. */
+static bool spindle_sync_hook(void *user, gcode_spindle_state_t state, float speed) {
+    serial_gcode_bridge_t *bridge = (serial_gcode_bridge_t *)user;
+    (void)state;
+    (void)speed;
+    if (bridge->settings.laser_mode) {
+        return true;
+    }
+    if (!wait_for_motion(bridge)) {
+        return false;
+    }
+    apply_spindle(bridge);
+    return true;
+}
+
 void serial_gcode_bridge_init(serial_gcode_bridge_t *bridge) {
-    if (!bridge) {
-        return;
-    }
-
-    memset(bridge, 0, sizeof(*bridge));
-    gcode_init(&bridge->gcode);
+    if (!bridge) {
+        return;
+    }
+
+    memset(bridge, 0, sizeof(*bridge));
+    gcode_init(&bridge->gcode);
     for (uint8_t axis = 0; axis < HAL_AXIS_MAX; axis++) {
         bridge->steps_per_mm[axis] = 80.0f;
     }
@@ -436,7 +666,7 @@ void serial_gcode_bridge_init(serial_gcode_bridge_t *bridge) {
     bridge->settings.probe_pin_invert = false;
     bridge->settings.status_report_mask = 3u;
     bridge->settings.junction_deviation_mm = 0.010f;
-    bridge->settings.arc_tolerance_mm = 0.002f;
+    bridge->settings.arc_tolerance_mm = ARC_TOLERANCE_MM_DEFAULT;
     bridge->settings.report_inches = false;
     bridge->settings.soft_limits_enable = false;
     bridge->settings.hard_limits_enable = false;
@@ -448,6 +678,7 @@ void serial_gcode_bridge_init(serial_gcode_bridge_t *bridge) {
     bridge->settings.homing_pull_off_mm = 1.0f;
     bridge->settings.spindle_max_rpm = 10000u;
     bridge->settings.spindle_min_rpm = 0u;
+    bridge->settings.laser_mode = false;
     bridge->settings.max_rate_mm_per_min[0] = 3000.0f;
     bridge->settings.max_rate_mm_per_min[1] = 3000.0f;
     bridge->settings.max_rate_mm_per_min[2] = 500.0f;
@@ -460,33 +691,121 @@ void serial_gcode_bridge_init(serial_gcode_bridge_t *bridge) {
     bridge->active_wcs_index = 0u;
     bridge->startup_lines[0][0] = '\0';
     bridge->startup_lines[1][0] = '\0';
+
+    protocol_overrides_init(&bridge->overrides);
+    planner_queue_init(&bridge->planner, 0u);
+    stepper_init(&bridge->stepper, NULL);
+    stepper_set_planner(&bridge->stepper, &bridge->planner);
+    apply_motion_settings(bridge);
+    gcode_set_planner(&bridge->gcode, &bridge->planner, planner_wait_hook, bridge);
+    gcode_set_spindle_sync(&bridge->gcode, spindle_sync_hook, bridge);
 }
-
-void serial_gcode_bridge_set_motion_backend(serial_gcode_bridge_t *bridge,
-                                            bool (*backend)(void *ctx,
-                                                            float start_x,
-                                                            float start_y,
-                                                            float end_x,
-                                                            float end_y,
-                                                            const float *steps_per_mm,
-                                                            uint32_t step_pulse_delay_us),
-                                            void *backend_ctx) {
-    if (!bridge) {
-        return;
-    }
-
-    bridge->motion_backend = backend;
-    bridge->motion_backend_ctx = backend_ctx;
-}
-
+
+void serial_gcode_bridge_set_motion_backend(serial_gcode_bridge_t *bridge,
+                                            bool (*backend)(void *ctx,
+                                                            float start_x,
+                                                            float start_y,
+                                                            float end_x,
+                                                            float end_y,
+                                                            const float *steps_per_mm,
+                                                            uint32_t step_pulse_delay_us),
+                                            void *backend_ctx) {
+    if (!bridge) {
+        return;
+    }
+
+    bridge->motion_backend = backend;
+    bridge->motion_backend_ctx = backend_ctx;
+
+    /* A custom backend replaces the planner: G-code only tracks position */
+    if (backend != NULL) {
+        gcode_set_planner(&bridge->gcode, NULL, NULL, NULL);
+    } else {
+        gcode_set_planner(&bridge->gcode, &bridge->planner, planner_wait_hook, bridge);
+    }
+}
+
+void serial_gcode_bridge_set_report(serial_gcode_bridge_t *bridge,
+                                    void (*report)(void *ctx, const char *msg),
+                                    void *report_ctx) {
+    if (!bridge) {
+        return;
+    }
+
+    bridge->report = report;
+    bridge->report_ctx = report_ctx;
+}
+
+void serial_gcode_bridge_realtime(serial_gcode_bridge_t *bridge, proto_rt_cmd_t cmd) {
+    if (!bridge) {
+        return;
+    }
+
+    if (protocol_rt_is_override(cmd)) {
+        const uint16_t bit = (uint16_t)(1u << (cmd - PROTO_RT_FEED_OVR_RESET));
+        __atomic_fetch_or(&bridge->ovr_pending, bit, __ATOMIC_RELEASE);
+        return;
+    }
+
+    uint8_t bits = 0u;
+    switch (cmd) {
+        case PROTO_RT_STATUS_QUERY:
+            bits = BRIDGE_RT_STATUS;
+            break;
+        case PROTO_RT_FEED_HOLD:
+            stepper_rt_request(&bridge->stepper, STEPPER_RT_HOLD);
+            __atomic_fetch_and(&bridge->rt_pending, (uint8_t)~BRIDGE_RT_RESUME, __ATOMIC_RELAXED);
+            bits = BRIDGE_RT_HOLD;
+            break;
+        case PROTO_RT_CYCLE_START:
+            stepper_rt_request(&bridge->stepper, STEPPER_RT_RESUME);
+            __atomic_fetch_and(&bridge->rt_pending, (uint8_t)~BRIDGE_RT_HOLD, __ATOMIC_RELAXED);
+            bits = BRIDGE_RT_RESUME;
+            break;
+        case PROTO_RT_RESET:
+        case PROTO_RT_ESTOP:
+            stepper_rt_request(&bridge->stepper, STEPPER_RT_STOP);
+            bits = BRIDGE_RT_RESET;
+            break;
+        case PROTO_RT_NONE:
+        default:
+            return;
+    }
+    __atomic_fetch_or(&bridge->rt_pending, bits, __ATOMIC_RELEASE);
+}
+
+bool serial_gcode_bridge_poll(serial_gcode_bridge_t *bridge) {
+    if (!bridge) {
+        return false;
+    }
+
+    service_realtime(bridge);
+
+    if (!serial_gcode_bridge_is_idle(bridge) && safety_input_active()) {
+        abort_motion(bridge);
+        return false;
+    }
+
+    stepper_update(&bridge->stepper);
+    return true;
+}
+
+bool serial_gcode_bridge_is_idle(const serial_gcode_bridge_t *bridge) {
+    if (!bridge) {
+        return true;
+    }
+    return stepper_is_idle(&bridge->stepper) && planner_is_empty(&bridge->planner);
+}
+
 gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
                                                 const char *line,
                                                 char *response,
                                                 size_t response_len) {
-    if (!bridge || !line || !response || response_len == 0u) {
-        return GCODE_ERR_INVALID_PARAM;
-    }
-
+    if (!bridge || !line || !response || response_len == 0u) {
+        return GCODE_ERR_INVALID_PARAM;
+    }
+    bridge->line_aborted = false;
+
     if (line_is_simple_cmd(line, "$I")) {
         snprintf(response, response_len, "%s", FW_IDENTITY);
         return GCODE_OK;
@@ -529,6 +848,32 @@ gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
         return GCODE_OK;
     }
 
+    if (line_is_simple_cmd(line, "$P")) {
+#if GRBL_FEATURE_PROFILE
+        report_profile(bridge);
+        snprintf(response, response_len, "OK");
+        return GCODE_OK;
+#else
+        snprintf(response, response_len, "error: profiling disabled");
+        return GCODE_ERR_UNSUPPORTED_CMD;
+#endif
+    }
+
+    if (line_is_simple_cmd(line, "$L") || line_is_simple_cmd(line, "$LR")) {
+#if GRBL_FEATURE_ISR_LATENCY
+        if (line_is_simple_cmd(line, "$LR")) {
+            isr_latency_reset();
+        } else {
+            report_isr_latency(bridge);
+        }
+        snprintf(response, response_len, "OK");
+        return GCODE_OK;
+#else
+        snprintf(response, response_len, "error: ISR latency disabled");
+        return GCODE_ERR_UNSUPPORTED_CMD;
+#endif
+    }
+
     uint8_t startup_slot = 0u;
     const char *startup_value = NULL;
     if (parse_startup_assignment(line, &startup_slot, &startup_value)) {
@@ -557,8 +902,10 @@ gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
             snprintf(response, response_len, "error: homing disabled");
             return GCODE_ERR_UNSUPPORTED_CMD;
         }
-        bridge->gcode.position_x = 0.0f;
-        bridge->gcode.position_y = 0.0f;
+        if (!wait_for_motion(bridge)) {
+            return motion_aborted(bridge, response, response_len);
+        }
+        zero_machine_position(bridge);
         bridge->alarm_lock = false;
         snprintf(response, response_len, "OK");
         return GCODE_OK;
@@ -566,21 +913,20 @@ gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
 
     if (line_is_simple_cmd(line, "!")) {
         bridge->feed_hold = true;
+        stepper_hold(&bridge->stepper);
         snprintf(response, response_len, "OK");
         return GCODE_OK;
     }
 
     if (line_is_simple_cmd(line, "~")) {
         bridge->feed_hold = false;
+        stepper_resume(&bridge->stepper);
         snprintf(response, response_len, "OK");
         return GCODE_OK;
     }
 
     if (line[0] == 0x18 && line[1] == '\0') {
-        gcode_reset(&bridge->gcode);
-        bridge->feed_hold = false;
-        bridge->check_mode_enabled = false;
-        bridge->alarm_lock = true;
+        soft_reset(bridge);
         snprintf(response, response_len, "Grbl reset");
         return GCODE_OK;
     }
@@ -588,15 +934,18 @@ gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
     uint32_t setting_id = 0u;
     const char *setting_value = NULL;
     if (parse_setting_assignment(line, &setting_id, &setting_value)) {
-        if (setting_id == 32u) {
-            snprintf(response, response_len, "error: unsupported setting $32");
-            return GCODE_ERR_UNSUPPORTED_CMD;
-        }
         setting_type_t parsed_type = SETTING_U32;
         if (!setting_type_for_id(setting_id, &parsed_type)) {
             snprintf(response, response_len, "error: unknown setting $%lu", (unsigned long)setting_id);
             return GCODE_ERR_INVALID_PARAM;
         }
+        /* Steps per mm rescale the queued step counts and the spindle
+         * settings change how queued blocks drive the spindle: finish them first */
+        const bool rescale = (setting_id >= 100u && setting_id <= 102u);
+        const bool spindle = (setting_id >= 30u && setting_id <= 32u);
+        if ((rescale || spindle) && !wait_for_motion(bridge)) {
+            return motion_aborted(bridge, response, response_len);
+        }
         if (!set_setting_value(bridge, setting_id, setting_value)) {
             snprintf(response,
                      response_len,
@@ -604,37 +953,38 @@ gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
                      (unsigned long)setting_id);
             return GCODE_ERR_INVALID_PARAM;
         }
+        apply_motion_settings(bridge);
+        if (rescale) {
+            sync_position_from_stepper(bridge);
+        }
+        if (spindle) {
+            apply_spindle(bridge);
+        }
         snprintf(response, response_len, "OK");
         return GCODE_OK;
     }
 
     /* Status query: report current position */
     if (line_is_simple_cmd(line, "?") || line_is_simple_cmd(line, "$")) {
-        float x = 0.0f;
-        float y = 0.0f;
-        gcode_get_position(&bridge->gcode, &x, &y);
-
-        /* Report position in thousandths of mm to avoid printf float support. */
-        const int32_t x_milli = (int32_t)lroundf(x * 1000.0f);
-        const int32_t y_milli = (int32_t)lroundf(y * 1000.0f);
-
-        snprintf(response, response_len, "X:%ld Y:%ld (x0.001mm)",
-                 (long)x_milli, (long)y_milli);
-        return GCODE_OK;
-    }
-
-    if (line_is_simple_cmd(line, "M17")) {
-        hal_stepper_enable(true);
-        snprintf(response, response_len, "OK");
-        return GCODE_OK;
-    }
-
-    if (line_is_simple_cmd(line, "M18")) {
-        hal_stepper_enable(false);
-        snprintf(response, response_len, "OK");
-        return GCODE_OK;
-    }
-
+        format_status(bridge, response, response_len);
+        return GCODE_OK;
+    }
+
+    if (line_is_simple_cmd(line, "M17")) {
+        stepper_enable_motors(&bridge->stepper, true);
+        snprintf(response, response_len, "OK");
+        return GCODE_OK;
+    }
+
+    if (line_is_simple_cmd(line, "M18")) {
+        if (!wait_for_motion(bridge)) {
+            return motion_aborted(bridge, response, response_len);
+        }
+        stepper_enable_motors(&bridge->stepper, false);
+        snprintf(response, response_len, "OK");
+        return GCODE_OK;
+    }
+
     float start_x = 0.0f;
     float start_y = 0.0f;
     gcode_get_position(&bridge->gcode, &start_x, &start_y);
@@ -651,33 +1001,39 @@ gcode_status_t serial_gcode_bridge_process_line(serial_gcode_bridge_t *bridge,
     }
 
     const gcode_status_t status = gcode_process_line(&bridge->gcode, line);
-    if (status != GCODE_OK) {
-        snprintf(response, response_len, "error: %s", gcode_status_string(status));
-        return status;
-    }
-
-    float end_x = 0.0f;
-    float end_y = 0.0f;
-    gcode_get_position(&bridge->gcode, &end_x, &end_y);
-
-    bool motion_ok = false;
-    if (bridge->motion_backend != NULL) {
-        motion_ok = bridge->motion_backend(bridge->motion_backend_ctx,
-                                           start_x,
-                                           start_y,
-                                           end_x,
-                                           end_y,
-                                           bridge->steps_per_mm,
-                                           bridge->step_pulse_delay_us);
-    } else {
-        motion_ok = drive_xy_motion(bridge, start_x, start_y, end_x, end_y);
-    }
-
-    if (!motion_ok) {
-        snprintf(response, response_len, "error: safety input active");
-        return GCODE_ERR_INVALID_TARGET;
-    }
-
-    snprintf(response, response_len, "OK");
-    return GCODE_OK;
-}
+    if (status == GCODE_ERR_MOTION_ABORTED) {
+        return motion_aborted(bridge, response, response_len);
+    }
+    if (status != GCODE_OK) {
+        snprintf(response, response_len, "error: %s", gcode_status_string(status));
+        return status;
+    }
+    report_ignored_words(bridge);
+
+    float end_x = 0.0f;
+    float end_y = 0.0f;
+    gcode_get_position(&bridge->gcode, &end_x, &end_y);
+
+    bool motion_ok = false;
+    if (bridge->motion_backend != NULL) {
+        /* Custom backends run synchronously, after any queued motion */
+        motion_ok = wait_for_motion(bridge) &&
+                    bridge->motion_backend(bridge->motion_backend_ctx,
+                                           start_x,
+                                           start_y,
+                                           end_x,
+                                           end_y,
+                                           bridge->steps_per_mm,
+                                           bridge->step_pulse_delay_us);
+    } else {
+        /* Motion is queued; start it (or abort it on a safety input) now */
+        motion_ok = serial_gcode_bridge_poll(bridge) && !bridge->line_aborted;
+    }
+
+    if (!motion_ok) {
+        return motion_aborted(bridge, response, response_len);
+    }
+
+    snprintf(response, response_len, "OK");
+    return GCODE_OK;
+}
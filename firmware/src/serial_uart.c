@@ -1,117 +1,218 @@
-#include "serial_uart.h"
-
-#include <string.h>
-
-static uint16_t ring_next(uint16_t idx, uint16_t cap) {
-    idx++;
-    return (idx >= cap) ? 0u : idx;
-}
-
-void serial_uart_init(serial_uart_t *uart) {
-    if (!uart) return;
-    memset(uart, 0, sizeof(*uart));
-}
-
-bool serial_uart_rx_push_byte(serial_uart_t *uart, uint8_t byte) {
-    if (!uart || uart->rx_count >= UART_RX_BUFFER_SIZE) return false;
-    uart->rx_buf[uart->rx_tail] = byte;
-    uart->rx_tail = ring_next(uart->rx_tail, UART_RX_BUFFER_SIZE);
-    uart->rx_count++;
-    return true;
-}
-
-size_t serial_uart_rx_push(serial_uart_t *uart, const uint8_t *data, size_t len) {
-    if (!uart || !data) return 0u;
-    size_t accepted = 0u;
-    for (size_t i = 0; i < len; i++) {
-        if (!serial_uart_rx_push_byte(uart, data[i])) break;
-        accepted++;
-    }
-    return accepted;
-}
-
-bool serial_uart_rx_pop_byte(serial_uart_t *uart, uint8_t *out_byte) {
-    if (!uart || !out_byte || uart->rx_count == 0u) return false;
-    *out_byte = uart->rx_buf[uart->rx_head];
-    uart->rx_head = ring_next(uart->rx_head, UART_RX_BUFFER_SIZE);
-    uart->rx_count--;
-    return true;
-}
-
-static void uart_finalize_line(serial_uart_t *uart, char *out_line, size_t out_cap) {
-    if (!out_line || out_cap == 0u) return;
-    if (uart->line_len >= out_cap) {
-        memcpy(out_line, uart->line_buf, out_cap - 1u);
-        out_line[out_cap - 1u] = '\0';
-    } else {
-        memcpy(out_line, uart->line_buf, uart->line_len);
-        out_line[uart->line_len] = '\0';
-    }
-}
-
-uart_line_status_t serial_uart_read_line(serial_uart_t *uart, char *out_line, size_t out_cap) {
-    if (!uart || !out_line || out_cap == 0u) return UART_LINE_NONE;
-
-    uint8_t byte = 0u;
-    while (serial_uart_rx_pop_byte(uart, &byte)) {
-        if (byte == '\r') {
-            continue;
-        }
-
-        if (byte == '\n') {
-            if (uart->line_len == 0u && !uart->line_overflow) {
-                continue;
-            }
-
-            uart_finalize_line(uart, out_line, out_cap);
-            uart_line_status_t st = uart->line_overflow ? UART_LINE_OVERFLOW : UART_LINE_READY;
-
-            uart->line_len = 0u;
-            uart->line_overflow = false;
-            uart->line_buf[0] = '\0';
-            return st;
-        }
-
-        if (byte == 0x08u || byte == 0x7Fu) {
-            if (uart->line_len > 0u) {
-                uart->line_len--;
-                uart->line_buf[uart->line_len] = '\0';
-            }
-            continue;
-        }
-
-        if (byte < 0x20u || byte > 0x7Eu) {
-            continue;
-        }
-
-        if (uart->line_len < UART_LINE_MAX) {
-            uart->line_buf[uart->line_len++] = (char)byte;
-            uart->line_buf[uart->line_len] = '\0';
-        } else {
-            uart->line_overflow = true;
-        }
-    }
-
-    return UART_LINE_NONE;
-}
-
-size_t serial_uart_tx_enqueue(serial_uart_t *uart, const uint8_t *data, size_t len) {
-    if (!uart || !data) return 0u;
-    size_t accepted = 0u;
-    for (size_t i = 0; i < len; i++) {
-        if (uart->tx_count >= UART_TX_BUFFER_SIZE) break;
-        uart->tx_buf[uart->tx_tail] = data[i];
-        uart->tx_tail = ring_next(uart->tx_tail, UART_TX_BUFFER_SIZE);
-        uart->tx_count++;
-        accepted++;
-    }
-    return accepted;
-}
-
-bool serial_uart_tx_pop_byte(serial_uart_t *uart, uint8_t *out_byte) {
-    if (!uart || !out_byte || uart->tx_count == 0u) return false;
-    *out_byte = uart->tx_buf[uart->tx_head];
-    uart->tx_head = ring_next(uart->tx_head, UART_TX_BUFFER_SIZE);
-    uart->tx_count--;
-    return true;
-}
+#include "serial_uart.h"
+
+#include <string.h>
+
+#include "profile.h"
+
+#define RX_MASK ((uint16_t)(UART_RX_BUFFER_SIZE - 1u))
+#define TX_MASK ((uint16_t)(UART_TX_BUFFER_SIZE - 1u))
+
+/* Index handoff between producer and consumer. The release store publishes
+ * the buffer bytes written before it; the acquire load on the other side
+ * makes them visible before they are read (a DMB on Cortex-M4). */
+#define RING_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RING_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+/* Copy len bytes into a ring starting at free-running index pos */
+static void ring_write(uint8_t *buf, uint16_t mask, uint16_t pos, const uint8_t *data, size_t len) {
+    size_t start = (size_t)(pos & mask);
+    size_t first = (size_t)mask + 1u - start;
+    if (first > len) first = len;
+    memcpy(&buf[start], data, first);
+    memcpy(buf, data + first, len - first);
+}
+
+/* Copy len bytes out of a ring starting at free-running index pos */
+static void ring_read(const uint8_t *buf, uint16_t mask, uint16_t pos, uint8_t *out, size_t len) {
+    size_t start = (size_t)(pos & mask);
+    size_t first = (size_t)mask + 1u - start;
+    if (first > len) first = len;
+    memcpy(out, &buf[start], first);
+    memcpy(out + first, buf, len - first);
+}
+
+void serial_uart_init(serial_uart_t *uart) {
+    if (!uart) return;
+    memset(uart, 0, sizeof(*uart));
+}
+
+bool serial_uart_rx_push_byte(serial_uart_t *uart, uint8_t byte) {
+    return serial_uart_rx_push(uart, &byte, 1u) == 1u;
+}
+
+size_t serial_uart_rx_push(serial_uart_t *uart, const uint8_t *data, size_t len) {
+    if (!uart || !data) return 0u;
+
+    uint16_t tail = uart->rx_tail;
+    uint16_t head = RING_LOAD_ACQUIRE(&uart->rx_head);
+    size_t space = UART_RX_BUFFER_SIZE - (uint16_t)(tail - head);
+    if (len > space) len = space;
+    if (len == 0u) return 0u;
+
+    ring_write(uart->rx_buf, RX_MASK, tail, data, len);
+    RING_STORE_RELEASE(&uart->rx_tail, (uint16_t)(tail + len));
+    return len;
+}
+
+bool serial_uart_rx_pop_byte(serial_uart_t *uart, uint8_t *out_byte) {
+    return out_byte && serial_uart_rx_pop(uart, out_byte, 1u) == 1u;
+}
+
+size_t serial_uart_rx_pop(serial_uart_t *uart, uint8_t *out, size_t cap) {
+    if (!uart || !out) return 0u;
+
+    uint16_t head = uart->rx_head;
+    uint16_t tail = RING_LOAD_ACQUIRE(&uart->rx_tail);
+    size_t avail = (uint16_t)(tail - head);
+    if (cap > avail) cap = avail;
+    if (cap == 0u) return 0u;
+
+    ring_read(uart->rx_buf, RX_MASK, head, out, cap);
+    RING_STORE_RELEASE(&uart->rx_head, (uint16_t)(head + cap));
+    return cap;
+}
+
+size_t serial_uart_rx_count(const serial_uart_t *uart) {
+    if (!uart) return 0u;
+    return (uint16_t)(RING_LOAD_ACQUIRE(&uart->rx_tail) - RING_LOAD_ACQUIRE(&uart->rx_head));
+}
+
+static void uart_finalize_line(serial_uart_t *uart, char *out_line, size_t out_cap) {
+    if (!out_line || out_cap == 0u) return;
+    if (uart->line_len >= out_cap) {
+        memcpy(out_line, uart->line_buf, out_cap - 1u);
+        out_line[out_cap - 1u] = '\0';
+    } else {
+        memcpy(out_line, uart->line_buf, uart->line_len);
+        out_line[uart->line_len] = '\0';
+    }
+}
+
+/* Append raw received bytes (no '\n') to the line being assembled. Each
+ * call copies with one memcpy while the line has room, then edits the
+ * copy in place: CR and other control bytes are dropped and backspace/DEL
+ * erase the previous character, exactly as if the bytes had been handled
+ * one at a time. */
+static void line_append(serial_uart_t *uart, const uint8_t *src, size_t len) {
+    while (len > 0u) {
+        size_t room = UART_LINE_MAX - uart->line_len;
+        if (room == 0u) {
+            /* Full: printable bytes overflow, only a backspace makes room */
+            uint8_t byte = *src++;
+            len--;
+            if (byte == 0x08u || byte == 0x7Fu) {
+                uart->line_len--;
+            } else if (byte >= 0x20u && byte <= 0x7Eu) {
+                uart->line_overflow = true;
+            }
+            continue;
+        }
+
+        size_t n = (len < room) ? len : room;
+        char *line = uart->line_buf;
+        uint16_t w = uart->line_len;
+        memcpy(&line[w], src, n);
+
+        for (size_t r = uart->line_len; r < uart->line_len + n; r++) {
+            uint8_t byte = (uint8_t)line[r];
+            if (byte == 0x08u || byte == 0x7Fu) {
+                if (w > 0u) w--;
+            } else if (byte >= 0x20u && byte <= 0x7Eu) {
+                line[w++] = (char)byte;
+            }
+        }
+
+        uart->line_len = w;
+        src += n;
+        len -= n;
+    }
+    uart->line_buf[uart->line_len] = '\0';
+}
+
+static uart_line_status_t read_line(serial_uart_t *uart, char *out_line, size_t out_cap) {
+    if (!uart || !out_line || out_cap == 0u) return UART_LINE_NONE;
+
+    /* One acquire for everything already received; head is published
+     * once per line instead of once per byte */
+    uint16_t head = uart->rx_head;
+    const uint16_t tail = RING_LOAD_ACQUIRE(&uart->rx_tail);
+
+    while (head != tail) {
+        /* Contiguous span up to the ring end or tail: at most two per call */
+        size_t start = (size_t)(head & RX_MASK);
+        size_t span = UART_RX_BUFFER_SIZE - start;
+        size_t avail = (uint16_t)(tail - head);
+        if (span > avail) span = avail;
+
+        const uint8_t *src = &uart->rx_buf[start];
+        const uint8_t *nl = (const uint8_t *)memchr(src, '\n', span);
+        size_t take = nl ? (size_t)(nl - src) : span;
+
+        line_append(uart, src, take);
+        head = (uint16_t)(head + take);
+        if (!nl) continue;
+
+        head++;  /* the '\n' */
+        if (uart->line_len == 0u && !uart->line_overflow) {
+            continue;
+        }
+
+        RING_STORE_RELEASE(&uart->rx_head, head);
+        uart_finalize_line(uart, out_line, out_cap);
+        uart_line_status_t st = uart->line_overflow ? UART_LINE_OVERFLOW : UART_LINE_READY;
+
+        uart->line_len = 0u;
+        uart->line_overflow = false;
+        uart->line_buf[0] = '\0';
+        return st;
+    }
+
+    RING_STORE_RELEASE(&uart->rx_head, head);
+    return UART_LINE_NONE;
+}
+
+uart_line_status_t serial_uart_read_line(serial_uart_t *uart, char *out_line, size_t out_cap) {
+    PROFILE_BEGIN(t0);
+    uart_line_status_t st = read_line(uart, out_line, out_cap);
+    if (st != UART_LINE_NONE) {
+        PROFILE_END(PROFILE_ZONE_FRAMING, t0);
+    }
+    return st;
+}
+
+size_t serial_uart_tx_enqueue(serial_uart_t *uart, const uint8_t *data, size_t len) {
+    if (!uart || !data) return 0u;
+
+    uint16_t tail = uart->tx_tail;
+    uint16_t head = RING_LOAD_ACQUIRE(&uart->tx_head);
+    size_t space = UART_TX_BUFFER_SIZE - (uint16_t)(tail - head);
+    if (len > space) len = space;
+    if (len == 0u) return 0u;
+
+    ring_write(uart->tx_buf, TX_MASK, tail, data, len);
+    RING_STORE_RELEASE(&uart->tx_tail, (uint16_t)(tail + len));
+    return len;
+}
+
+bool serial_uart_tx_pop_byte(serial_uart_t *uart, uint8_t *out_byte) {
+    return out_byte && serial_uart_tx_pop(uart, out_byte, 1u) == 1u;
+}
+
+size_t serial_uart_tx_pop(serial_uart_t *uart, uint8_t *out, size_t cap) {
+    if (!uart || !out) return 0u;
+
+    uint16_t head = uart->tx_head;
+    uint16_t tail = RING_LOAD_ACQUIRE(&uart->tx_tail);
+    size_t avail = (uint16_t)(tail - head);
+    if (cap > avail) cap = avail;
+    if (cap == 0u) return 0u;
+
+    ring_read(uart->tx_buf, TX_MASK, head, out, cap);
+    RING_STORE_RELEASE(&uart->tx_head, (uint16_t)(head + cap));
+    return cap;
+}
+
+size_t serial_uart_tx_count(const serial_uart_t *uart) {
+    if (!uart) return 0u;
+    return (uint16_t)(RING_LOAD_ACQUIRE(&uart->tx_tail) - RING_LOAD_ACQUIRE(&uart->tx_head));
+}
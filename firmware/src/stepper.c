@@ -1,388 +1,1135 @@
-/* stepper.c - Stepper motor control implementation */
-
-#include "stepper.h"
-#include "system_state.h"
-#include <string.h>
-#include <math.h>
-
-/* Constants */
-#define DEFAULT_STEP_INTERVAL_US 1000  /* Default step interval: 1ms */
-
-/* Internal helper functions */
-
-/* Delay for a specified number of microseconds 
- * Note: This implementation uses hal_delay_ms with rounding up to 1ms minimum
- * For sub-millisecond precision, a platform-specific implementation would be needed
- */
-static void delay_us(uint32_t us) {
-    if (us == 0) return;
-    
-    /* Convert to milliseconds, rounding up */
-    uint32_t ms = (us + 999) / 1000;
-    if (ms == 0) ms = 1;  /* Minimum 1ms delay */
-    
-    hal_delay_ms(ms);
-}
-
-/* Convert planner block to step counts using kinematics */
-static bool block_to_steps(const planner_block_t *block, 
-                          uint32_t *out_steps,
-                          uint8_t *out_dir_bits) {
-    if (!block || !out_steps || !out_dir_bits) {
-        return false;
-    }
-    
-    /* For now, we'll use the step_event_count from the planner block */
-    /* In a real implementation, this would use kinematics to convert
-     * the target position to steps for each axis */
-    
-    /* Initialize all step counts to zero */
-    for (uint8_t i = 0; i < HAL_AXIS_MAX; i++) {
-        out_steps[i] = 0;
-    }
-    
-    /* Use the step_event_count and direction_bits from the block */
-    /* This is simplified - real implementation would use kinematics */
-    *out_dir_bits = block->direction_bits;
-    
-    /* Distribute steps across axes based on direction bits */
-    /* This is a simplified approach */
-    if (block->step_event_count > 0) {
-        /* For simplicity, put all steps on X axis if direction bit 0 is set */
-        /* Real implementation would calculate per-axis steps properly */
-        out_steps[HAL_AXIS_X] = block->step_event_count;
-    }
-    
-    return true;
-}
-
-/* Set direction pins for all axes */
-static void set_directions(uint8_t dir_bits) {
-    for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
-        bool dir_positive = (dir_bits & (1 << axis)) != 0;
-        hal_stepper_set_dir(axis, dir_positive);
-    }
-}
-
-/* Clear step pulses for all axes */
-static void clear_step_pulses(void) {
-    for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
-        hal_stepper_step_clear(axis);
-    }
-}
-
-/* ----------------------------- Public API Implementation ----------------------------- */
-
-void stepper_init(stepper_context_t *ctx, const stepper_config_t *config) {
-    if (!ctx) {
-        return;
-    }
-    
-    /* Clear context */
-    memset(ctx, 0, sizeof(stepper_context_t));
-    
-    /* Set initial state */
-    ctx->state = STEPPER_IDLE;
-    
-    /* Copy configuration */
-    if (config) {
-        ctx->config = *config;
-    } else {
-        /* Set default configuration */
-        ctx->config.step_pulse_us = 10;        /* 10 microsecond pulse */
-        ctx->config.step_idle_delay_us = 100;  /* 100 us between steps */
-        ctx->config.dir_setup_us = 5;          /* 5 us direction setup */
-        ctx->config.motors_enabled = false;
-        ctx->config.idle_disable = true;
-        ctx->config.idle_timeout_ms = 30000;   /* 30 second timeout */
-    }
-    
-    /* Initialize position to zero */
-    memset(&ctx->position, 0, sizeof(kin_steps_t));
-    
-    /* Disable motors initially */
-    hal_stepper_enable(false);
-}
-
-void stepper_reset(stepper_context_t *ctx) {
-    if (!ctx) {
-        return;
-    }
-    
-    /* Stop any current motion */
-    ctx->state = STEPPER_IDLE;
-    ctx->current_block = NULL;
-    
-    /* Clear step counters */
-    memset(ctx->step_count, 0, sizeof(ctx->step_count));
-    memset(ctx->target_steps, 0, sizeof(ctx->target_steps));
-    
-    /* Reset speed */
-    ctx->current_speed = 0.0f;
-    
-    /* Clear all step pulses */
-    clear_step_pulses();
-    
-    /* Disable motors if configured */
-    if (ctx->config.idle_disable) {
-        hal_stepper_enable(false);
-        ctx->config.motors_enabled = false;
-    }
-}
-
-bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block) {
-    if (!ctx || !block) {
-        return false;
-    }
-    
-    /* Can't load a new block if not idle */
-    if (ctx->state != STEPPER_IDLE) {
-        return false;
-    }
-    
-    /* Validate the block */
-    if (!planner_block_validate(block)) {
-        return false;
-    }
-    
-    /* Convert block to step counts */
-    uint8_t dir_bits = 0;
-    if (!block_to_steps(block, ctx->target_steps, &dir_bits)) {
-        return false;
-    }
-    
-    /* Set the block */
-    ctx->current_block = block;
-    
-    /* Reset step counters */
-    memset(ctx->step_count, 0, sizeof(ctx->step_count));
-    
-    /* Set direction pins */
-    set_directions(dir_bits);
-    
-    /* Wait for direction setup time */
-    delay_us(ctx->config.dir_setup_us);
-    
-    /* Calculate initial step interval from entry speed */
-    /* Convert speed from mm/min to steps/s, then to interval in us */
-    if (block->entry_speed > 0.0f) {
-        /* Simplified calculation - assumes 1:1 mm to steps */
-        float steps_per_sec = block->entry_speed / 60.0f;
-        if (steps_per_sec > 0.0f) {
-            ctx->step_interval_us = (uint32_t)(1000000.0f / steps_per_sec);
-        } else {
-            ctx->step_interval_us = DEFAULT_STEP_INTERVAL_US;
-        }
-    } else {
-        ctx->step_interval_us = DEFAULT_STEP_INTERVAL_US;
-    }
-    
-    ctx->current_speed = block->entry_speed;
-    
-    /* Enable motors if not already enabled */
-    if (!ctx->config.motors_enabled) {
-        hal_stepper_enable(true);
-        ctx->config.motors_enabled = true;
-    }
-    
-    /* Start executing */
-    ctx->state = STEPPER_RUNNING;
-    ctx->last_step_time_us = hal_micros();
-    
-    return true;
-}
-
-void stepper_update(stepper_context_t *ctx) {
-    if (!ctx) {
-        return;
-    }
-    
-    uint32_t now_us = hal_micros();
-    
-    switch (ctx->state) {
-        case STEPPER_IDLE:
-            /* Check idle timeout for motor disable */
-            if (ctx->config.idle_disable && ctx->config.motors_enabled) {
-                uint32_t now_ms = hal_millis();
-                if (ctx->idle_start_time_ms > 0) {
-                    uint32_t idle_time = now_ms - ctx->idle_start_time_ms;
-                    if (idle_time >= ctx->config.idle_timeout_ms) {
-                        hal_stepper_enable(false);
-                        ctx->config.motors_enabled = false;
-                    }
-                }
-            }
-            break;
-            
-        case STEPPER_RUNNING:
-            /* Check if it's time for the next step */
-            if (now_us - ctx->last_step_time_us >= ctx->step_interval_us) {
-                bool steps_remaining = false;
-                
-                /* Generate step pulses for axes that need them */
-                for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
-                    if (ctx->step_count[axis] < ctx->target_steps[axis]) {
-                        hal_stepper_step_pulse(axis);
-                        ctx->step_count[axis]++;
-                        steps_remaining = true;
-                        
-                        /* Update position */
-                        if (ctx->current_block && 
-                            (ctx->current_block->direction_bits & (1 << axis))) {
-                            ctx->position.v[axis]++;
-                        } else {
-                            ctx->position.v[axis]--;
-                        }
-                    }
-                }
-                
-                /* Wait for pulse duration */
-                delay_us(ctx->config.step_pulse_us);
-                
-                /* Clear step pulses */
-                clear_step_pulses();
-                
-                /* Update last step time */
-                ctx->last_step_time_us = now_us;
-                
-                /* Check if block is complete */
-                if (!steps_remaining) {
-                    /* Block finished */
-                    ctx->current_block = NULL;
-                    ctx->state = STEPPER_IDLE;
-                    ctx->current_speed = 0.0f;
-                    ctx->idle_start_time_ms = hal_millis();
-                }
-            }
-            break;
-            
-        case STEPPER_HOLD:
-            /* Motion paused - do nothing */
-            break;
-            
-        case STEPPER_STOPPING:
-            /* Decelerate and stop */
-            ctx->state = STEPPER_IDLE;
-            ctx->current_block = NULL;
-            ctx->current_speed = 0.0f;
-            clear_step_pulses();
-            ctx->idle_start_time_ms = hal_millis();
-            break;
-    }
-}
-
-/* ----------------------------- Motion control ----------------------------- */
-
-void stepper_enable_motors(stepper_context_t *ctx, bool enable) {
-    if (!ctx) {
-        return;
-    }
-    
-    hal_stepper_enable(enable);
-    ctx->config.motors_enabled = enable;
-    
-    if (!enable) {
-        /* Motors disabled - ensure we're not running */
-        if (ctx->state != STEPPER_IDLE) {
-            stepper_stop(ctx);
-        }
-    }
-}
-
-bool stepper_motors_enabled(const stepper_context_t *ctx) {
-    if (!ctx) {
-        return false;
-    }
-    return ctx->config.motors_enabled;
-}
-
-void stepper_hold(stepper_context_t *ctx) {
-    if (!ctx) {
-        return;
-    }
-    
-    if (ctx->state == STEPPER_RUNNING) {
-        ctx->state = STEPPER_HOLD;
-    }
-}
-
-void stepper_resume(stepper_context_t *ctx) {
-    if (!ctx) {
-        return;
-    }
-    
-    if (ctx->state == STEPPER_HOLD) {
-        ctx->state = STEPPER_RUNNING;
-        ctx->last_step_time_us = hal_micros();
-    }
-}
-
-void stepper_stop(stepper_context_t *ctx) {
-    if (!ctx) {
-        return;
-    }
-    
-    ctx->state = STEPPER_STOPPING;
-}
-
-/* ----------------------------- Status queries ----------------------------- */
-
-stepper_state_t stepper_get_state(const stepper_context_t *ctx) {
-    if (!ctx) {
-        return STEPPER_IDLE;
-    }
-    return ctx->state;
-}
-
-bool stepper_is_idle(const stepper_context_t *ctx) {
-    if (!ctx) {
-        return true;
-    }
-    return ctx->state == STEPPER_IDLE;
-}
-
-bool stepper_is_executing(const stepper_context_t *ctx) {
-    if (!ctx) {
-        return false;
-    }
-    return ctx->current_block != NULL;
-}
-
-void stepper_get_position(const stepper_context_t *ctx, kin_steps_t *out_pos) {
-    if (!ctx || !out_pos) {
-        return;
-    }
-    *out_pos = ctx->position;
-}
-
-void stepper_get_cart_position(const stepper_context_t *ctx, kin_cart_t *out_cart) {
-    if (!ctx || !out_cart) {
-        return;
-    }
-    
-    /* Use kinematics to convert steps to Cartesian coordinates */
-    if (g_kin.steps_to_cart) {
-        g_kin.steps_to_cart(&ctx->position, out_cart);
-    } else {
-        /* Fallback: zero position */
-        memset(out_cart, 0, sizeof(kin_cart_t));
-    }
-}
-
-/* ----------------------------- Configuration ----------------------------- */
-
-void stepper_set_config(stepper_context_t *ctx, const stepper_config_t *config) {
-    if (!ctx || !config) {
-        return;
-    }
-    
-    ctx->config = *config;
-}
-
-void stepper_get_config(const stepper_context_t *ctx, stepper_config_t *out_config) {
-    if (!ctx || !out_config) {
-        return;
-    }
-    
-    *out_config = ctx->config;
-}
+/* stepper.c - Stepper motor control implementation */
+
+#include "stepper.h"
+#include "isr_latency.h"
+#include "profile.h"
+#include "system_state.h"
+#include <string.h>
+#include <math.h>
+
+/* Constants */
+#define DEFAULT_STEP_INTERVAL_US 1000  /* Default step interval: 1ms */
+
+/* Internal helper functions */
+
+/* Convert microseconds to step timer ticks */
+static uint32_t us_to_ticks(uint32_t us) {
+    return (uint32_t)(((uint64_t)us * HAL_STEP_TIMER_HZ) / 1000000u);
+}
+
+/* Segment ring handoff between prep (producer, foreground) and the step ISR
+ * (consumer). The release store of an index publishes the segment and block
+ * writes before it; the acquire load on the other side orders them before
+ * the reads that follow (a DMB on Cortex-M4). */
+#define SEGMENT_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SEGMENT_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+static uint8_t segment_next(uint8_t i) {
+    return (uint8_t)((i + 1u) % STEPPER_SEGMENT_BUFFER_SIZE);
+}
+
+static uint8_t segment_count(const stepper_context_t *ctx) {
+    return (uint8_t)((ctx->segment_head + STEPPER_SEGMENT_BUFFER_SIZE -
+                      SEGMENT_LOAD_ACQUIRE(&ctx->segment_tail)) %
+                     STEPPER_SEGMENT_BUFFER_SIZE);
+}
+
+/* Drop all queued segments, the ISR's active segment and the block being
+ * prepared. Only call with the step timer stopped.
+ */
+static void segment_buffer_flush(stepper_context_t *ctx) {
+    ctx->segment_head = 0;
+    ctx->segment_tail = 0;
+    ctx->exec_block = NULL;
+    ctx->exec_steps_left = 0;
+    ctx->current_block = NULL;
+    ctx->current_from_planner = false;
+    memset(&ctx->prep, 0, sizeof(ctx->prep));
+}
+
+/* Pulses end step_pulse_us after they rise, whatever the step period */
+static void step_timer_start(stepper_context_t *ctx, uint32_t period_ticks) {
+    hal_stepper_set_pulse_width(us_to_ticks(ctx->config.step_pulse_us));
+    ctx->timer_running = true;
+    hal_step_timer_start(period_ticks);
+}
+
+static void step_timer_stop(stepper_context_t *ctx) {
+    hal_step_timer_stop();
+    ctx->timer_running = false;
+}
+
+/* Laser mode: the laser only fires while moving. Only call with the step
+ * timer stopped. */
+static void laser_off(stepper_context_t *ctx) {
+    if (!ctx->config.laser_mode) {
+        return;
+    }
+    if (ctx->spindle_pwm > 0.0f || ctx->spindle_dir != HAL_SPINDLE_OFF) {
+        hal_spindle_set(HAL_SPINDLE_OFF, 0.0f);
+    }
+    ctx->spindle_pwm = 0.0f;
+    ctx->spindle_dir = HAL_SPINDLE_OFF;
+}
+
+/* A hold or stop is slowing the machine down */
+static bool decelerating(const stepper_context_t *ctx) {
+    return ctx->state == STEPPER_HOLDING || ctx->state == STEPPER_STOPPING;
+}
+
+/* HAL step timer callback */
+static void step_timer_cb(void *user) {
+    ISR_LATENCY_ENTER(entry);
+    PROFILE_BEGIN(t0);
+    stepper_isr((stepper_context_t *)user);
+    PROFILE_END(PROFILE_ZONE_STEP_ISR, t0);
+    ISR_LATENCY_EXIT(entry);
+}
+
+/* Set direction pins for all axes */
+static void set_directions(uint8_t dir_bits) {
+    for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
+        bool dir_positive = (dir_bits & (1 << axis)) != 0;
+        hal_stepper_set_dir(axis, dir_positive);
+    }
+}
+
+/* Clear step pulses for all axes */
+static void clear_step_pulses(void) {
+    for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
+        hal_stepper_step_clear(axis);
+    }
+}
+
+/* Floor on the step timer period: the pulse, then at least as long low
+ * (never under STEPPER_MIN_STEP_LOW_US) before the next rising edge */
+static uint32_t min_period_ticks(const stepper_context_t *ctx) {
+    uint32_t pulse = us_to_ticks(ctx->config.step_pulse_us);
+    uint32_t low = us_to_ticks(STEPPER_MIN_STEP_LOW_US);
+    uint32_t min_period = pulse + (low > pulse ? low : pulse);
+    return min_period < STEPPER_MIN_PERIOD_TICKS ? STEPPER_MIN_PERIOD_TICKS : min_period;
+}
+
+/* AMASS oversampling level for a step period */
+static uint8_t amass_level_for(const stepper_context_t *ctx, uint32_t period) {
+    if (!ctx->config.amass_enabled || period <= STEPPER_AMASS_LEVEL1) {
+        return 0;
+    }
+    if (period <= STEPPER_AMASS_LEVEL2) {
+        return 1;
+    }
+    if (period <= STEPPER_AMASS_LEVEL3) {
+        return 2;
+    }
+    return 3;
+}
+
+/* ----------------------------- Velocity profile ----------------------------- */
+
+/* Distance fraction covered by a ramp at normalised time u (0..1), relative
+ * to a ramp of duration 1 whose speed goes from 0 to 1.
+ * Trapezoid: v = u, S-curve: v = 3u^2 - 2u^3 (smoothstep). Both cover 1/2;
+ * the S-curve peaks at 1.5x the mean acceleration, with jerk 6 dv / T^2
+ * at the ends.
+ */
+static float ramp_shape(stepper_profile_t profile, float u) {
+    if (profile == STEPPER_PROFILE_SCURVE) {
+        return u * u * u - 0.5f * u * u * u * u;
+    }
+    return 0.5f * u * u;
+}
+
+static float ramp_shape_speed(stepper_profile_t profile, float u) {
+    if (profile == STEPPER_PROFILE_SCURVE) {
+        return u * u * (3.0f - 2.0f * u);
+    }
+    return u;
+}
+
+/* Mean ramp acceleration that keeps the peak at the limit a */
+static float ramp_mean_accel(const stepper_context_t *ctx, float a) {
+    return ctx->config.profile == STEPPER_PROFILE_SCURVE ? a / 1.5f : a;
+}
+
+static bool ramp_jerk_limited(const stepper_context_t *ctx) {
+    return ctx->config.profile == STEPPER_PROFILE_SCURVE && ctx->config.jerk_mm_per_s3 > 0.0f;
+}
+
+/* The ramps the planner plans speeds for: the same model, so a planned
+ * exit speed is always within reach */
+static planner_ramp_t stepper_ramp(const stepper_context_t *ctx) {
+    planner_ramp_t ramp;
+    ramp.scurve = ctx->config.profile == STEPPER_PROFILE_SCURVE;
+    ramp.jerk_mm_per_s3 = ctx->config.jerk_mm_per_s3;
+    return ramp;
+}
+
+/* Duration of a ramp changing speed by dv: long enough for the peak
+ * acceleration, and on a jerk limit for the peak jerk */
+static float ramp_time(const stepper_context_t *ctx, float a, float dv) {
+    const planner_ramp_t ramp = stepper_ramp(ctx);
+    return planner_ramp_time(&ramp, a, dv);
+}
+
+/* Distance covered ramping from va to vb */
+static float ramp_mm(const stepper_context_t *ctx, float a, float va, float vb) {
+    const planner_ramp_t ramp = stepper_ramp(ctx);
+    return planner_ramp_mm(&ramp, a, va, vb);
+}
+
+/* With a jerk limit ramp distances have no closed form: move vb back
+ * towards va until the ramp fits in length */
+static float ramp_reach(const stepper_context_t *ctx, float a, float va, float vb, float length) {
+    if (!ramp_jerk_limited(ctx) || ramp_mm(ctx, a, va, vb) <= length) {
+        return vb;
+    }
+    float lo = va;
+    for (int i = 0; i < 20; i++) {
+        float mid = 0.5f * (lo + vb);
+        if (ramp_mm(ctx, a, va, mid) <= length) lo = mid; else vb = mid;
+    }
+    return lo;
+}
+
+/* Same for the peak of a v0 -> vp -> v1 profile: lower vp towards lo,
+ * which fits, until both ramps do */
+static float ramp_peak(const stepper_context_t *ctx, float a, float v0, float vp, float v1,
+                       float lo, float length) {
+    if (!ramp_jerk_limited(ctx) ||
+        ramp_mm(ctx, a, v0, vp) + ramp_mm(ctx, a, vp, v1) <= length) {
+        return vp;
+    }
+    for (int i = 0; i < 20; i++) {
+        float mid = 0.5f * (lo + vp);
+        if (ramp_mm(ctx, a, v0, mid) + ramp_mm(ctx, a, mid, v1) <= length) lo = mid; else vp = mid;
+    }
+    return lo;
+}
+
+static float profile_duration(const stepper_prep_t *prep) {
+    return prep->t_accel + prep->t_cruise + prep->t_decel;
+}
+
+/* Distance into the current profile at time t */
+static float profile_position(const stepper_context_t *ctx, float t) {
+    const stepper_prep_t *prep = &ctx->prep;
+    stepper_profile_t shape = ctx->config.profile;
+    
+    if (t < prep->t_accel) {
+        float u = t / prep->t_accel;
+        return prep->t_accel * (prep->v_entry * u +
+                                (prep->v_peak - prep->v_entry) * ramp_shape(shape, u));
+    }
+    t -= prep->t_accel;
+    if (t <= prep->t_cruise || prep->t_decel <= 0.0f) {
+        return prep->mm_accel + prep->v_peak * t;
+    }
+    t -= prep->t_cruise;
+    if (t > prep->t_decel) {
+        t = prep->t_decel;
+    }
+    float u = t / prep->t_decel;
+    return prep->mm_accel + prep->mm_cruise +
+           prep->t_decel * (prep->v_peak * u - (prep->v_peak - prep->v_exit) * ramp_shape(shape, u));
+}
+
+/* Speed at time t into the current profile */
+static float profile_speed(const stepper_context_t *ctx, float t) {
+    const stepper_prep_t *prep = &ctx->prep;
+    stepper_profile_t shape = ctx->config.profile;
+    
+    if (t < prep->t_accel) {
+        float u = t / prep->t_accel;
+        return prep->v_entry + (prep->v_peak - prep->v_entry) * ramp_shape_speed(shape, u);
+    }
+    t -= prep->t_accel + prep->t_cruise;
+    if (t <= 0.0f || prep->t_decel <= 0.0f) {
+        return prep->v_peak;
+    }
+    float u = t < prep->t_decel ? t / prep->t_decel : 1.0f;
+    return prep->v_peak - (prep->v_peak - prep->v_exit) * ramp_shape_speed(shape, u);
+}
+
+/* Block nominal speed with the feed or rapid override applied (mm/min),
+ * never above the block's axis-limited rapid rate */
+static float override_speed(const stepper_context_t *ctx, const planner_block_t *block) {
+    uint8_t percent = block->rapid_flag ? ctx->rapid_override : ctx->feed_override;
+    float speed = block->nominal_speed * (float)percent * 0.01f;
+    if (block->rapid_rate > 0.0f && speed > block->rapid_rate) {
+        speed = block->rapid_rate;
+    }
+    return speed;
+}
+
+/* Laser mode: spindle PWM for a segment moving at speed (mm/s), in
+ * proportion to the block's programmed speed and scaled by the spindle
+ * override. Rapids run with the laser off. Returns -1 outside laser mode (the ISR leaves the spindle alone). */
+static float segment_spindle_pwm(const stepper_context_t *ctx, float speed) {
+    const planner_block_t *block = ctx->current_block;
+    
+    if (!ctx->config.laser_mode) {
+        return -1.0f;
+    }
+    if (block->rapid_flag || block->spindle_dir == HAL_SPINDLE_OFF) {
+        return 0.0f;
+    }
+    float programmed = override_speed(ctx, block) / 60.0f;
+    float ratio = programmed > 0.0f ? speed / programmed : 1.0f;
+    if (ratio > 1.0f) {
+        ratio = 1.0f;
+    }
+    float rpm = block->spindle_speed * (float)ctx->spindle_override * 0.01f;
+    return stepper_spindle_pwm(ctx, rpm) * ratio;
+}
+
+/* Build the profile for the rest of the prep block: from speed v0 over
+ * distance length to exit speed v1 (mm/s), with ramps whose peak
+ * acceleration is block->acceleration (and peak jerk the jerk limit).
+ * An override below the planned speeds ramps v0 down to the nominal speed
+ * and lowers the exit; the next block starts from whatever speed is left.
+ */
+static void profile_plan(stepper_context_t *ctx, float v0, float length, float v1) {
+    stepper_prep_t *prep = &ctx->prep;
+    const planner_block_t *block = ctx->current_block;
+    float a = block->acceleration / 3600.0f;  /* mm/min^2 -> mm/s^2 */
+    float vn = (block->nominal_speed > 0.0f ? override_speed(ctx, block) : block->entry_speed) / 60.0f;
+    
+    if (vn <= 0.0f) {
+        /* No speed given: default step interval */
+        vn = (1000000.0f / DEFAULT_STEP_INTERVAL_US) / prep->events_per_mm;
+    }
+    
+    prep->time = 0.0f;
+    prep->accel = a;
+    
+    if (a <= 0.0f) {
+        /* No acceleration limit: run the whole block at nominal speed */
+        prep->v_entry = vn;
+        prep->v_peak = vn;
+        prep->v_exit = vn;
+        prep->t_accel = 0.0f;
+        prep->t_decel = 0.0f;
+        prep->mm_accel = 0.0f;
+        prep->mm_cruise = length;
+        prep->t_cruise = length / vn;
+        prep->events_end = prep->events_total;
+        return;
+    }
+    
+    /* Keep the ends reachable within the remaining length */
+    float am = ramp_mean_accel(ctx, a);
+    if (v1 > vn) {
+        v1 = vn;
+    }
+    float reach_sq = 2.0f * am * length;
+    if (v1 * v1 > v0 * v0 + reach_sq) {
+        v1 = sqrtf(v0 * v0 + reach_sq);
+    }
+    if (v1 > v0) {
+        v1 = ramp_reach(ctx, a, v0, v1, length);
+    }
+    if (v0 > v1 && ramp_mm(ctx, a, v0, v1) > length) {
+        /* The planner sizes exits for these ramps, so only rounding gets
+         * here. Never leave faster than planned: ramp down over the whole
+         * length. */
+        prep->v_entry = v0;
+        prep->v_peak = v0;
+        prep->v_exit = v1;
+        prep->events_end = prep->events_total;
+        prep->mm_accel = 0.0f;
+        prep->mm_cruise = 0.0f;
+        prep->t_accel = 0.0f;
+        prep->t_cruise = 0.0f;
+        prep->t_decel = 2.0f * length / (v0 + v1);
+        return;
+    }
+    
+    float vp = vn;
+    if (vp < v1) vp = v1;
+    
+    if (v0 > vp) {
+        /* Entering above the (overridden) nominal speed: the first ramp goes
+         * down to it. v1 <= vp, and the check above keeps the ramp from v0
+         * to v1 within length (a jerk limit may lower vp towards v1). */
+        vp = ramp_peak(ctx, a, v0, vp, v1, v1, length);
+        float mm_down = ramp_mm(ctx, a, v0, vp);
+        float mm_decel = ramp_mm(ctx, a, vp, v1);
+        prep->v_entry = v0;
+        prep->v_peak = vp;
+        prep->v_exit = v1;
+        prep->events_end = prep->events_total;
+        prep->mm_accel = mm_down;
+        prep->mm_cruise = length - mm_down - mm_decel;
+        if (prep->mm_cruise < 0.0f) prep->mm_cruise = 0.0f;
+        prep->t_accel = ramp_time(ctx, a, v0 - vp);
+        prep->t_decel = ramp_time(ctx, a, vp - v1);
+        prep->t_cruise = vp > 0.0f ? prep->mm_cruise / vp : 0.0f;
+        return;
+    }
+    
+    float mm_accel = ramp_mm(ctx, a, v0, vp);
+    float mm_decel = ramp_mm(ctx, a, vp, v1);
+    if (mm_accel + mm_decel > length) {
+        /* Triangle: peak where the ramps meet */
+        vp = sqrtf(0.5f * (reach_sq + v0 * v0 + v1 * v1));
+        if (vp < v0) vp = v0;
+        if (vp < v1) vp = v1;
+        vp = ramp_peak(ctx, a, v0, vp, v1, v0 > v1 ? v0 : v1, length);
+        mm_accel = ramp_mm(ctx, a, v0, vp);
+        mm_decel = length - mm_accel;
+        if (mm_decel < 0.0f) mm_decel = 0.0f;
+    }
+    
+    prep->v_entry = v0;
+    prep->v_peak = vp;
+    prep->v_exit = v1;
+    prep->events_end = prep->events_total;
+    prep->mm_accel = mm_accel;
+    prep->mm_cruise = length - mm_accel - mm_decel;
+    if (prep->mm_cruise < 0.0f) prep->mm_cruise = 0.0f;
+    prep->t_accel = ramp_time(ctx, a, vp - v0);
+    prep->t_decel = ramp_time(ctx, a, vp - v1);
+    prep->t_cruise = vp > 0.0f ? prep->mm_cruise / vp : 0.0f;
+}
+
+/* Build a stop ramp for the rest of the prep block: decelerate from v0 at
+ * once, to rest if the block is long enough, else to the speed left at its
+ * end (the next block continues the ramp). */
+static void profile_plan_stop(stepper_context_t *ctx, float v0, float length) {
+    stepper_prep_t *prep = &ctx->prep;
+    float a = ctx->current_block->acceleration / 3600.0f;  /* mm/min^2 -> mm/s^2 */
+    float v1 = 0.0f;
+    float mm_decel = 0.0f;
+    
+    if (a > 0.0f) {
+        mm_decel = ramp_mm(ctx, a, v0, 0.0f);
+        if (mm_decel >= length) {
+            float v1_sq = v0 * v0 - 2.0f * ramp_mean_accel(ctx, a) * length;
+            mm_decel = length;
+            v1 = ramp_reach(ctx, a, v0, v1_sq > 0.0f ? sqrtf(v1_sq) : 0.0f, length);
+        }
+    }
+    
+    prep->time = 0.0f;
+    prep->accel = a;
+    prep->v_entry = v0;
+    prep->v_peak = v0;
+    prep->v_exit = v1;
+    prep->t_accel = 0.0f;
+    prep->t_cruise = 0.0f;
+    prep->t_decel = a > 0.0f ? ramp_time(ctx, a, v0 - v1) : 0.0f;
+    prep->mm_accel = 0.0f;
+    prep->mm_cruise = 0.0f;
+    
+    if (mm_decel >= length) {
+        prep->events_end = prep->events_total;
+    } else {
+        /* Rest falls between steps: stop on the step before it */
+        float events = (prep->mm_base + mm_decel) * prep->events_per_mm + 1e-3f;
+        prep->events_end = events >= (float)prep->events_total ? prep->events_total : (uint32_t)events;
+        if (prep->events_end < prep->events_done) {
+            prep->events_end = prep->events_done;
+        }
+    }
+}
+
+/* ----------------------------- Segment preparation ----------------------------- */
+
+/* Plan the rest of the prep block from speed v0 (mm/s), starting mm_base
+ * into it: a stop ramp while decelerating, else the normal profile */
+static void prep_plan_remaining(stepper_context_t *ctx, float v0) {
+    stepper_prep_t *prep = &ctx->prep;
+    float length = prep->mm_total - prep->mm_base;
+    
+    prep->exit_speed_used = ctx->current_block->exit_speed;
+    if (decelerating(ctx)) {
+        profile_plan_stop(ctx, v0, length);
+    } else {
+        profile_plan(ctx, v0, length, prep->exit_speed_used / 60.0f);
+    }
+}
+
+/* Start preparing a block: copy its step data for the ISR and plan its profile */
+static void prep_start_block(stepper_context_t *ctx, planner_block_t *block, bool from_planner) {
+    stepper_prep_t *prep = &ctx->prep;
+    
+    /* Blocks that carry only step_event_count (no per-axis counts) drive X */
+    uint32_t steps[HAL_AXIS_MAX];
+    uint32_t event_count = 0;
+    for (uint8_t i = 0; i < HAL_AXIS_MAX; i++) {
+        steps[i] = (i < KIN_MAX_JOINT_AXES) ? block->steps[i] : 0;
+        if (steps[i] > event_count) {
+            event_count = steps[i];
+        }
+    }
+    if (event_count == 0 && block->step_event_count > 0) {
+        steps[HAL_AXIS_X] = block->step_event_count;
+        event_count = block->step_event_count;
+    }
+    
+    /* Blocks without steps never reach the ISR and need no buffer entry */
+    if (event_count > 0) {
+        ctx->prep_block_index = (uint8_t)((ctx->prep_block_index + 1u) % STEPPER_BLOCK_BUFFER_SIZE);
+        stepper_block_t *st = &ctx->block_buffer[ctx->prep_block_index];
+        
+        /* Scale for AMASS so every oversampling level divides exactly */
+        for (uint8_t i = 0; i < HAL_AXIS_MAX; i++) {
+            st->steps[i] = steps[i] << STEPPER_AMASS_MAX_LEVEL;
+        }
+        st->step_event_count = event_count << STEPPER_AMASS_MAX_LEVEL;
+        st->direction_bits = block->direction_bits;
+        st->spindle_dir = block->spindle_dir;
+    }
+    
+    ctx->current_block = block;
+    ctx->current_from_planner = from_planner;
+    
+    /* Blocks without a length fall back to 1 step per mm */
+    prep->events_total = event_count;
+    prep->events_done = 0;
+    prep->mm_total = block->millimeters > 0.0f ? block->millimeters : (float)event_count;
+    prep->events_per_mm = prep->mm_total > 0.0f ? (float)event_count / prep->mm_total : 1.0f;
+    prep->mm_base = 0.0f;
+    
+    float v0 = prep->carry_valid ? prep->carry_speed : block->entry_speed / 60.0f;
+    prep_plan_remaining(ctx, v0);
+}
+
+/* Replan the remainder of the prep block from speed v_now at the point
+ * preparation has reached (planner exit change, hold, stop or resume) */
+static void prep_replan(stepper_context_t *ctx, float v_now) {
+    stepper_prep_t *prep = &ctx->prep;
+    
+    prep->mm_base += profile_position(ctx, prep->time);
+    prep_plan_remaining(ctx, v_now);
+}
+
+/* Speed preparation has reached, carried into the next block if none */
+static float prep_speed(const stepper_context_t *ctx) {
+    if (!ctx->current_block) {
+        return ctx->prep.carry_valid ? ctx->prep.carry_speed : 0.0f;
+    }
+    return profile_speed(ctx, ctx->prep.time);
+}
+
+/* Decelerating and the stop ramp is fully queued: nothing more to prepare */
+static bool prep_at_rest(const stepper_context_t *ctx) {
+    const stepper_prep_t *prep = &ctx->prep;
+    
+    if (!decelerating(ctx)) {
+        return false;
+    }
+    if (!ctx->current_block) {
+        return !(prep->carry_valid && prep->carry_speed > 0.0f);
+    }
+    return prep->v_exit <= 0.0f && prep->time >= profile_duration(prep);
+}
+
+/* Fetch the next block to prepare; returns false if none is available */
+static bool prep_next_block(stepper_context_t *ctx) {
+    if (ctx->current_block) {
+        return true;
+    }
+    if (!ctx->planner) {
+        return false;
+    }
+    
+    planner_block_t *block = planner_peek_front(ctx->planner);
+    if (!block) {
+        return false;
+    }
+    prep_start_block(ctx, block, true);
+    return true;
+}
+
+/* Prep block fully queued: hand its exit speed to the next block */
+static void prep_finish_block(stepper_context_t *ctx) {
+    ctx->prep.carry_speed = ctx->prep.v_exit;
+    ctx->prep.carry_valid = ctx->prep.v_exit > 0.0f;
+    
+    if (ctx->current_from_planner) {
+        planner_discard_front(ctx->planner);
+    }
+    ctx->current_block = NULL;
+    ctx->current_from_planner = false;
+}
+
+/* Slice prep blocks into fixed-time segments until the buffer is full.
+ * Only calls that queue a segment are profiled. */
+static void prep_segments(stepper_context_t *ctx) {
+    PROFILE_BEGIN(t0);
+    stepper_prep_t *prep = &ctx->prep;
+    const float dt = STEPPER_SEGMENT_TIME_US * 1e-6f;
+    uint32_t min_period = min_period_ticks(ctx);
+    uint32_t queued = 0u;
+    
+    while (segment_count(ctx) < STEPPER_SEGMENT_BUFFER_SIZE - 1u) {
+        if (prep_at_rest(ctx) || !prep_next_block(ctx)) {
+            break;
+        }
+        if (prep->events_total == 0) {
+            /* Nothing to step: pass the speed straight through */
+            prep_finish_block(ctx);
+            continue;
+        }
+        if (ctx->state == STEPPER_RUNNING && ctx->current_from_planner &&
+            ctx->current_block->exit_speed != prep->exit_speed_used) {
+            /* The planner raised the exit speed */
+            prep_replan(ctx, profile_speed(ctx, prep->time));
+        }
+        
+        /* Advance at least one step event; slow ramps stretch the segment */
+        float duration = profile_duration(prep);
+        float t_end = prep->time;
+        uint32_t events_end = prep->events_done;
+        do {
+            t_end += dt;
+            if (t_end >= duration) {
+                t_end = duration;
+                events_end = prep->events_end;
+            } else {
+                /* Small bias so float error at exact step boundaries rounds up */
+                float mm = prep->mm_base + profile_position(ctx, t_end);
+                events_end = (uint32_t)(mm * prep->events_per_mm + 1e-3f);
+                if (events_end > prep->events_end) {
+                    events_end = prep->events_end;
+                }
+            }
+        } while (events_end == prep->events_done && t_end < duration);
+        
+        uint32_t n = events_end - prep->events_done;
+        if (n > 0) {
+            float ticks = (t_end - prep->time) * (float)HAL_STEP_TIMER_HZ / (float)n + 0.5f;
+            uint32_t period = ticks >= 4294967295.0f ? 0xFFFFFFFFu : (uint32_t)ticks;
+            if (period < min_period) {
+                period = min_period;
+            }
+            uint8_t level = amass_level_for(ctx, period);
+            if (n > (0xFFFFu >> level)) {
+                /* Oversized segment: keep the step period, end it early */
+                n = 0xFFFFu >> level;
+                events_end = prep->events_done + n;
+                t_end = prep->time + (float)period * (float)n / (float)HAL_STEP_TIMER_HZ;
+            }
+            
+            uint8_t head = ctx->segment_head;
+            stepper_segment_t *seg = &ctx->segment_buffer[head];
+            seg->n_step = (uint16_t)(n << level);
+            seg->period_ticks = period >> level;
+            seg->amass_level = level;
+            seg->block_index = ctx->prep_block_index;
+            seg->spindle_pwm = segment_spindle_pwm(ctx, profile_speed(ctx, 0.5f * (prep->time + t_end)));
+            
+            /* Publish only after the segment is fully written */
+            SEGMENT_STORE_RELEASE(&ctx->segment_head, segment_next(head));
+            queued++;
+        }
+        
+        prep->events_done = events_end;
+        prep->time = t_end;
+        ctx->current_speed = profile_speed(ctx, t_end) * 60.0f;
+        
+        if (prep->events_done >= prep->events_total) {
+            prep_finish_block(ctx);
+        }
+    }
+    
+    if (queued > 0u) {
+        PROFILE_END(PROFILE_ZONE_SEGMENT_PREP, t0);
+    }
+}
+
+/* Stop stepping now and drop every queued move (no deceleration) */
+static void halt_now(stepper_context_t *ctx) {
+    step_timer_stop(ctx);
+    segment_buffer_flush(ctx);
+    if (ctx->planner) {
+        planner_queue_clear(ctx->planner);
+    }
+    ctx->state = STEPPER_IDLE;
+    ctx->current_speed = 0.0f;
+    ctx->prep.carry_valid = false;
+    clear_step_pulses();
+    ctx->pulse_active = false;
+    laser_off(ctx);
+    ctx->idle_start_time_ms = hal_millis();
+}
+
+/* Apply the realtime requests posted since the last update */
+static void take_rt_requests(stepper_context_t *ctx) {
+    uint8_t bits = __atomic_exchange_n(&ctx->rt_request, 0u, __ATOMIC_ACQ_REL);
+    if (bits & STEPPER_RT_STOP) {
+        halt_now(ctx);
+    } else if (bits & STEPPER_RT_HOLD) {
+        stepper_hold(ctx);
+    } else if (bits & STEPPER_RT_RESUME) {
+        stepper_resume(ctx);
+    }
+}
+
+/* ----------------------------- Public API Implementation ----------------------------- */
+
+void stepper_init(stepper_context_t *ctx, const stepper_config_t *config) {
+    if (!ctx) {
+        return;
+    }
+    
+    /* Clear context */
+    memset(ctx, 0, sizeof(stepper_context_t));
+    
+    /* Set initial state */
+    ctx->state = STEPPER_IDLE;
+    
+    /* Copy configuration */
+    if (config) {
+        ctx->config = *config;
+    } else {
+        /* Set default configuration */
+        ctx->config.step_pulse_us = 10;        /* 10 microsecond pulse */
+        ctx->config.step_idle_delay_us = 100;  /* 100 us between steps */
+        ctx->config.dir_setup_us = 5;          /* 5 us direction setup */
+        ctx->config.motors_enabled = false;
+        ctx->config.idle_disable = true;
+        ctx->config.idle_timeout_ms = 30000;   /* 30 second timeout */
+        ctx->config.amass_enabled = true;
+        ctx->config.profile = STEPPER_PROFILE_TRAPEZOID;
+        ctx->config.jerk_mm_per_s3 = 0.0f;    /* S-curve: acceleration limit only */
+        ctx->config.laser_mode = false;
+        ctx->config.spindle_max_rpm = 1000.0f;
+        ctx->config.spindle_min_rpm = 0.0f;
+    }
+    ctx->dir_setup_ticks = us_to_ticks(ctx->config.dir_setup_us);
+    ctx->feed_override = 100u;
+    ctx->rapid_override = 100u;
+    ctx->spindle_override = 100u;
+    
+    /* Initialize position to zero */
+    memset(&ctx->position, 0, sizeof(kin_steps_t));
+    
+    /* Route step timer interrupts to this context */
+    hal_step_timer_init(step_timer_cb, ctx);
+    
+    /* Disable motors initially */
+    hal_stepper_enable(false);
+}
+
+void stepper_reset(stepper_context_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    
+    /* Stop any current motion */
+    step_timer_stop(ctx);
+    segment_buffer_flush(ctx);
+    ctx->state = STEPPER_IDLE;
+    ctx->rt_request = 0u;
+    
+    /* Clear step counters */
+    memset(ctx->dda_steps, 0, sizeof(ctx->dda_steps));
+    memset(ctx->dda_counter, 0, sizeof(ctx->dda_counter));
+    
+    /* Reset speed */
+    ctx->current_speed = 0.0f;
+    
+    /* Clear all step pulses */
+    clear_step_pulses();
+    ctx->pulse_active = false;
+    laser_off(ctx);
+    
+    /* Disable motors if configured */
+    if (ctx->config.idle_disable) {
+        hal_stepper_enable(false);
+        ctx->config.motors_enabled = false;
+    }
+}
+
+/* Leave IDLE: enable drivers and let stepper_update() start preparing */
+static void start_running(stepper_context_t *ctx) {
+    /* Enable motors if not already enabled */
+    if (!ctx->config.motors_enabled) {
+        hal_stepper_enable(true);
+        ctx->config.motors_enabled = true;
+    }
+    
+    /* Start executing */
+    ctx->state = STEPPER_RUNNING;
+}
+
+bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block) {
+    if (!ctx || !block) {
+        return false;
+    }
+    
+    /* Can't load a new block if not idle */
+    if (ctx->state != STEPPER_IDLE) {
+        return false;
+    }
+    
+    /* Validate the block */
+    if (!planner_block_validate(block)) {
+        return false;
+    }
+    
+    /* Set the block and copy its step data for the ISR. Directions are set
+     * by the ISR together with their setup time. */
+    segment_buffer_flush(ctx);
+    prep_start_block(ctx, block, false);
+    ctx->current_speed = block->entry_speed;
+    
+    start_running(ctx);
+    return true;
+}
+
+void stepper_set_planner(stepper_context_t *ctx, planner_queue_t *planner) {
+    if (!ctx) {
+        return;
+    }
+    
+    ctx->planner = planner;
+    if (planner) {
+        const planner_ramp_t ramp = stepper_ramp(ctx);
+        planner_set_ramp(planner, &ramp);
+    }
+}
+
+void stepper_update(stepper_context_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    
+    take_rt_requests(ctx);
+    
+    switch (ctx->state) {
+        case STEPPER_IDLE:
+            /* Planner has work queued: start running */
+            if (ctx->planner && !planner_is_empty(ctx->planner)) {
+                start_running(ctx);
+                stepper_update(ctx);
+                break;
+            }
+            
+            /* Check idle timeout for motor disable */
+            if (ctx->config.idle_disable && ctx->config.motors_enabled) {
+                uint32_t now_ms = hal_millis();
+                if (ctx->idle_start_time_ms > 0) {
+                    uint32_t idle_time = now_ms - ctx->idle_start_time_ms;
+                    if (idle_time >= ctx->config.idle_timeout_ms) {
+                        hal_stepper_enable(false);
+                        ctx->config.motors_enabled = false;
+                    }
+                }
+            }
+            break;
+        
+        case STEPPER_RUNNING:
+        case STEPPER_HOLDING:
+        case STEPPER_STOPPING:
+            prep_segments(ctx);
+            
+            if (ctx->timer_running) {
+                break;
+            }
+            
+            if (ctx->exec_steps_left > 0 ||
+                ctx->segment_head != SEGMENT_LOAD_ACQUIRE(&ctx->segment_tail)) {
+                /* Arm the timer on start, after resume or after an underrun */
+                uint32_t first = ctx->exec_steps_left > 0
+                                     ? ctx->exec_period_ticks
+                                     : ctx->segment_buffer[ctx->segment_tail].period_ticks;
+                step_timer_start(ctx, first);
+            } else if (ctx->state == STEPPER_HOLDING) {
+                /* Last step of the stop ramp is out: the machine is at rest */
+                ctx->state = STEPPER_HOLD;
+                ctx->current_speed = 0.0f;
+                ctx->prep.carry_speed = 0.0f;
+                ctx->prep.carry_valid = true;
+                laser_off(ctx);
+            } else if (ctx->state == STEPPER_STOPPING) {
+                /* At rest: queued motion is discarded */
+                halt_now(ctx);
+            } else if (!ctx->current_block) {
+                /* ISR emitted the last step and stopped the timer */
+                segment_buffer_flush(ctx);
+                ctx->state = STEPPER_IDLE;
+                ctx->current_speed = 0.0f;
+                laser_off(ctx);
+                ctx->idle_start_time_ms = hal_millis();
+            }
+            break;
+        
+        case STEPPER_HOLD:
+            /* Motion paused - ISR has parked the timer */
+            break;
+    }
+}
+
+void stepper_isr(stepper_context_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    
+    /* The HAL ends each pulse after step_pulse_us; close any it left high
+     * (a zero pulse width) */
+    if (ctx->pulse_active) {
+        clear_step_pulses();
+        ctx->pulse_active = false;
+    }
+    
+    if (ctx->state == STEPPER_IDLE || ctx->state == STEPPER_HOLD ||
+        (__atomic_load_n(&ctx->rt_request, __ATOMIC_RELAXED) & STEPPER_RT_STOP)) {
+        /* Paused or stopped: park the timer, keep the active segment */
+        step_timer_stop(ctx);
+        return;
+    }
+    
+    if (ctx->exec_steps_left == 0) {
+        uint8_t tail = ctx->segment_tail;
+        if (tail == SEGMENT_LOAD_ACQUIRE(&ctx->segment_head)) {
+            /* Buffer empty: wait for stepper_update() to refill and re-arm */
+            step_timer_stop(ctx);
+            return;
+        }
+        
+        const stepper_segment_t *seg = &ctx->segment_buffer[tail];
+        const stepper_block_t *block = &ctx->block_buffer[seg->block_index];
+        ctx->exec_steps_left = seg->n_step;
+        ctx->exec_period_ticks = seg->period_ticks;
+        
+        if (seg->spindle_pwm >= 0.0f) {
+            /* Laser mode: power follows the segment's speed */
+            uint8_t dir = seg->spindle_pwm > 0.0f ? block->spindle_dir : (uint8_t)HAL_SPINDLE_OFF;
+            if (seg->spindle_pwm != ctx->spindle_pwm || dir != ctx->spindle_dir) {
+                hal_spindle_set((hal_spindle_dir_t)dir, seg->spindle_pwm);
+                ctx->spindle_pwm = seg->spindle_pwm;
+                ctx->spindle_dir = dir;
+            }
+        }
+        
+        if (block != ctx->exec_block) {
+            /* New block: start every accumulator half way so minor-axis
+             * steps are centred */
+            ctx->exec_block = block;
+            for (uint8_t axis = 0; axis < HAL_AXIS_MAX; axis++) {
+                ctx->dda_counter[axis] = block->step_event_count >> 1;
+                ctx->dir_sign[axis] = (block->direction_bits & (1u << axis)) ? 1 : -1;
+            }
+        }
+        for (uint8_t axis = 0; axis < HAL_AXIS_MAX; axis++) {
+            ctx->dda_steps[axis] = block->steps[axis] >> seg->amass_level;
+        }
+        /* Hand the slot back only once the segment has been read */
+        SEGMENT_STORE_RELEASE(&ctx->segment_tail, segment_next(tail));
+        
+        if (!ctx->dir_valid || block->direction_bits != ctx->dir_bits) {
+            /* Direction change: spend one short tick on setup time */
+            set_directions(block->direction_bits);
+            ctx->dir_bits = block->direction_bits;
+            ctx->dir_valid = true;
+            if (ctx->dir_setup_ticks > 0) {
+                hal_step_timer_set_period(ctx->dir_setup_ticks);
+                return;
+            }
+        }
+    }
+    
+    hal_step_timer_set_period(ctx->exec_period_ticks);
+    
+    /* Bresenham DDA: every axis whose accumulator overflows steps this tick */
+    uint32_t mask = 0;
+    uint32_t event_count = ctx->exec_block->step_event_count;
+    for (uint8_t axis = 0; axis < HAL_AXIS_MAX; axis++) {
+        ctx->dda_counter[axis] += ctx->dda_steps[axis];
+        if (ctx->dda_counter[axis] > event_count) {
+            ctx->dda_counter[axis] -= event_count;
+            ctx->position.v[axis] += ctx->dir_sign[axis];
+            mask |= (1u << axis);
+        }
+    }
+    if (mask) {
+        hal_stepper_pulse_mask(mask);
+        ctx->pulse_active = true;
+    }
+    
+    ctx->exec_steps_left--;
+}
+
+/* ----------------------------- Motion control ----------------------------- */
+
+void stepper_enable_motors(stepper_context_t *ctx, bool enable) {
+    if (!ctx) {
+        return;
+    }
+    
+    hal_stepper_enable(enable);
+    ctx->config.motors_enabled = enable;
+    
+    if (!enable) {
+        /* Motors disabled - steps would be lost, so no ramp down */
+        if (ctx->state != STEPPER_IDLE) {
+            halt_now(ctx);
+        }
+    }
+}
+
+bool stepper_motors_enabled(const stepper_context_t *ctx) {
+    if (!ctx) {
+        return false;
+    }
+    return ctx->config.motors_enabled;
+}
+
+void stepper_hold(stepper_context_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    
+    if (ctx->state == STEPPER_RUNNING) {
+        /* Segments already queued run out first, then the stop ramp */
+        ctx->state = STEPPER_HOLDING;
+        if (ctx->current_block) {
+            prep_replan(ctx, prep_speed(ctx));
+        }
+    }
+}
+
+void stepper_resume(stepper_context_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    
+    if (ctx->state == STEPPER_HOLD || ctx->state == STEPPER_HOLDING) {
+        /* Accelerate again from wherever the ramp has got to;
+         * stepper_update() re-arms the step timer */
+        float v_now = ctx->state == STEPPER_HOLD ? 0.0f : prep_speed(ctx);
+        ctx->state = STEPPER_RUNNING;
+        if (ctx->current_block) {
+            prep_replan(ctx, v_now);
+        }
+    }
+}
+
+void stepper_stop(stepper_context_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    
+    if (ctx->state == STEPPER_RUNNING) {
+        ctx->state = STEPPER_STOPPING;
+        if (ctx->current_block) {
+            prep_replan(ctx, prep_speed(ctx));
+        }
+    } else {
+        /* Already ramping down or at rest: stepper_update() drops the
+         * queue once the last step is out */
+        ctx->state = STEPPER_STOPPING;
+    }
+}
+
+void stepper_set_overrides(stepper_context_t *ctx, uint8_t feed_percent, uint8_t rapid_percent,
+                           uint8_t spindle_percent) {
+    if (!ctx) {
+        return;
+    }
+    /* Laser power is worked out per segment, nothing to replan */
+    ctx->spindle_override = spindle_percent;
+    if (feed_percent == ctx->feed_override && rapid_percent == ctx->rapid_override) {
+        return;
+    }
+    
+    ctx->feed_override = feed_percent;
+    ctx->rapid_override = rapid_percent;
+    
+    /* A hold or stop keeps its ramp; resume replans with the new values */
+    if (ctx->state == STEPPER_RUNNING && ctx->current_block) {
+        prep_replan(ctx, prep_speed(ctx));
+    }
+}
+
+float stepper_spindle_pwm(const stepper_context_t *ctx, float rpm) {
+    if (!ctx || rpm <= 0.0f || ctx->config.spindle_max_rpm <= 0.0f) {
+        return 0.0f;
+    }
+    if (rpm < ctx->config.spindle_min_rpm) {
+        rpm = ctx->config.spindle_min_rpm;
+    }
+    if (rpm >= ctx->config.spindle_max_rpm) {
+        return 1.0f;
+    }
+    return rpm / ctx->config.spindle_max_rpm;
+}
+
+void stepper_rt_request(stepper_context_t *ctx, uint8_t bits) {
+    if (!ctx) {
+        return;
+    }
+    
+    if (bits & STEPPER_RT_HOLD) {
+        __atomic_fetch_and(&ctx->rt_request, (uint8_t)~STEPPER_RT_RESUME, __ATOMIC_RELAXED);
+    } else if (bits & STEPPER_RT_RESUME) {
+        __atomic_fetch_and(&ctx->rt_request, (uint8_t)~STEPPER_RT_HOLD, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_or(&ctx->rt_request, bits, __ATOMIC_RELEASE);
+}
+
+/* ----------------------------- Status queries ----------------------------- */
+
+stepper_state_t stepper_get_state(const stepper_context_t *ctx) {
+    if (!ctx) {
+        return STEPPER_IDLE;
+    }
+    return ctx->state;
+}
+
+bool stepper_is_idle(const stepper_context_t *ctx) {
+    if (!ctx) {
+        return true;
+    }
+    return ctx->state == STEPPER_IDLE;
+}
+
+bool stepper_is_executing(const stepper_context_t *ctx) {
+    if (!ctx) {
+        return false;
+    }
+    return ctx->state != STEPPER_IDLE;
+}
+
+void stepper_get_position(const stepper_context_t *ctx, kin_steps_t *out_pos) {
+    if (!ctx || !out_pos) {
+        return;
+    }
+    *out_pos = ctx->position;
+}
+
+void stepper_get_cart_position(const stepper_context_t *ctx, kin_cart_t *out_cart) {
+    if (!ctx || !out_cart) {
+        return;
+    }
+    
+    /* Use kinematics to convert steps to Cartesian coordinates
+     * (zero position when no kinematics is installed) */
+    kinematics_steps_to_cart(&ctx->position, out_cart);
+}
+
+/* ----------------------------- Configuration ----------------------------- */
+
+void stepper_set_config(stepper_context_t *ctx, const stepper_config_t *config) {
+    if (!ctx || !config) {
+        return;
+    }
+    
+    ctx->config = *config;
+    ctx->dir_setup_ticks = us_to_ticks(ctx->config.dir_setup_us);
+    if (ctx->planner) {
+        const planner_ramp_t ramp = stepper_ramp(ctx);
+        planner_set_ramp(ctx->planner, &ramp);
+    }
+}
+
+void stepper_get_config(const stepper_context_t *ctx, stepper_config_t *out_config) {
+    if (!ctx || !out_config) {
+        return;
+    }
+    
+    *out_config = ctx->config;
+}
@@ -56,6 +56,7 @@
 
 /* External variables --------------------------------------------------------*/
 extern UART_HandleTypeDef hlpuart1;
+extern DMA_HandleTypeDef hdma_lpuart1_rx;
 
 /* USER CODE BEGIN EV */
 
@@ -204,6 +205,11 @@ void LPUART1_IRQHandler(void)
   HAL_UART_IRQHandler(&hlpuart1);
 }
 
+void DMA1_Channel1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_lpuart1_rx);
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
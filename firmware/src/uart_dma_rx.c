@@ -0,0 +1,54 @@
+#include "uart_dma_rx.h"
+
+#include <string.h>
+
+#include "profile.h"
+
+void uart_dma_rx_init(uart_dma_rx_t *rx) {
+    if (!rx) return;
+    memset(rx, 0, sizeof(*rx));
+}
+
+void uart_dma_rx_set_realtime(uart_dma_rx_t *rx, bool (*realtime)(void *ctx, uint8_t byte), void *ctx) {
+    if (!rx) return;
+    rx->realtime = realtime;
+    rx->realtime_ctx = ctx;
+}
+
+static size_t forward_chunk(uart_dma_rx_t *rx, uint16_t from, uint16_t to, serial_uart_t *uart) {
+    uint8_t *chunk = &rx->buf[from];
+    size_t len = (size_t)(to - from);
+
+    /* The DMA only writes this span again after wrapping, so it can be
+     * edited in place: translate CR and close the gaps left by realtime
+     * bytes */
+    size_t kept = 0u;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = chunk[i];
+        if (rx->realtime && rx->realtime(rx->realtime_ctx, c)) continue;
+        chunk[kept++] = (c == '\r') ? (uint8_t)'\n' : c;
+    }
+    len = kept;
+
+    size_t accepted = serial_uart_rx_push(uart, chunk, len);
+    rx->dropped += (uint32_t)(len - accepted);
+    return accepted;
+}
+
+size_t uart_dma_rx_service(uart_dma_rx_t *rx, uint16_t write_pos, serial_uart_t *uart) {
+    if (!rx || !uart) return 0u;
+    if (write_pos >= UART_DMA_RX_SIZE) write_pos = 0u;
+
+    PROFILE_BEGIN(t0);
+    size_t accepted = 0u;
+    if (write_pos < rx->read_pos) {
+        accepted += forward_chunk(rx, rx->read_pos, UART_DMA_RX_SIZE, uart);
+        rx->read_pos = 0u;
+    }
+    if (write_pos > rx->read_pos) {
+        accepted += forward_chunk(rx, rx->read_pos, write_pos, uart);
+    }
+    rx->read_pos = write_pos;
+    PROFILE_END(PROFILE_ZONE_RX_FEED, t0);
+    return accepted;
+}
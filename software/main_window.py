@@ -22,7 +22,7 @@ from PySide6.QtWidgets import (
 )
 
 from main import ProcessorWorker, PreviewCanvas
-from streaming import GrblStreamer, StreamState, StreamError
+from streaming import GrblStreamer, StreamMode, StreamState, StreamError
 
 
 # ------------------ CONFIG: CHANGE THESE ------------------
@@ -33,6 +33,7 @@ BAUDRATE = 115200
 PREAMBLE = []
 STARTUP_DRAIN_TIME = 2.0
 TIMEOUT_PER_LINE = 5.0
+STREAM_MODE = StreamMode.CHARACTER_COUNTING
 # ----------------------------------------------------------
 
 
@@ -391,12 +392,28 @@ class MainWindow(QMainWindow):
             QMessageBox.warning(self, "Invalid baudrate", "Baudrate must be an integer.")
             return
 
+        mode_labels = {
+            StreamMode.CHARACTER_COUNTING: "Character counting (fast)",
+            StreamMode.SEND_RESPONSE: "Send-response (one line at a time)",
+        }
+        labels = list(mode_labels.values())
+        mode_label, ok = QInputDialog.getItem(
+            self, "Streaming mode", "Select streaming protocol:", labels,
+            labels.index(mode_labels[STREAM_MODE]), False
+        )
+        if not ok:
+            self.console_append("[INFO] Streaming cancelled (no mode).")
+            self.status_label.setText("Idle")
+            return
+        mode = next(m for m, label in mode_labels.items() if label == mode_label)
+
         # Init log file for this session
         self._init_stream_log()
         self._stream_log_append(f"[INFO] File: {path}")
         self._stream_log_append(f"[INFO] Port: {port}")
         self._stream_log_append(f"[INFO] Baud: {baudrate}")
         self._stream_log_append(f"[INFO] Preamble: {PREAMBLE}")
+        self._stream_log_append(f"[INFO] Mode: {mode.value}")
 
         # Lock UI during job
         self.btn_stream.setEnabled(False)
@@ -425,6 +442,7 @@ class MainWindow(QMainWindow):
                 log_callback=log_cb,
                 startup_drain_time=STARTUP_DRAIN_TIME,
                 timeout_per_line=TIMEOUT_PER_LINE,
+                mode=mode,
             )
             self.console_append("[DEBUG] Starting streamer thread...")
             self._streamer.start()
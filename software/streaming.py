@@ -1,6 +1,7 @@
 #streaming.py
 import argparse
 import time
+from collections import deque
 from dataclasses import dataclass
 from enum import Enum, auto
 from threading import Thread
@@ -10,6 +11,9 @@ import serial
 
 SETUP_ERROR_INDEX = -1
 
+# Firmware serial RX ring size (UART_RX_BUFFER_SIZE in firmware/inc/serial_uart.h)
+UART_RX_BUFFER_SIZE = 256
+
 
 class StreamState(Enum):
     IDLE = auto()
@@ -18,6 +22,13 @@ class StreamState(Enum):
     ERROR = auto()
 
 
+class StreamMode(Enum):
+    # One line in flight: send, wait for its OK/error, send the next
+    SEND_RESPONSE = "send-response"
+    # Keep the firmware RX buffer full; responses match the oldest line in flight
+    CHARACTER_COUNTING = "char-count"
+
+
 @dataclass
 class StreamError:
     line_index: int
@@ -37,6 +48,8 @@ class GrblStreamer(Thread):
         timeout_per_line: float = 5.0,
         startup_drain_time: float = 1.0,
         read_timeout: float = 0.1,
+        mode: StreamMode = StreamMode.SEND_RESPONSE,
+        rx_buffer_size: int = UART_RX_BUFFER_SIZE,
     ) -> None:
         super().__init__(daemon=True)
         self.port = port
@@ -48,6 +61,8 @@ class GrblStreamer(Thread):
         self.timeout_per_line = timeout_per_line
         self.startup_drain_time = startup_drain_time
         self.read_timeout = read_timeout
+        self.mode = mode
+        self.rx_buffer_size = rx_buffer_size
 
     def _emit_state(self, state: StreamState) -> None:
         if self.state_callback:
@@ -68,6 +83,115 @@ class GrblStreamer(Thread):
                 )
             )
 
+    def _commands(self):
+        # Yields (line_index, cmd, payload) for each line to send, or
+        # (line_index, cmd, None) after reporting an encoding error
+        for line_index, raw in enumerate(self.lines):
+            if is_comment_or_empty(raw):
+                continue
+
+            cmd = strip_inline_comments(raw)
+            if not cmd:
+                continue
+
+            try:
+                payload = (cmd + "\n").encode("ascii")
+            except UnicodeEncodeError as exc:
+                self._emit_error(line_index, cmd, f"Encoding error for '{cmd}': {exc}")
+                yield line_index, cmd, None
+                return
+
+            yield line_index, cmd, payload
+
+    def _read_response(self, ser: serial.Serial) -> Optional[str]:
+        # Returns "ok", an "error..." line, or None (timeout/other output)
+        resp = ser.readline()
+        if not resp:
+            return None
+
+        text = resp.decode("utf-8", errors="replace").strip()
+        if not text:
+            return None
+
+        # Log every controller line we receive
+        self._emit_log(f"<< {text}")
+
+        normalized = text.upper()
+        if normalized == "OK":
+            return "ok"
+        if normalized.startswith("ERROR"):
+            return text
+        return None
+
+    def _stream_send_response(self, ser: serial.Serial) -> bool:
+        for line_index, cmd, payload in self._commands():
+            if payload is None:
+                return False
+
+            # Log what we are sending
+            self._emit_log(f">> {cmd}")
+            ser.write(payload)
+
+            deadline = time.time() + self.timeout_per_line
+            while time.time() < deadline:
+                resp = self._read_response(ser)
+                if resp == "ok":
+                    break
+                if resp is not None:
+                    self._emit_error(line_index, cmd, resp)
+                    return False
+            else:
+                self._emit_error(line_index, cmd, "Timeout waiting for OK")
+                return False
+        return True
+
+    def _stream_character_counting(self, ser: serial.Serial) -> bool:
+        in_flight = deque()  # (line_index, cmd, byte count), oldest first
+        bytes_in_flight = 0
+        commands = self._commands()
+        pending = next(commands, None)
+        deadline = time.time() + self.timeout_per_line
+
+        while pending is not None or in_flight:
+            # Top up the firmware RX buffer without overflowing it
+            while pending is not None:
+                line_index, cmd, payload = pending
+                if payload is None:
+                    return False
+                if len(payload) > self.rx_buffer_size:
+                    self._emit_error(line_index, cmd, f"Line longer than RX buffer ({self.rx_buffer_size} bytes)")
+                    return False
+                if bytes_in_flight + len(payload) > self.rx_buffer_size:
+                    break
+
+                self._emit_log(f">> {cmd}")
+                ser.write(payload)
+                if not in_flight:
+                    deadline = time.time() + self.timeout_per_line
+                in_flight.append((line_index, cmd, len(payload)))
+                bytes_in_flight += len(payload)
+                pending = next(commands, None)
+
+            if not in_flight:
+                continue
+
+            resp = self._read_response(ser)
+            if resp is None:
+                if time.time() >= deadline:
+                    line_index, cmd, _ = in_flight[0]
+                    self._emit_error(line_index, cmd, "Timeout waiting for OK")
+                    return False
+                continue
+
+            # Each OK/error answers the oldest line still in flight
+            line_index, cmd, count = in_flight.popleft()
+            bytes_in_flight -= count
+            deadline = time.time() + self.timeout_per_line
+            if resp != "ok":
+                self._emit_error(line_index, cmd, resp)
+                return False
+        return True
+
     def run(self) -> None:
         self._emit_state(StreamState.SENDING)
         try:
@@ -75,46 +199,12 @@ class GrblStreamer(Thread):
                 time.sleep(self.startup_drain_time)
                 ser.reset_input_buffer()
 
-                for line_index, raw in enumerate(self.lines):
-                    if is_comment_or_empty(raw):
-                        continue
-
-                    cmd = strip_inline_comments(raw)
-                    if not cmd:
-                        continue
-
-                    try:
-                        payload = (cmd + "\n").encode("ascii")
-                    except UnicodeEncodeError as exc:
-                        self._emit_error(line_index, cmd, f"Encoding error for '{cmd}': {exc}")
-                        return
-
-                    # Log what we are sending
-                    self._emit_log(f">> {cmd}")
-                    ser.write(payload)
-
-                    deadline = time.time() + self.timeout_per_line
-                    while time.time() < deadline:
-                        resp = ser.readline()
-                        if not resp:
-                            continue
-
-                        text = resp.decode("utf-8", errors="replace").strip()
-                        if not text:
-                            continue
-
-                        # Log every controller line we receive
-                        self._emit_log(f"<< {text}")
-
-                        normalized = text.upper()
-                        if normalized == "OK":
-                            break
-                        if normalized.startswith("ERROR"):
-                            self._emit_error(line_index, cmd, text)
-                            return
-                    else:
-                        self._emit_error(line_index, cmd, "Timeout waiting for OK")
-                        return
+                if self.mode == StreamMode.CHARACTER_COUNTING:
+                    ok = self._stream_character_counting(ser)
+                else:
+                    ok = self._stream_send_response(ser)
+                if not ok:
+                    return
 
         except serial.SerialException as exc:
             self._emit_error(SETUP_ERROR_INDEX, "", f"Serial connection failed: {exc}")
@@ -163,49 +253,37 @@ def main():
     ap.add_argument("--file", required=True, help="Path to .gcode file")
     ap.add_argument("--timeout", type=float, default=5.0, help="Seconds to wait for OK per line")
     ap.add_argument("--startup-delay", type=float, default=1.0, help="Delay after opening port")
+    ap.add_argument(
+        "--mode",
+        choices=[m.value for m in StreamMode],
+        default=StreamMode.SEND_RESPONSE.value,
+        help="send-response: one line at a time; char-count: keep the firmware RX buffer full",
+    )
+    ap.add_argument("--rx-buffer", type=int, default=UART_RX_BUFFER_SIZE, help="Firmware RX buffer size in bytes")
     args = ap.parse_args()
 
-    with serial.Serial(args.port, args.baud, timeout=0.1) as ser:
-        # Give MCU time to reset after opening port (common on USB-serial)
-        time.sleep(args.startup_delay)
-        ser.reset_input_buffer()
-
-        line_num = 0
-        with open(args.file, "r", encoding="utf-8", errors="replace") as f:
-            for raw in f:
-                line_num += 1
-                if is_comment_or_empty(raw):
-                    continue
-
-                cmd = strip_inline_comments(raw)
-                if not cmd:
-                    continue
-
-                # Send with newline. Your firmware treats CR as LF, but LF is fine too.
-                payload = (cmd + "\n").encode("ascii", errors="ignore")
-                ser.write(payload)
-
-                # Wait for OK
-                deadline = time.time() + args.timeout
-                got_ok = False
-                while time.time() < deadline:
-                    resp = ser.readline()
-                    if not resp:
-                        continue
-                    text = resp.decode("utf-8", errors="replace").strip()
-                    if not text:
-                        continue
-                    print(f"<< {text}")
-
-                    # accept OK or ok (some firmwares vary)
-                    if text.upper() == "OK":
-                        got_ok = True
-                        break
-
-                if not got_ok:
-                    raise RuntimeError(f"Timeout waiting for OK on line {line_num}: {cmd}")
-
-                print(f">> {cmd}")
+    with open(args.file, "r", encoding="utf-8", errors="replace") as f:
+        lines = [ln.rstrip("\n") for ln in f]
+
+    errors = []
+    streamer = GrblStreamer(
+        port=args.port,
+        baudrate=args.baud,
+        lines=lines,
+        error_callback=errors.append,
+        log_callback=print,
+        timeout_per_line=args.timeout,
+        startup_drain_time=args.startup_delay,
+        mode=StreamMode(args.mode),
+        rx_buffer_size=args.rx_buffer,
+    )
+    streamer.run()
+
+    if errors:
+        err = errors[0]
+        if err.line_index >= 0:
+            raise RuntimeError(f"Line {err.line_index + 1}: {err.line_text}: {err.raw_line}")
+        raise RuntimeError(err.raw_line)
 
     print("Done.")
 
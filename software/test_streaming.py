@@ -6,7 +6,7 @@ import time
 from datetime import datetime
 import argparse
 
-from streaming import GrblStreamer, StreamError, StreamState
+from streaming import GrblStreamer, StreamError, StreamMode, StreamState, UART_RX_BUFFER_SIZE
 
 
 # ------------------ CONFIG: CHANGE THESE ------------------
@@ -21,6 +21,7 @@ PREAMBLE = ["$X", "G21", "G90"]
 
 STARTUP_DRAIN_TIME = 2.0
 TIMEOUT_PER_LINE = 5.0
+STREAM_MODE = StreamMode.SEND_RESPONSE
 # ----------------------------------------------------------
 
 
@@ -37,6 +38,13 @@ def main() -> int:
     ap.add_argument("--baud", type=int, default=BAUDRATE, help="Baudrate (e.g. 115200)")
     ap.add_argument("--timeout", type=float, default=TIMEOUT_PER_LINE, help="Seconds to wait for OK per line")
     ap.add_argument("--startup-delay", type=float, default=STARTUP_DRAIN_TIME, help="Delay after opening port")
+    ap.add_argument(
+        "--mode",
+        choices=[m.value for m in StreamMode],
+        default=STREAM_MODE.value,
+        help="send-response: one line at a time; char-count: keep the firmware RX buffer full",
+    )
+    ap.add_argument("--rx-buffer", type=int, default=UART_RX_BUFFER_SIZE, help="Firmware RX buffer size in bytes")
     ap.add_argument(
         "--log-file",
         default="",
@@ -94,6 +102,7 @@ def main() -> int:
     emit(f"Preamble: {PREAMBLE}")
     emit(f"Startup delay: {args.startup_delay}")
     emit(f"Timeout per line: {args.timeout}")
+    emit(f"Mode: {args.mode} (RX buffer {args.rx_buffer} bytes)")
     emit(f"Log file: {log_path}")
     emit("------------------------------------------")
 
@@ -124,6 +133,8 @@ def main() -> int:
         log_callback=on_log,
         startup_drain_time=args.startup_delay,
         timeout_per_line=args.timeout,
+        mode=StreamMode(args.mode),
+        rx_buffer_size=args.rx_buffer,
     )
 
     streamer.run()
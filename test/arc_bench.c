@@ -0,0 +1,171 @@
+/* arc_bench.c - Arc interpolation throughput (segments per second)
+ *
+ * Compares arc_generate_ij() against the direct form it replaced, which
+ * evaluated cosf/sinf for every segment, and reports each one's largest
+ * distance from a double-precision reference.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../src/arc.h"
+#include "bench.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BENCH_ARCS 20000
+#define BENCH_SEGMENT_LEN_MM 0.5f   /* Fixed segment length of the direct form */
+#define BENCH_MAX_SEGMENTS 10000
+
+typedef struct {
+    float x, y;
+} bench_arc_t;
+
+typedef struct {
+    uint32_t segments;
+    float sum;                  /* Keeps the optimizer from dropping the work */
+} bench_sink_t;
+
+typedef struct {
+    float x[BENCH_MAX_SEGMENTS];
+    float y[BENCH_MAX_SEGMENTS];
+    int count;
+} bench_points_t;
+
+static bool sink_segment(float x, float y, void *user) {
+    bench_sink_t *sink = (bench_sink_t *)user;
+    sink->segments++;
+    sink->sum += x + y;
+    return true;
+}
+
+static bool store_segment(float x, float y, void *user) {
+    bench_points_t *pts = (bench_points_t *)user;
+    if (pts->count >= BENCH_MAX_SEGMENTS) return false;
+    pts->x[pts->count] = x;
+    pts->y[pts->count] = y;
+    pts->count++;
+    return true;
+}
+
+/* Per-segment sinf/cosf arc interpolation with fixed-length segments
+ * (the original arc_generate_ij) */
+static bool arc_direct_ij(float start_x, float start_y,
+                          float end_x, float end_y,
+                          float i_offset, float j_offset,
+                          bool clockwise,
+                          arc_segment_cb_t cb, void *user)
+{
+    float cx = start_x + i_offset;
+    float cy = start_y + j_offset;
+    float r_start = sqrtf((start_x - cx) * (start_x - cx) + (start_y - cy) * (start_y - cy));
+    float r_end = sqrtf((end_x - cx) * (end_x - cx) + (end_y - cy) * (end_y - cy));
+    float radius = 0.5f * (r_start + r_end);
+    if (radius < ARC_RADIUS_MIN_MM) return false;
+
+    float theta_start = atan2f(start_y - cy, start_x - cx);
+    float theta_end = atan2f(end_y - cy, end_x - cx);
+    float angular_travel = clockwise ? (theta_start - theta_end) : (theta_end - theta_start);
+    if (angular_travel <= 0.0f) angular_travel += (float)(2.0 * M_PI);
+    if (fabsf(end_x - start_x) < ARC_RADIUS_MIN_MM && fabsf(end_y - start_y) < ARC_RADIUS_MIN_MM) {
+        angular_travel = (float)(2.0 * M_PI);
+    }
+
+    int num_segments = (int)(radius * angular_travel / BENCH_SEGMENT_LEN_MM);
+    if (num_segments < 1) num_segments = 1;
+    if (num_segments > BENCH_MAX_SEGMENTS) num_segments = BENCH_MAX_SEGMENTS;
+    float theta_step = angular_travel / (float)num_segments;
+    if (clockwise) theta_step = -theta_step;
+
+    float theta = theta_start;
+    for (int i = 1; i <= num_segments; i++) {
+        float seg_x = end_x;
+        float seg_y = end_y;
+        if (i != num_segments) {
+            theta += theta_step;
+            seg_x = cx + radius * cosf(theta);
+            seg_y = cy + radius * sinf(theta);
+        }
+        if (!cb(seg_x, seg_y, user)) return false;
+    }
+    return true;
+}
+
+/* Deterministic mix of arc sizes: 1..100 mm radius, 10..350 degree sweep */
+static bench_arc_t arcs_start[BENCH_ARCS];
+static bench_arc_t arcs_end[BENCH_ARCS];
+static bench_arc_t arcs_center[BENCH_ARCS];
+
+static void make_arcs(void) {
+    uint32_t seed = 12345u;
+    for (int i = 0; i < BENCH_ARCS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float radius = 1.0f + (float)(seed >> 16) * (99.0f / 65536.0f);
+        seed = seed * 1664525u + 1013904223u;
+        float a0 = (float)(seed >> 16) * (float)(2.0 * M_PI / 65536.0);
+        seed = seed * 1664525u + 1013904223u;
+        float sweep = (float)(10.0 + (double)(seed >> 16) * (340.0 / 65536.0)) * (float)(M_PI / 180.0);
+        arcs_center[i].x = 0.0f;
+        arcs_center[i].y = 0.0f;
+        arcs_start[i].x = radius * cosf(a0);
+        arcs_start[i].y = radius * sinf(a0);
+        arcs_end[i].x = radius * cosf(a0 + sweep);
+        arcs_end[i].y = radius * sinf(a0 + sweep);
+    }
+}
+
+typedef bool (*arc_fn_t)(float, float, float, float, float, float, bool, arc_segment_cb_t, void *);
+
+static void bench_arc_fn(const char *name, arc_fn_t fn) {
+    bench_sink_t sink = {0u, 0.0f};
+    double t0 = bench_seconds();
+    for (int i = 0; i < BENCH_ARCS; i++) {
+        fn(arcs_start[i].x, arcs_start[i].y, arcs_end[i].x, arcs_end[i].y,
+           arcs_center[i].x - arcs_start[i].x, arcs_center[i].y - arcs_start[i].y,
+           false, sink_segment, &sink);
+    }
+    double t1 = bench_seconds();
+    bench_report(name, "segments", (double)sink.segments, t1 - t0);
+    if (sink.sum == 12345.0f) printf("\n");
+}
+
+static bench_points_t arc_pts;
+
+/* Largest distance from the arc points to the same points computed in
+ * double precision */
+static double max_error(arc_fn_t fn) {
+    double max_err = 0.0;
+    for (int i = 0; i < BENCH_ARCS; i += 97) {
+        arc_pts.count = 0;
+        fn(arcs_start[i].x, arcs_start[i].y, arcs_end[i].x, arcs_end[i].y,
+           arcs_center[i].x - arcs_start[i].x, arcs_center[i].y - arcs_start[i].y,
+           false, store_segment, &arc_pts);
+
+        double radius = hypot(arcs_start[i].x, arcs_start[i].y);
+        double a0 = atan2(arcs_start[i].y, arcs_start[i].x);
+        double sweep = atan2(arcs_end[i].y, arcs_end[i].x) - a0;
+        if (sweep <= 0.0) sweep += 2.0 * M_PI;
+        for (int k = 0; k < arc_pts.count; k++) {
+            double theta = a0 + sweep * (double)(k + 1) / (double)arc_pts.count;
+            double err = hypot(arc_pts.x[k] - radius * cos(theta), arc_pts.y[k] - radius * sin(theta));
+            if (err > max_err) max_err = err;
+        }
+    }
+    return max_err;
+}
+
+int main(void) {
+    printf("Arc interpolation benchmark (%d arcs, direct: %.2f mm segments, "
+           "incremental: %.4f mm tolerance)\n",
+           BENCH_ARCS, (double)BENCH_SEGMENT_LEN_MM, (double)arc_get_tolerance_mm());
+    make_arcs();
+    bench_arc_fn("direct sinf/cosf", arc_direct_ij);
+    bench_arc_fn("incremental rotation", arc_generate_ij);
+    printf("max error direct sinf/cosf:     %.6f mm\n", max_error(arc_direct_ij));
+    printf("max error incremental rotation: %.6f mm\n", max_error(arc_generate_ij));
+    return 0;
+}
@@ -0,0 +1,34 @@
+/* bench.h - Host benchmark helpers
+ *
+ * Benchmarks are plain executables built from the test Makefile
+ * ("make bench"). They time CPU work with clock() and print one line per
+ * measurement so before/after runs can be compared with diff.
+ * bench_record() lines are key=value pairs for scripts; other output lines
+ * from such benchmarks start with '#'.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <time.h>
+
+/* CPU time in seconds */
+static inline double bench_seconds(void) {
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+/* Print "name: count unit in s (rate unit/s)" */
+static inline void bench_report(const char *name, const char *unit, double count, double seconds) {
+    double rate = (seconds > 0.0) ? (count / seconds) : 0.0;
+    printf("%-28s %12.0f %s in %7.3f s  %14.0f %s/s\n", name, count, unit, seconds, rate, unit);
+}
+
+/* Print "bench=... workload=... stage=... ops=... unit=... ns_per_op=...
+ * lines=... lines_per_s=... seconds=..." on one line */
+static inline void bench_record(const char *bench, const char *workload, const char *stage,
+                                double ops, const char *unit, double lines, double seconds) {
+    double ns_per_op = (ops > 0.0) ? (seconds * 1e9 / ops) : 0.0;
+    double lines_per_s = (seconds > 0.0) ? (lines / seconds) : 0.0;
+    printf("bench=%s workload=%s stage=%s ops=%.0f unit=%s ns_per_op=%.2f lines=%.0f lines_per_s=%.0f seconds=%.4f\n",
+           bench, workload, stage, ops, unit, ns_per_op, lines, lines_per_s, seconds);
+}
@@ -2,9 +2,11 @@
 
 #include <stdio.h>
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "../src/gcode.h"
+#include "../src/arc.h"
 
 /* Helper to check if two floats are approximately equal */
 static int float_equal(float a, float b) {
@@ -66,6 +68,79 @@ void test_parse_simple_commands() {
     printf("  [PASSED]\n");
 }
 
+void test_parse_number_forms() {
+    printf("Testing gcode_parse_line number scanning...\n");
+    
+    gcode_block_t block;
+    
+    /* Packed words, lowercase letters, signs and bare fractions */
+    assert(gcode_parse_line("g1x10.5Y-3.25f+200", &block) == GCODE_OK);
+    assert(block.g_code == 1);
+    assert(block.x == 10.5f && block.y == -3.25f && block.f == 200.0f);
+    assert(gcode_parse_line("G1 X.5 Y-.125", &block) == GCODE_OK);
+    assert(block.x == 0.5f && block.y == -0.125f);
+    
+    /* Same float as strtof for the word lengths CAM output uses */
+    static const char *const numbers[] = {
+        "19.126", "0.001", "-0.7", "123.456", "6.409999", "1000.000", "25.4", "0.0000123"
+    };
+    for (size_t n = 0; n < sizeof(numbers) / sizeof(numbers[0]); n++) {
+        char line[32];
+        snprintf(line, sizeof(line), "X%s", numbers[n]);
+        assert(gcode_parse_line(line, &block) == GCODE_OK);
+        assert(block.x == strtof(numbers[n], NULL));
+    }
+    
+    /* More digits than the mantissa holds: still close */
+    assert(gcode_parse_line("X123456789012 Y3.14159265358979", &block) == GCODE_OK);
+    assert(fabsf(block.x - 123456789012.0f) < 1e5f);
+    assert(float_equal(block.y, 3.14159265f));
+    
+    /* Words without a number */
+    assert(gcode_parse_line("G1 X", &block) == GCODE_ERR_INVALID_PARAM);
+    assert(gcode_parse_line("G1 X-", &block) == GCODE_ERR_INVALID_PARAM);
+    assert(gcode_parse_line("G1 X. Y2", &block) == GCODE_ERR_INVALID_PARAM);
+    assert(gcode_parse_line("G X1", &block) == GCODE_ERR_INVALID_PARAM);
+    
+    /* Command subcodes are not implemented; G1.0 is just G1 */
+    assert(gcode_parse_line("G38.2 X1", &block) == GCODE_ERR_UNSUPPORTED_CMD);
+    assert(gcode_parse_line("G1.0 X1", &block) == GCODE_OK);
+    assert(block.g_code == 1);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_parse_unsupported_words() {
+    printf("Testing gcode_parse_line unsupported words...\n");
+    
+    gcode_block_t block;
+    
+    /* Z and N are flagged and skipped without losing the words after them */
+    assert(gcode_parse_line("N10 G1Z-1.000Y3 X2", &block) == GCODE_OK);
+    assert(block.unsupported_words == ((1u << ('N' - 'A')) | (1u << ('Z' - 'A'))));
+    assert(block.has_y && block.y == 3.0f);
+    assert(block.has_x && block.x == 2.0f);
+    
+    assert(gcode_parse_line("G0 X1 Y2", &block) == GCODE_OK);
+    assert(block.unsupported_words == 0u);
+    
+    /* Executing the line moves XY and reports what was skipped, except N */
+    gcode_state_t gc;
+    gcode_init(&gc);
+    assert(gcode_process_line(&gc, "N10 G1 X2 Z-1 T3 F100") == GCODE_OK);
+    assert(float_equal(gc.position_x, 2.0f));
+    assert(gcode_get_ignored_words(&gc) == ((1u << ('T' - 'A')) | (1u << ('Z' - 'A'))));
+    
+    assert(gcode_process_line(&gc, "N11 G1 X3") == GCODE_OK);
+    assert(gcode_get_ignored_words(&gc) == 0u);
+    
+    /* A rejected line reports nothing */
+    assert(gcode_process_line(&gc, "G38.2 Z-1") == GCODE_ERR_UNSUPPORTED_CMD);
+    assert(gcode_get_ignored_words(&gc) == 0u);
+    
+    printf("  [PASSED]\n");
+}
+
 void test_motion_execution() {
     printf("Testing motion command execution...\n");
     
@@ -340,6 +415,235 @@ void test_arc_cw_ij() {
     printf("  [PASSED]\n");
 }
 
+/* Collects arc segment endpoints for direct arc generator checks */
+typedef struct {
+    float x[4096];
+    float y[4096];
+    int count;
+} arc_points_t;
+
+static bool collect_arc_point(float x, float y, void *user) {
+    arc_points_t *pts = (arc_points_t *)user;
+    if (pts->count >= 4096) return false;
+    pts->x[pts->count] = x;
+    pts->y[pts->count] = y;
+    pts->count++;
+    return true;
+}
+
+void test_arc_incremental_rotation_accuracy() {
+    printf("Testing incremental arc rotation stays on the exact arc...\n");
+    
+    /* Full CCW circle, r = 200 mm at 0.0001 mm tolerance: 3141 segments */
+    static arc_points_t pts;
+    pts.count = 0;
+    assert(arc_set_tolerance_mm(0.0001f));
+    assert(arc_generate_ij(200.0f, 0.0f, 200.0f, 0.0f, -200.0f, 0.0f, false,
+                           collect_arc_point, &pts));
+    assert(arc_set_tolerance_mm(ARC_TOLERANCE_MM_DEFAULT));
+    assert(pts.count == 3141);
+    
+    /* Every point matches the exactly computed angle */
+    float step = (float)(2.0 * 3.14159265358979323846) / (float)pts.count;
+    float max_err = 0.0f;
+    for (int i = 0; i < pts.count; i++) {
+        double theta = (double)(i + 1) * (double)step;
+        float ex = (float)(200.0 * cos(theta));
+        float ey = (float)(200.0 * sin(theta));
+        float err = hypotf(pts.x[i] - ex, pts.y[i] - ey);
+        if (err > max_err) max_err = err;
+    }
+    assert(max_err < 0.001f);
+    
+    /* Last point is the exact endpoint */
+    assert(pts.x[pts.count - 1] == 200.0f);
+    assert(pts.y[pts.count - 1] == 0.0f);
+    
+    printf("  [PASSED]\n");
+}
+
+/* Largest distance between the segment midpoints and a circle about the origin */
+static float max_chord_error(const arc_points_t *pts, float start_x, float start_y, float radius) {
+    float max_err = 0.0f;
+    float px = start_x;
+    float py = start_y;
+    for (int i = 0; i < pts->count; i++) {
+        float mx = 0.5f * (px + pts->x[i]);
+        float my = 0.5f * (py + pts->y[i]);
+        float err = radius - hypotf(mx, my);
+        if (err > max_err) max_err = err;
+        px = pts->x[i];
+        py = pts->y[i];
+    }
+    return max_err;
+}
+
+void test_arc_tolerance_segmentation() {
+    printf("Testing arc segment count follows chord tolerance...\n");
+    
+    static arc_points_t pts;
+    assert(arc_get_tolerance_mm() == ARC_TOLERANCE_MM_DEFAULT);
+    assert(!arc_set_tolerance_mm(0.0f));
+    assert(!arc_set_tolerance_mm(-0.1f));
+    assert(arc_get_tolerance_mm() == ARC_TOLERANCE_MM_DEFAULT);
+    
+    /* Tiny circle (r = 0.5 mm): a handful of segments, within tolerance */
+    pts.count = 0;
+    assert(arc_generate_ij(0.5f, 0.0f, 0.5f, 0.0f, -0.5f, 0.0f, false, collect_arc_point, &pts));
+    assert(pts.count >= 3 && pts.count <= 40);
+    assert(max_chord_error(&pts, 0.5f, 0.0f, 0.5f) <= ARC_TOLERANCE_MM_DEFAULT * 1.05f);
+    
+    /* Large circle (r = 150 mm): longer segments, still within tolerance */
+    pts.count = 0;
+    assert(arc_generate_ij(150.0f, 0.0f, 150.0f, 0.0f, -150.0f, 0.0f, false, collect_arc_point, &pts));
+    assert(max_chord_error(&pts, 150.0f, 0.0f, 150.0f) <= ARC_TOLERANCE_MM_DEFAULT * 1.05f);
+    float chord = hypotf(pts.x[1] - pts.x[0], pts.y[1] - pts.y[0]);
+    assert(chord > 1.0f);
+    
+    /* Looser tolerance: fewer segments */
+    int tight_count = pts.count;
+    assert(arc_set_tolerance_mm(0.02f));
+    pts.count = 0;
+    assert(arc_generate_ij(150.0f, 0.0f, 150.0f, 0.0f, -150.0f, 0.0f, false, collect_arc_point, &pts));
+    assert(pts.count * 3 < tight_count);
+    assert(max_chord_error(&pts, 150.0f, 0.0f, 150.0f) <= 0.02f * 1.05f);
+    assert(arc_set_tolerance_mm(ARC_TOLERANCE_MM_DEFAULT));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_motion_queues_planner_blocks() {
+    printf("Testing G-code motion feeds the planner...\n");
+    
+    static planner_queue_t queue;
+    planner_queue_init(&queue, 0);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_set_planner(&gc, &queue, NULL, NULL);
+    
+    /* Straight move: one block with exact step counts */
+    assert(gcode_process_line(&gc, "G01 X10 Y0 F600") == GCODE_OK);
+    assert(queue.size == 1);
+    assert(planner_peek_back(&queue)->steps[0] == 800);
+    assert(planner_peek_back(&queue)->nominal_speed == 600.0f);
+    
+    /* Quarter arc continuing tangentially: coarse tolerance keeps it in the queue */
+    assert(arc_set_tolerance_mm(0.1f));
+    assert(gcode_process_line(&gc, "G03 X20 Y10 I0 J10") == GCODE_OK);
+    assert(arc_set_tolerance_mm(ARC_TOLERANCE_MM_DEFAULT));
+    assert(queue.size > 3);
+    assert(float_equal(gc.position_x, 20.0f));
+    assert(float_equal(gc.position_y, 10.0f));
+    assert(queue.position_steps.v[0] == 1600);
+    assert(queue.position_steps.v[1] == 800);
+    
+    /* Look-ahead: no stop at the line/arc junction or between arc segments */
+    uint32_t idx = queue.head;
+    for (uint32_t n = 0; n + 1 < queue.size; n++) {
+        assert(queue.blocks[idx].exit_speed > 100.0f);
+        idx = (idx + 1) & (PLANNER_BUFFER_SIZE - 1u);
+    }
+    
+    /* Rapid: axis max rate */
+    planner_queue_clear(&queue);
+    assert(gcode_process_line(&gc, "G00 X0 Y10") == GCODE_OK);
+    assert(planner_peek_back(&queue)->nominal_speed == 3000.0f);
+    
+    /* M30 rewinds the planner position along with the G-code position */
+    assert(gcode_process_line(&gc, "M30") == GCODE_OK);
+    assert(queue.position_steps.v[0] == 0 && queue.position_steps.v[1] == 0);
+    
+    printf("  [PASSED]\n");
+}
+
+/* planner_wait hook: drains a fixed number of blocks, then aborts */
+static int wait_budget;
+static bool drain_one_block(void *user) {
+    planner_queue_t *queue = (planner_queue_t *)user;
+    if (wait_budget-- <= 0) return false;
+    planner_discard_front(queue);
+    return true;
+}
+
+void test_motion_waits_for_planner_room() {
+    printf("Testing G-code waits for planner room...\n");
+    
+    static planner_queue_t queue;
+    planner_queue_init(&queue, 4);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_set_planner(&gc, &queue, drain_one_block, &queue);
+    
+    /* Full circle needs more than 4 blocks: the hook makes room */
+    wait_budget = 1000;
+    assert(gcode_process_line(&gc, "G02 X0 Y0 I5 J0 F600") == GCODE_OK);
+    assert(wait_budget < 1000);
+    assert(float_equal(gc.position_x, 0.0f));
+    
+    /* Hook refusing to wait aborts the move part way */
+    wait_budget = 2;
+    assert(gcode_process_line(&gc, "G02 X0 Y0 I5 J0") == GCODE_ERR_MOTION_ABORTED);
+    
+    /* Reset keeps the planner binding */
+    gcode_reset(&gc);
+    assert(gc.planner == &queue);
+    assert(queue.position_steps.v[0] == 0);
+    
+    printf("  [PASSED]\n");
+}
+
+/* spindle_sync hook: records the last change and the queue size it saw */
+static int spindle_calls;
+static gcode_spindle_state_t spindle_state_seen;
+static float spindle_speed_seen;
+static uint32_t spindle_queue_seen;
+static bool record_spindle(void *user, gcode_spindle_state_t state, float speed) {
+    spindle_calls++;
+    spindle_state_seen = state;
+    spindle_speed_seen = speed;
+    spindle_queue_seen = ((planner_queue_t *)user)->size;
+    return true;
+}
+
+void test_spindle_changes_precede_motion() {
+    printf("Testing spindle changes apply to the line's motion...\n");
+    
+    static planner_queue_t queue;
+    planner_queue_init(&queue, 0);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_set_planner(&gc, &queue, NULL, NULL);
+    gcode_set_spindle_sync(&gc, record_spindle, &queue);
+    spindle_calls = 0;
+    
+    /* M3 S reaches the output before the move is queued, and rides on it */
+    assert(gcode_process_line(&gc, "G01 X10 F600 M03 S800") == GCODE_OK);
+    assert(spindle_calls == 1);
+    assert(spindle_state_seen == GCODE_SPINDLE_CW);
+    assert(float_equal(spindle_speed_seen, 800.0f));
+    assert(spindle_queue_seen == 0);
+    assert(queue.size == 1);
+    assert(float_equal(planner_peek_back(&queue)->spindle_speed, 800.0f));
+    assert(planner_peek_back(&queue)->spindle_dir == GCODE_SPINDLE_CW);
+    
+    /* Standalone S while running */
+    assert(gcode_process_line(&gc, "S400 G01 X20") == GCODE_OK);
+    assert(spindle_calls == 2);
+    assert(float_equal(planner_peek_back(&queue)->spindle_speed, 400.0f));
+    
+    /* M30 turns the spindle off after the line's motion */
+    assert(gcode_process_line(&gc, "G01 X0 M30") == GCODE_OK);
+    assert(spindle_calls == 3);
+    assert(spindle_state_seen == GCODE_SPINDLE_OFF);
+    assert(spindle_queue_seen == 3);
+    
+    /* Reset keeps the spindle binding */
+    gcode_reset(&gc);
+    assert(gc.spindle_sync == record_spindle);
+    
+    printf("  [PASSED]\n");
+}
+
 void test_arc_ccw_ij() {
     printf("Testing G03 counter-clockwise arc with I/J...\n");
     
@@ -517,6 +821,8 @@ int main() {
     
     test_init_and_reset();
     test_parse_simple_commands();
+    test_parse_number_forms();
+    test_parse_unsupported_words();
     test_motion_execution();
     test_spindle_control();
     test_absolute_relative_modes();
@@ -529,6 +835,11 @@ int main() {
     test_program_end_m30();
     test_arc_parse_ij_params();
     test_arc_cw_ij();
+    test_arc_incremental_rotation_accuracy();
+    test_arc_tolerance_segmentation();
+    test_motion_queues_planner_blocks();
+    test_motion_waits_for_planner_room();
+    test_spindle_changes_precede_motion();
     test_arc_ccw_ij();
     test_arc_r_form();
     test_arc_missing_params();
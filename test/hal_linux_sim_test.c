@@ -0,0 +1,255 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/hal_linux_sim.h"
+#include "../src/serial_gcode_bridge.h"
+
+/* Step timer callback: logs fire times, walks a period schedule, then stops */
+static uint64_t fire_times[8];
+static uint32_t fire_count;
+static const uint32_t schedule[] = {20u, 30u, 5u};
+
+static void timer_cb(void *user) {
+    (void)user;
+    fire_times[fire_count] = hal_sim_now();
+    if (fire_count < sizeof(schedule) / sizeof(schedule[0])) {
+        hal_step_timer_set_period(schedule[fire_count]);
+    } else {
+        hal_step_timer_stop();
+    }
+    fire_count++;
+}
+
+static uint32_t read_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Read a whole trace back from its stream */
+static size_t read_trace(FILE *f, uint8_t *buf, size_t cap) {
+    rewind(f);
+    return fread(buf, 1u, cap, f);
+}
+
+static void test_virtual_clock(void) {
+    printf("Testing virtual clock...\n");
+    assert(hal_init() == CORE_HAL_OK);
+    assert(hal_sim_now() == 0u);
+
+    hal_poll();
+    assert(hal_sim_now() == HAL_SIM_POLL_TICKS);
+    hal_sim_set_poll_ticks(0u);
+    hal_poll();
+    assert(hal_sim_now() == HAL_SIM_POLL_TICKS);
+
+    hal_delay_ms(5u);
+    assert(hal_millis() == 5u);
+    assert(hal_micros() == 5000u + HAL_SIM_POLL_TICKS * (1000000u / HAL_STEP_TIMER_HZ));
+    printf("  [PASSED]\n");
+}
+
+static void test_step_timer_deadlines(void) {
+    printf("Testing step timer deadlines...\n");
+    hal_sim_reset();
+    fire_count = 0u;
+    hal_step_timer_init(timer_cb, NULL);
+    hal_step_timer_start(10u);
+    assert(hal_sim_timer_running());
+
+    /* One coarse advance still runs every deadline at its exact time; the
+     * period set in the callback applies to the interval just started */
+    hal_sim_advance(1000u);
+    assert(fire_count == 4u);
+    assert(fire_times[0] == 10u);
+    assert(fire_times[1] == 30u);
+    assert(fire_times[2] == 60u);
+    assert(fire_times[3] == 65u);
+    assert(!hal_sim_timer_running());
+    assert(hal_sim_now() == 1000u);
+
+    hal_sim_stats_t stats;
+    hal_sim_get_stats(&stats);
+    assert(stats.isr_calls == 4u);
+
+    /* Deadlines beyond the advance wait for the next one */
+    fire_count = 0u;
+    hal_step_timer_start(10u);
+    hal_sim_advance(9u);
+    assert(fire_count == 0u);
+    hal_sim_advance(1u);
+    assert(fire_count == 1u);
+    assert(fire_times[0] == 1010u);
+    hal_step_timer_stop();
+    printf("  [PASSED]\n");
+}
+
+static void test_trace_records(void) {
+    printf("Testing step trace records...\n");
+    hal_sim_reset();
+    FILE *f = tmpfile();
+    assert(f);
+    assert(hal_sim_trace_attach(f));
+
+    hal_sim_advance(5u);
+    hal_stepper_set_dir(HAL_AXIS_X, true);
+    hal_stepper_set_dir(HAL_AXIS_X, true);   /* No change: not recorded */
+    hal_stepper_set_dir(HAL_AXIS_Y, false);
+    hal_sim_advance(100u);
+    hal_stepper_pulse_mask(0x3u);
+    hal_sim_advance(0x100000000ull + 7u);    /* Longer than one record delta */
+    hal_stepper_pulse_mask(0x1u);
+    hal_sim_trace_close();
+
+    uint8_t buf[256];
+    const size_t len = read_trace(f, buf, sizeof(buf));
+    fclose(f);
+    assert(len == HAL_SIM_TRACE_HEADER_SIZE + 5u * HAL_SIM_TRACE_RECORD_SIZE);
+    assert(memcmp(buf, HAL_SIM_TRACE_MAGIC, 8u) == 0);
+    assert(read_u32(&buf[8]) == HAL_STEP_TIMER_HZ);
+
+    const uint8_t *rec = &buf[HAL_SIM_TRACE_HEADER_SIZE];
+    assert(rec[0] == HAL_SIM_REC_DIR && rec[1] == (HAL_AXIS_X | 0x80u) && read_u32(&rec[2]) == 5u);
+    rec += HAL_SIM_TRACE_RECORD_SIZE;
+    assert(rec[0] == HAL_SIM_REC_DIR && rec[1] == HAL_AXIS_Y && read_u32(&rec[2]) == 0u);
+    rec += HAL_SIM_TRACE_RECORD_SIZE;
+    assert(rec[0] == HAL_SIM_REC_STEP && rec[1] == 0x3u && read_u32(&rec[2]) == 100u);
+    rec += HAL_SIM_TRACE_RECORD_SIZE;
+    assert(rec[0] == HAL_SIM_REC_GAP && read_u32(&rec[2]) == 0xFFFFFFFFu);
+    rec += HAL_SIM_TRACE_RECORD_SIZE;
+    assert(rec[0] == HAL_SIM_REC_STEP && rec[1] == 0x1u && read_u32(&rec[2]) == 8u);
+
+    /* Counters follow the direction pins */
+    hal_sim_stats_t stats;
+    hal_sim_get_stats(&stats);
+    assert(stats.steps[HAL_AXIS_X] == 2u && stats.position[HAL_AXIS_X] == 2);
+    assert(stats.steps[HAL_AXIS_Y] == 1u && stats.position[HAL_AXIS_Y] == -1);
+    assert(stats.dir_changes[HAL_AXIS_X] == 0u);
+    assert(stats.first_step_ticks == 105u);
+    printf("  [PASSED]\n");
+}
+
+/* Run one job through the bridge, recording to f */
+static void run_job(FILE *f, const char *const *lines, size_t count) {
+    static serial_gcode_bridge_t bridge;
+    char response[128];
+
+    hal_init();
+    hal_sim_set_serial_out(NULL);
+    if (f) {
+        assert(hal_sim_trace_attach(f));
+    }
+    serial_gcode_bridge_init(&bridge);
+    for (size_t i = 0; i < count; i++) {
+        assert(serial_gcode_bridge_process_line(&bridge, lines[i], response, sizeof(response)) == GCODE_OK);
+    }
+    while (!serial_gcode_bridge_is_idle(&bridge)) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+    hal_sim_trace_close();
+}
+
+static void test_bridge_job_timing(void) {
+    printf("Testing G-code job on virtual time...\n");
+    static const char *const job[] = {"G1 X10 F600"};
+    run_job(NULL, job, 1u);
+
+    /* 10 mm at 10 mm/s with 200 mm/s^2 ramps: 1.05 s, 800 steps */
+    hal_sim_stats_t stats;
+    hal_sim_get_stats(&stats);
+    assert(stats.steps[HAL_AXIS_X] == 800u);
+    assert(stats.position[HAL_AXIS_X] == 800);
+    assert(stats.steps[HAL_AXIS_Y] == 0u);
+    const double seconds = (double)(stats.last_step_ticks - stats.first_step_ticks) / HAL_STEP_TIMER_HZ;
+    assert(fabs(seconds - 1.05) < 0.01);
+    printf("  [PASSED]\n");
+}
+
+/* Every pulse is high for $0 and, at the step period floor, low at least
+ * as long before the next one rises */
+static void test_step_pulse_widths(void) {
+    printf("Testing step pulse high and low widths...\n");
+    static const char *const job[] = {"$0=10", "$110=60000", "$120=20000", "G1 X100 F60000"};
+    static uint8_t buf[1u << 18];
+
+    FILE *f = tmpfile();
+    assert(f);
+    run_job(f, job, sizeof(job) / sizeof(job[0]));
+    const size_t len = read_trace(f, buf, sizeof(buf));
+    fclose(f);
+    assert(len > HAL_SIM_TRACE_HEADER_SIZE && len < sizeof(buf));
+
+    /* 1000 mm/s at 80 steps/mm wants 12.5 ticks per step: the floor is
+     * 10 high + 10 low */
+    uint64_t now = 0u;
+    uint64_t rise = 0u;
+    uint64_t fall = 0u;
+    bool high = false;
+    uint32_t pulses = 0u;
+    uint64_t min_low = UINT64_MAX;
+    for (size_t i = HAL_SIM_TRACE_HEADER_SIZE; i + HAL_SIM_TRACE_RECORD_SIZE <= len; i += HAL_SIM_TRACE_RECORD_SIZE) {
+        now += read_u32(&buf[i + 2u]);
+        if (buf[i] == HAL_SIM_REC_STEP) {
+            assert(!high && buf[i + 1u] == (1u << HAL_AXIS_X));
+            if (pulses > 0u && now - fall < min_low) {
+                min_low = now - fall;
+            }
+            rise = now;
+            high = true;
+            pulses++;
+        } else if (buf[i] == HAL_SIM_REC_STEP_END) {
+            assert(high && buf[i + 1u] == (1u << HAL_AXIS_X));
+            assert(now - rise == 10u);
+            fall = now;
+            high = false;
+        }
+    }
+    assert(!high);
+    assert(pulses == 8000u);
+    assert(min_low == 10u);
+    printf("  [PASSED]\n");
+}
+
+static void test_runs_are_repeatable(void) {
+    printf("Testing repeatable traces...\n");
+    static const char *const job[] = {
+        "G1 X10 Y5 F1200", "G2 X20 Y5 I5 J0", "G0 X0 Y0", "G1 X-3 Y2 F300",
+    };
+    static uint8_t first[1u << 16];
+    static uint8_t second[1u << 16];
+
+    FILE *f = tmpfile();
+    assert(f);
+    run_job(f, job, sizeof(job) / sizeof(job[0]));
+    const size_t len1 = read_trace(f, first, sizeof(first));
+    fclose(f);
+
+    f = tmpfile();
+    assert(f);
+    run_job(f, job, sizeof(job) / sizeof(job[0]));
+    const size_t len2 = read_trace(f, second, sizeof(second));
+    fclose(f);
+
+    assert(len1 > HAL_SIM_TRACE_HEADER_SIZE && len1 < sizeof(first));
+    assert(len1 == len2);
+    assert(memcmp(first, second, len1) == 0);
+
+    hal_sim_stats_t stats;
+    hal_sim_get_stats(&stats);
+    assert(stats.position[HAL_AXIS_X] == -240 && stats.position[HAL_AXIS_Y] == 160);
+    printf("  [PASSED]\n");
+}
+
+int main(void) {
+    printf("Running Linux simulation HAL tests...\n");
+    test_virtual_clock();
+    test_step_timer_deadlines();
+    test_trace_records();
+    test_bridge_job_timing();
+    test_step_pulse_widths();
+    test_runs_are_repeatable();
+    printf("All Linux simulation HAL tests passed!\n");
+    return 0;
+}
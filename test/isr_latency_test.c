@@ -0,0 +1,176 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/hal_linux_sim.h"
+#include "../src/isr_latency.h"
+#include "../src/serial_gcode_bridge.h"
+
+#if !GRBL_FEATURE_ISR_LATENCY
+#error "isr_latency_test needs GRBL_FEATURE_ISR_LATENCY=1"
+#endif
+
+static char report_lines[ISR_LATENCY_BUCKETS + 2u][64];
+static int report_count;
+
+static void capture_report(void *ctx, const char *msg) {
+    (void)ctx;
+    if (report_count < (int)(sizeof(report_lines) / sizeof(report_lines[0]))) {
+        snprintf(report_lines[report_count], sizeof(report_lines[0]), "%s", msg);
+    }
+    report_count++;
+}
+
+/* Every 10th ISR 3 ticks late, every 100th 40 ticks late */
+static uint32_t latency_calls;
+static uint32_t pattern_latency(void *user, uint64_t deadline) {
+    (void)user;
+    (void)deadline;
+    latency_calls++;
+    if (latency_calls % 100u == 0u) return 40u;
+    if (latency_calls % 10u == 0u) return 3u;
+    return 0u;
+}
+
+static uint32_t fixed_latency(void *user, uint64_t deadline) {
+    (void)deadline;
+    return *(const uint32_t *)user;
+}
+
+static uint32_t timer_entries;
+static uint32_t timer_late[8];
+static uint64_t timer_now[8];
+static void record_timer(void *user) {
+    (void)user;
+    if (timer_entries < 8u) {
+        timer_late[timer_entries] = hal_step_timer_latency();
+        timer_now[timer_entries] = hal_sim_now();
+    }
+    timer_entries++;
+}
+
+static void test_buckets(void) {
+    printf("Testing histogram buckets...\n");
+    assert(isr_latency_bucket(0u) == 0u);
+    assert(isr_latency_bucket(1u) == 1u);
+    assert(isr_latency_bucket(2u) == 2u);
+    assert(isr_latency_bucket(3u) == 2u);
+    assert(isr_latency_bucket(4u) == 3u);
+    assert(isr_latency_bucket(40u) == 6u);
+    assert(isr_latency_bucket(0xFFFFFFFFu) == ISR_LATENCY_BUCKETS - 1u);
+    assert(isr_latency_bucket_floor(0u) == 0u);
+    assert(isr_latency_bucket_floor(1u) == 1u);
+    assert(isr_latency_bucket_floor(6u) == 32u);
+    for (uint8_t b = 1u; b < ISR_LATENCY_BUCKETS; b++) {
+        assert(isr_latency_bucket(isr_latency_bucket_floor(b)) == b);
+    }
+
+    isr_latency_stats_t st;
+    isr_latency_reset();
+    isr_latency_record(0u, 50u);
+    isr_latency_record(5u, 120u);
+    isr_latency_record(6u, 80u);
+    isr_latency_get(&st);
+    assert(st.samples == 3u);
+    assert(st.buckets[0] == 1u && st.buckets[3] == 2u);
+    assert(st.max_latency_ticks == 6u);
+    assert(st.max_duration_cycles == 120u);
+    isr_latency_reset();
+    isr_latency_get(&st);
+    assert(st.samples == 0u && st.buckets[3] == 0u && st.max_duration_cycles == 0u);
+    printf("  [PASSED]\n");
+}
+
+/* A late entry keeps the timer on its schedule; one later than the period
+ * runs the next ISR straight after */
+static void test_sim_late_entry_keeps_schedule(void) {
+    printf("Testing sim latency injection keeps the timer schedule...\n");
+    uint32_t late = 30u;
+    hal_init();
+    hal_sim_set_latency_hook(fixed_latency, &late);
+    hal_step_timer_init(record_timer, NULL);
+    timer_entries = 0u;
+    hal_step_timer_start(100u);
+
+    hal_sim_advance(129u);
+    assert(timer_entries == 0u);
+    hal_sim_advance(1u);
+    assert(timer_entries == 1u && timer_now[0] == 130u && timer_late[0] == 30u);
+    hal_sim_advance(100u);
+    assert(timer_entries == 2u && timer_now[1] == 230u && timer_late[1] == 30u);
+
+    late = 250u;
+    timer_entries = 0u;
+    hal_sim_advance(1000u);
+    /* Deadlines 300, 400, 500 ...: entries at 550, then 650 and 750 for the
+     * deadlines already passed while the first was held off */
+    assert(timer_now[0] == 550u && timer_late[0] == 250u);
+    assert(timer_now[1] == 650u && timer_late[1] == 250u);
+    hal_step_timer_stop();
+    hal_sim_set_latency_hook(NULL, NULL);
+    printf("  [PASSED]\n");
+}
+
+/* A job on the sim HAL with injected latency fills the histogram with
+ * exactly the injected pattern */
+static void test_job_histogram_and_report(void) {
+    printf("Testing job histogram and $L report...\n");
+    static serial_gcode_bridge_t bridge;
+    char response[64];
+
+    hal_init();
+    hal_sim_set_serial_out(NULL);
+    latency_calls = 0u;
+    hal_sim_set_latency_hook(pattern_latency, NULL);
+    serial_gcode_bridge_init(&bridge);
+    serial_gcode_bridge_set_report(&bridge, capture_report, NULL);
+
+    assert(serial_gcode_bridge_process_line(&bridge, "$LR", response, sizeof(response)) == GCODE_OK);
+    assert(strcmp(response, "OK") == 0);
+    assert(serial_gcode_bridge_process_line(&bridge, "G1 X10 Y5 F600", response, sizeof(response)) == GCODE_OK);
+    while (!serial_gcode_bridge_is_idle(&bridge)) {
+        (void)serial_gcode_bridge_poll(&bridge);
+        hal_poll();
+    }
+
+    hal_sim_stats_t sim;
+    hal_sim_get_stats(&sim);
+    isr_latency_stats_t st;
+    isr_latency_get(&st);
+    assert(sim.isr_calls > 100u);
+    assert(st.samples == sim.isr_calls);
+    assert(st.buckets[6] == st.samples / 100u);
+    assert(st.buckets[2] == st.samples / 10u - st.samples / 100u);
+    assert(st.buckets[0] == st.samples - st.buckets[2] - st.buckets[6]);
+    assert(st.max_latency_ticks == 40u);
+    assert(sim.position[HAL_AXIS_X] != 0 || sim.position[HAL_AXIS_Y] != 0);
+
+    report_count = 0;
+    assert(serial_gcode_bridge_process_line(&bridge, "$L", response, sizeof(response)) == GCODE_OK);
+    assert(strcmp(response, "OK") == 0);
+    assert(report_count == 4);
+    char expect[64];
+    snprintf(expect, sizeof(expect), "[ISR:%lu,40,", (unsigned long)st.samples);
+    assert(strncmp(report_lines[0], expect, strlen(expect)) == 0);
+    snprintf(expect, sizeof(expect), "[LAT:0,%lu]", (unsigned long)st.buckets[0]);
+    assert(strcmp(report_lines[1], expect) == 0);
+    snprintf(expect, sizeof(expect), "[LAT:2,%lu]", (unsigned long)st.buckets[2]);
+    assert(strcmp(report_lines[2], expect) == 0);
+    snprintf(expect, sizeof(expect), "[LAT:32,%lu]", (unsigned long)st.buckets[6]);
+    assert(strcmp(report_lines[3], expect) == 0);
+
+    assert(serial_gcode_bridge_process_line(&bridge, "$LR", response, sizeof(response)) == GCODE_OK);
+    isr_latency_get(&st);
+    assert(st.samples == 0u && st.max_latency_ticks == 0u);
+    hal_sim_set_latency_hook(NULL, NULL);
+    printf("  [PASSED]\n");
+}
+
+int main(void) {
+    printf("Running ISR latency tests...\n");
+    test_buckets();
+    test_sim_late_entry_keeps_schedule();
+    test_job_histogram_and_report();
+    printf("All ISR latency tests passed!\n");
+    return 0;
+}
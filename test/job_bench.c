@@ -0,0 +1,553 @@
+/* job_bench.c - End-to-end G-code job throughput, stage by stage
+ *
+ * Runs each workload through every stage of the firmware pipeline and
+ * prints one bench_record() line per stage (ns per op and lines per
+ * second). Workloads are the G-code files given on the command line
+ * (software/dog.gcode by default) plus two generated ones: a dense
+ * polyline of very short G1 moves and a chain of small G2/G3 arcs.
+ *
+ * Stages:
+ *   protocol   protocol_feed_bytes() + protocol_pop_line()    op = byte
+ *   uart       serial_uart RX ring + serial_uart_read_line()  op = byte
+ *   parse      gcode_parse_line()                             op = line
+ *   process    gcode_process_line(), no planner               op = line
+ *   arc        arc_generate_ij()/arc_generate_r()             op = segment
+ *   planner    planner_line_to() (enqueue + replan)           op = block
+ *   segments   planner + stepper_update() segment prep        op = segment
+ *   job        protocol -> bridge -> planner -> stepper ISR   op = line
+ *              on the Linux simulation HAL
+ *
+ * Round counts are fixed per workload size, so runs repeat the same work.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/arc.h"
+#include "../src/gcode.h"
+#include "../src/hal_linux_sim.h"
+#include "../src/planner.h"
+#include "../src/protocol.h"
+#include "../src/serial_gcode_bridge.h"
+#include "../src/serial_uart.h"
+#include "../src/stepper.h"
+#include "bench.h"
+
+#define BENCH_DEFAULT_FILE "../software/dog.gcode"
+#define BENCH_CHUNK 64u                 /* Bytes per receive chunk (a DMA idle burst) */
+#define BENCH_POLYLINE_POINTS 20000
+#define BENCH_ARC_COUNT 2000
+
+/* Work per stage, in ops; rounds = budget / ops per round (at least 1) */
+#define BENCH_BYTE_BUDGET 20000000.0
+#define BENCH_LINE_BUDGET 2000000.0
+#define BENCH_SEGMENT_BUDGET 2000000.0
+#define BENCH_BLOCK_BUDGET 1000000.0
+#define BENCH_PREP_BUDGET 1000000.0
+#define BENCH_JOB_BUDGET 5000.0
+
+typedef struct {
+    float x0, y0, x1, y1;
+    float i, j, r;
+    bool has_r;
+    bool clockwise;
+} bench_arc_t;
+
+typedef struct {
+    kin_cart_t target;
+    planner_line_data_t data;
+} bench_move_t;
+
+typedef struct {
+    char name[64];
+    char *text;                 /* Raw file contents */
+    size_t text_len;
+    char **lines;               /* Normalized lines, as the protocol layer pops them */
+    int line_count;
+    bench_arc_t *arcs;
+    int arc_count;
+    bench_move_t *moves;        /* Planner input captured from gcode_process_line() */
+    int move_count;
+    int move_cap;
+} bench_workload_t;
+
+static volatile float bench_sink;   /* Keeps the optimizer from dropping the work */
+
+static uint32_t rounds_for(double budget, double ops_per_round) {
+    if (ops_per_round <= 0.0) return 1u;
+    double n = budget / ops_per_round;
+    return n < 1.0 ? 1u : (uint32_t)n;
+}
+
+/* ----------------------------- Workloads ----------------------------- */
+
+static void text_append(bench_workload_t *w, size_t *cap, const char *line) {
+    size_t len = strlen(line);
+    if (w->text_len + len + 2u > *cap) {
+        *cap = (*cap + len + 2u) * 2u;
+        w->text = realloc(w->text, *cap);
+        if (!w->text) exit(1);
+    }
+    memcpy(&w->text[w->text_len], line, len);
+    w->text_len += len;
+    w->text[w->text_len++] = '\n';
+}
+
+static bool load_file(bench_workload_t *w, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    size_t cap = 0u;
+    char buf[4096];
+    size_t got;
+    while ((got = fread(buf, 1u, sizeof(buf), f)) > 0u) {
+        if (w->text_len + got > cap) {
+            cap = (cap + got) * 2u;
+            w->text = realloc(w->text, cap);
+            if (!w->text) exit(1);
+        }
+        memcpy(&w->text[w->text_len], buf, got);
+        w->text_len += got;
+    }
+    fclose(f);
+    const char *base = strrchr(path, '/');
+    snprintf(w->name, sizeof(w->name), "%s", base ? base + 1 : path);
+    return w->text_len > 0u;
+}
+
+static uint32_t lcg(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+/* Outward spiral of 0.05..0.1 mm G1 moves (a few steps each), CAM style */
+static void make_polyline(bench_workload_t *w) {
+    size_t cap = 0u;
+    char line[64];
+    uint32_t seed = 1u;
+    double angle = 0.0;
+    snprintf(w->name, sizeof(w->name), "synthetic_polyline");
+    text_append(w, &cap, "G21");
+    text_append(w, &cap, "G90");
+    text_append(w, &cap, "G0 X55.000 Y50.000");
+    text_append(w, &cap, "G1 F1500.000");
+    for (int n = 0; n < BENCH_POLYLINE_POINTS; n++) {
+        double radius = 5.0 + 0.001 * (double)n;
+        double seg = 0.05 + 0.05 * (double)(lcg(&seed) % 1000u) / 1000.0;
+        angle += seg / radius;
+        snprintf(line, sizeof(line), "G1 X%.3f Y%.3f",
+                 50.0 + radius * cos(angle), 50.0 + radius * sin(angle));
+        text_append(w, &cap, line);
+    }
+}
+
+/* Alternating G2/G3 half circles of 0.5..2.5 mm radius in I/J form, and
+ * every fourth arc a shallower R-form arc over the same chord */
+static void make_arcs(bench_workload_t *w) {
+    size_t cap = 0u;
+    char line[80];
+    uint32_t seed = 7u;
+    double x = 0.0;
+    snprintf(w->name, sizeof(w->name), "synthetic_arcs");
+    text_append(w, &cap, "G21");
+    text_append(w, &cap, "G90");
+    text_append(w, &cap, "G0 X0.000 Y10.000");
+    text_append(w, &cap, "G1 F1200.000");
+    for (int n = 0; n < BENCH_ARC_COUNT; n++) {
+        double radius = 0.5 + 2.0 * (double)(lcg(&seed) % 1000u) / 1000.0;
+        x += 2.0 * radius;
+        if (x > 200.0) {
+            x = 2.0 * radius;
+            text_append(w, &cap, "G0 X0.000 Y10.000");
+        }
+        if (n % 4 == 3) {
+            snprintf(line, sizeof(line), "G3 X%.3f Y10.000 R%.3f", x, 1.5 * radius);
+        } else {
+            snprintf(line, sizeof(line), "G%d X%.3f Y10.000 I%.3f J0.000",
+                     (n % 2 == 0) ? 2 : 3, x, radius);
+        }
+        text_append(w, &cap, line);
+    }
+}
+
+static const proto_config_t bench_proto_cfg = {
+    .strip_semicolon_comments = true,
+    .strip_paren_comments = true,
+    .allow_dollar_commands = true,
+    .to_uppercase = true,
+};
+
+/* Split the text into normalized lines with the protocol layer */
+static void split_lines(bench_workload_t *w) {
+    protocol_t proto;
+    char line[PROTOCOL_LINE_MAX + 1];
+    proto_line_status_t st;
+    int cap = 0;
+
+    protocol_init(&proto, &bench_proto_cfg, NULL, NULL, NULL);
+    for (size_t pos = 0u; pos <= w->text_len; pos += BENCH_CHUNK) {
+        size_t n = w->text_len - pos < BENCH_CHUNK ? w->text_len - pos : BENCH_CHUNK;
+        protocol_feed_bytes(&proto, (const uint8_t *)&w->text[pos], n);
+        if (pos + n >= w->text_len) {
+            protocol_feed_bytes(&proto, (const uint8_t *)"\n", 1u);
+        }
+        while (protocol_pop_line(&proto, line, sizeof(line), &st)) {
+            if (st != PROTO_LINE_OK) continue;
+            if (w->line_count == cap) {
+                cap = cap ? cap * 2 : 1024;
+                w->lines = realloc(w->lines, (size_t)cap * sizeof(w->lines[0]));
+                if (!w->lines) exit(1);
+            }
+            size_t len = strlen(line) + 1u;
+            w->lines[w->line_count] = malloc(len);
+            if (!w->lines[w->line_count]) exit(1);
+            memcpy(w->lines[w->line_count], line, len);
+            w->line_count++;
+        }
+    }
+}
+
+static void add_move(bench_workload_t *w, const planner_queue_t *q, const planner_block_t *block) {
+    if (w->move_count == w->move_cap) {
+        w->move_cap = w->move_cap ? w->move_cap * 2 : 1024;
+        w->moves = realloc(w->moves, (size_t)w->move_cap * sizeof(w->moves[0]));
+        if (!w->moves) exit(1);
+    }
+    bench_move_t *m = &w->moves[w->move_count++];
+    m->target = q->position;
+    m->data.feed_rate = block->nominal_speed;
+    m->data.rapid = block->rapid_flag;
+    m->data.spindle_speed = block->spindle_speed;
+    m->data.spindle_dir = block->spindle_dir;
+}
+
+/* Capture planner: one block deep, so every queued line comes through the
+ * wait hook, and queue->position is still that block's target */
+typedef struct {
+    bench_workload_t *w;
+    planner_queue_t queue;
+} bench_capture_t;
+
+static bool capture_wait(void *user) {
+    bench_capture_t *cap = (bench_capture_t *)user;
+    add_move(cap->w, &cap->queue, planner_peek_front(&cap->queue));
+    planner_discard_front(&cap->queue);
+    return true;
+}
+
+/* Record the arcs and the planner input of a workload */
+static void capture(bench_workload_t *w) {
+    static bench_capture_t cap;
+    gcode_state_t gc;
+    gcode_block_t block;
+    int arc_cap = 0;
+
+    cap.w = w;
+    planner_queue_init(&cap.queue, 1u);
+    gcode_init(&gc);
+    gcode_set_planner(&gc, &cap.queue, capture_wait, &cap);
+    for (int n = 0; n < w->line_count; n++) {
+        float x0, y0;
+        gcode_get_position(&gc, &x0, &y0);
+        if (gcode_process_line(&gc, w->lines[n]) != GCODE_OK) continue;
+        if (gcode_parse_line(w->lines[n], &block) != GCODE_OK || !block.has_g ||
+            (block.g_code != 2 && block.g_code != 3) || gc.units_mode != GCODE_UNITS_MM) {
+            continue;
+        }
+        if (w->arc_count == arc_cap) {
+            arc_cap = arc_cap ? arc_cap * 2 : 256;
+            w->arcs = realloc(w->arcs, (size_t)arc_cap * sizeof(w->arcs[0]));
+            if (!w->arcs) exit(1);
+        }
+        bench_arc_t *a = &w->arcs[w->arc_count++];
+        a->x0 = x0;
+        a->y0 = y0;
+        gcode_get_position(&gc, &a->x1, &a->y1);
+        a->i = block.has_i ? block.i : 0.0f;
+        a->j = block.has_j ? block.j : 0.0f;
+        a->r = block.r;
+        a->has_r = block.has_r;
+        a->clockwise = block.g_code == 2;
+    }
+    if (!planner_is_empty(&cap.queue)) {
+        add_move(w, &cap.queue, planner_peek_front(&cap.queue));
+    }
+}
+
+/* ----------------------------- Stages ----------------------------- */
+
+static void stage_protocol(const bench_workload_t *w) {
+    protocol_t proto;
+    char line[PROTOCOL_LINE_MAX + 1];
+    proto_line_status_t st;
+    uint32_t rounds = rounds_for(BENCH_BYTE_BUDGET, (double)w->text_len);
+    uint32_t lines = 0u;
+
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        protocol_init(&proto, &bench_proto_cfg, NULL, NULL, NULL);
+        for (size_t pos = 0u; pos < w->text_len; pos += BENCH_CHUNK) {
+            size_t n = w->text_len - pos < BENCH_CHUNK ? w->text_len - pos : BENCH_CHUNK;
+            protocol_feed_bytes(&proto, (const uint8_t *)&w->text[pos], n);
+            while (protocol_pop_line(&proto, line, sizeof(line), &st)) {
+                lines += (st == PROTO_LINE_OK);
+            }
+        }
+    }
+    double t1 = bench_seconds();
+    bench_record("job", w->name, "protocol", (double)rounds * (double)w->text_len, "byte",
+                 (double)lines, t1 - t0);
+}
+
+static void stage_uart(const bench_workload_t *w) {
+    static serial_uart_t uart;
+    char line[UART_LINE_MAX + 1];
+    uint32_t rounds = rounds_for(BENCH_BYTE_BUDGET, (double)w->text_len);
+    uint32_t lines = 0u;
+
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        serial_uart_init(&uart);
+        size_t pos = 0u;
+        while (pos < w->text_len) {
+            pos += serial_uart_rx_push(&uart, (const uint8_t *)&w->text[pos], w->text_len - pos);
+            while (serial_uart_read_line(&uart, line, sizeof(line)) != UART_LINE_NONE) {
+                lines++;
+            }
+        }
+    }
+    double t1 = bench_seconds();
+    bench_record("job", w->name, "uart", (double)rounds * (double)w->text_len, "byte",
+                 (double)lines, t1 - t0);
+}
+
+static void stage_parse(const bench_workload_t *w) {
+    gcode_block_t block;
+    uint32_t rounds = rounds_for(BENCH_LINE_BUDGET, (double)w->line_count);
+    float sum = 0.0f;
+
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (int n = 0; n < w->line_count; n++) {
+            if (gcode_parse_line(w->lines[n], &block) == GCODE_OK && block.has_x) sum += block.x;
+        }
+    }
+    double t1 = bench_seconds();
+    bench_sink = sum;
+    double lines = (double)rounds * (double)w->line_count;
+    bench_record("job", w->name, "parse", lines, "line", lines, t1 - t0);
+}
+
+static void stage_process(const bench_workload_t *w) {
+    gcode_state_t gc;
+    uint32_t rounds = rounds_for(BENCH_LINE_BUDGET, (double)w->line_count);
+    float sum = 0.0f;
+
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        gcode_init(&gc);
+        for (int n = 0; n < w->line_count; n++) {
+            (void)gcode_process_line(&gc, w->lines[n]);
+        }
+        sum += gc.position_x;
+    }
+    double t1 = bench_seconds();
+    bench_sink = sum;
+    double lines = (double)rounds * (double)w->line_count;
+    bench_record("job", w->name, "process", lines, "line", lines, t1 - t0);
+}
+
+typedef struct {
+    uint32_t segments;
+    float sum;
+} bench_arc_sink_t;
+
+static bool arc_sink(float x, float y, void *user) {
+    bench_arc_sink_t *sink = (bench_arc_sink_t *)user;
+    sink->segments++;
+    sink->sum += x + y;
+    return true;
+}
+
+static void stage_arc(const bench_workload_t *w) {
+    if (w->arc_count == 0) return;
+
+    /* Size the rounds from one pass */
+    bench_arc_sink_t sink = {0u, 0.0f};
+    for (int n = 0; n < w->arc_count; n++) {
+        const bench_arc_t *a = &w->arcs[n];
+        if (a->has_r) {
+            arc_generate_r(a->x0, a->y0, a->x1, a->y1, a->r, a->clockwise, arc_sink, &sink);
+        } else {
+            arc_generate_ij(a->x0, a->y0, a->x1, a->y1, a->i, a->j, a->clockwise, arc_sink, &sink);
+        }
+    }
+    uint32_t rounds = rounds_for(BENCH_SEGMENT_BUDGET, (double)sink.segments);
+
+    sink.segments = 0u;
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (int n = 0; n < w->arc_count; n++) {
+            const bench_arc_t *a = &w->arcs[n];
+            if (a->has_r) {
+                arc_generate_r(a->x0, a->y0, a->x1, a->y1, a->r, a->clockwise, arc_sink, &sink);
+            } else {
+                arc_generate_ij(a->x0, a->y0, a->x1, a->y1, a->i, a->j, a->clockwise, arc_sink, &sink);
+            }
+        }
+    }
+    double t1 = bench_seconds();
+    bench_sink = sink.sum;
+    bench_record("job", w->name, "arc", (double)sink.segments, "segment",
+                 (double)rounds * (double)w->arc_count, t1 - t0);
+}
+
+static void stage_planner(const bench_workload_t *w) {
+    static planner_queue_t queue;
+    uint32_t rounds = rounds_for(BENCH_BLOCK_BUDGET, (double)w->move_count);
+    float sum = 0.0f;
+
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        planner_queue_init(&queue, 0u);
+        for (int n = 0; n < w->move_count; n++) {
+            while (planner_line_to(&queue, &w->moves[n].target, &w->moves[n].data) == PLANNER_LINE_FULL) {
+                /* The stepper takes the oldest block */
+                sum += planner_peek_front(&queue)->entry_speed;
+                planner_discard_front(&queue);
+            }
+        }
+    }
+    double t1 = bench_seconds();
+    bench_sink = sum;
+    bench_record("job", w->name, "planner", (double)rounds * (double)w->move_count, "block",
+                 (double)rounds * (double)w->line_count, t1 - t0);
+}
+
+/* Slice queued blocks; the "ISR" takes every segment as soon as it is ready */
+static uint32_t prep_and_take(stepper_context_t *st) {
+    stepper_update(st);
+    uint32_t n = (uint32_t)((st->segment_head + STEPPER_SEGMENT_BUFFER_SIZE - st->segment_tail) %
+                            STEPPER_SEGMENT_BUFFER_SIZE);
+    st->segment_tail = st->segment_head;
+    return n;
+}
+
+static double segments_pass(const bench_workload_t *w) {
+    static planner_queue_t queue;
+    static stepper_context_t st;
+    double segments = 0.0;
+
+    planner_queue_init(&queue, 0u);
+    stepper_init(&st, NULL);
+    stepper_set_planner(&st, &queue);
+    for (int n = 0; n < w->move_count; n++) {
+        while (planner_line_to(&queue, &w->moves[n].target, &w->moves[n].data) == PLANNER_LINE_FULL) {
+            segments += prep_and_take(&st);
+        }
+    }
+    while (!planner_is_empty(&queue) || st.current_block) {
+        segments += prep_and_take(&st);
+    }
+    return segments;
+}
+
+static void stage_segments(const bench_workload_t *w) {
+    hal_init();
+    uint32_t rounds = rounds_for(BENCH_PREP_BUDGET, segments_pass(w));
+    double segments = 0.0;
+
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        segments += segments_pass(w);
+    }
+    double t1 = bench_seconds();
+    bench_record("job", w->name, "segments", segments, "segment",
+                 (double)rounds * (double)w->line_count, t1 - t0);
+}
+
+static void stage_job(const bench_workload_t *w) {
+    static serial_gcode_bridge_t bridge;
+    protocol_t proto;
+    char line[PROTOCOL_LINE_MAX + 1];
+    char response[128];
+    proto_line_status_t st;
+    uint32_t rounds = rounds_for(BENCH_JOB_BUDGET, (double)w->line_count);
+    uint32_t lines = 0u;
+    uint32_t errors = 0u;
+    double cycle_s = 0.0;
+
+    double t0 = bench_seconds();
+    for (uint32_t round = 0; round < rounds; round++) {
+        hal_init();
+        hal_sim_set_serial_out(NULL);
+        serial_gcode_bridge_init(&bridge);
+        protocol_init(&proto, &bench_proto_cfg, NULL, NULL, NULL);
+        for (size_t pos = 0u; pos <= w->text_len; pos += BENCH_CHUNK) {
+            size_t n = w->text_len - pos < BENCH_CHUNK ? w->text_len - pos : BENCH_CHUNK;
+            protocol_feed_bytes(&proto, (const uint8_t *)&w->text[pos], n);
+            if (pos + n >= w->text_len) {
+                protocol_feed_bytes(&proto, (const uint8_t *)"\n", 1u);
+            }
+            while (protocol_pop_line(&proto, line, sizeof(line), &st)) {
+                if (st != PROTO_LINE_OK) continue;
+                lines++;
+                if (serial_gcode_bridge_process_line(&bridge, line, response, sizeof(response)) != GCODE_OK) {
+                    errors++;
+                }
+            }
+        }
+        while (!serial_gcode_bridge_is_idle(&bridge) && serial_gcode_bridge_poll(&bridge)) {
+            hal_poll();
+        }
+        cycle_s = (double)hal_sim_now() / (double)HAL_STEP_TIMER_HZ;
+    }
+    double t1 = bench_seconds();
+    bench_record("job", w->name, "job", (double)lines, "line", (double)lines, t1 - t0);
+    printf("# %s: %u rounds, %u line errors, simulated cycle time %.3f s\n",
+           w->name, (unsigned)rounds, (unsigned)(errors / rounds), cycle_s);
+}
+
+static void run_workload(bench_workload_t *w) {
+    split_lines(w);
+    capture(w);
+    printf("# %s: %u bytes, %d lines, %d arcs, %d planner blocks\n",
+           w->name, (unsigned)w->text_len, w->line_count, w->arc_count, w->move_count);
+    stage_protocol(w);
+    stage_uart(w);
+    stage_parse(w);
+    stage_process(w);
+    stage_arc(w);
+    stage_planner(w);
+    stage_segments(w);
+    stage_job(w);
+}
+
+int main(int argc, char **argv) {
+    static bench_workload_t file_workloads[8];
+    static bench_workload_t polyline;
+    static bench_workload_t arcs;
+    int files = argc > 1 ? argc - 1 : 1;
+    if (files > (int)(sizeof(file_workloads) / sizeof(file_workloads[0]))) {
+        fprintf(stderr, "too many files\n");
+        return 2;
+    }
+
+    printf("# job throughput benchmark (ns_per_op and lines_per_s per stage)\n");
+    for (int n = 0; n < files; n++) {
+        const char *path = argc > 1 ? argv[n + 1] : BENCH_DEFAULT_FILE;
+        if (!load_file(&file_workloads[n], path)) {
+            fprintf(stderr, "cannot read G-code from %s\n", path);
+            return 1;
+        }
+        run_workload(&file_workloads[n]);
+    }
+    make_polyline(&polyline);
+    run_workload(&polyline);
+    make_arcs(&arcs);
+    run_workload(&arcs);
+    return 0;
+}
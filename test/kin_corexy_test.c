@@ -0,0 +1,194 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/hal_linux_sim.h"
+#include "../src/kin_corexy.h"
+#include "../src/serial_gcode_bridge.h"
+
+#if GRBL_KINEMATICS != GRBL_KIN_COREXY
+#error "kin_corexy_test needs GRBL_KINEMATICS=GRBL_KIN_COREXY"
+#endif
+
+static const float FLOAT_EPSILON = 0.0001f;
+
+static bool near(float a, float b) {
+    return fabsf(a - b) < FLOAT_EPSILON;
+}
+
+static bool identity_cart_to_joint(const kin_cart_t *cart, kin_joint_t *out_joint) {
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        out_joint->v[i] = (i < KIN_MAX_CART_AXES) ? cart->v[i] : 0.0f;
+    }
+    return true;
+}
+
+static void test_defaults_without_install(void) {
+    printf("Testing conversions use the default config before install...\n");
+    const kin_cart_t cart = {{ 1.0f, 2.0f, 3.0f }};
+    kin_joint_t joint;
+    assert(kinematics_cart_to_joint(&cart, &joint));
+    assert(near(joint.v[0], 3.0f) && near(joint.v[1], -1.0f) && near(joint.v[2], 3.0f));
+    assert(joint.v[3] == 0.0f);
+
+    /* 80 steps/mm on A/B, 400 on Z */
+    const kin_steps_t steps = {{ 800, 800, 400, 0 }};
+    kin_cart_t back;
+    kinematics_steps_to_cart(&steps, &back);
+    assert(near(back.v[0], 10.0f) && near(back.v[1], 0.0f) && near(back.v[2], 1.0f));
+    printf("  [PASSED]\n");
+}
+
+/* The inline path and the g_kin vtable give the same answers */
+static void test_inline_matches_vtable(void) {
+    printf("Testing inline conversions match the vtable...\n");
+    kin_corexy_cfg_t cfg;
+    kin_corexy_install(NULL);
+    kin_corexy_get_cfg(&cfg);
+    cfg.steps_per_mm[0] = 100.0f;
+    cfg.steps_per_mm[1] = 50.0f;
+    cfg.invert_joint[1] = true;
+    cfg.invert_cart[0] = true;
+    cfg.invert_cart[2] = true;
+    kin_corexy_set_cfg(&cfg);
+
+    for (int i = -5; i <= 5; i++) {
+        const kin_cart_t cart = {{ 1.25f * (float)i, 3.0f - 0.5f * (float)i, 0.1f * (float)i }};
+        kin_joint_t j_inline, j_vtable;
+        kin_cart_t c_inline, c_vtable;
+        assert(kinematics_cart_to_joint(&cart, &j_inline));
+        assert(g_kin.cart_to_joint(&cart, &j_vtable));
+        assert(memcmp(&j_inline, &j_vtable, sizeof(j_inline)) == 0);
+
+        assert(kinematics_joint_to_cart(&j_inline, &c_inline));
+        assert(g_kin.joint_to_cart(&j_inline, &c_vtable));
+        assert(memcmp(&c_inline, &c_vtable, sizeof(c_inline)) == 0);
+        for (uint8_t a = 0; a < KIN_MAX_CART_AXES; a++) {
+            assert(near(c_inline.v[a], cart.v[a]));
+        }
+
+        const kin_steps_t steps = {{ 37 * i, -11 * i + 4, 400 * i, 9 }};
+        kinematics_steps_to_cart(&steps, &c_inline);
+        g_kin.steps_to_cart(&steps, &c_vtable);
+        assert(memcmp(&c_inline, &c_vtable, sizeof(c_inline)) == 0);
+    }
+    printf("  [PASSED]\n");
+}
+
+/* set_cfg re-derives the cached factors; the one-pass step conversion
+ * rounds exactly like converting to joint mm first */
+static void test_cached_factors_and_direct_steps(void) {
+    printf("Testing cached factors and direct Cartesian -> steps...\n");
+    kin_corexy_cfg_t cfg;
+    kin_corexy_install(NULL);
+    kin_corexy_get_cfg(&cfg);
+    assert(g_kin_corexy.joint_mm_per_step[0] == 1.0f / 80.0f);
+    assert(g_kin_corexy.joint_mm_per_step[3] == 0.0f);
+
+    cfg.steps_per_mm[0] = 200.0f;
+    cfg.steps_per_mm[2] = 0.0f;
+    cfg.invert_joint[0] = true;
+    cfg.invert_cart[1] = true;
+    kin_corexy_set_cfg(&cfg);
+    assert(g_kin_corexy.joint_mm_per_step[0] == -1.0f / 200.0f);
+    assert(g_kin_corexy.joint_mm_per_step[1] == 1.0f / 80.0f);
+    assert(g_kin_corexy.joint_mm_per_step[2] == 0.0f);
+    assert(g_kin_corexy.joint_sign[0] == -1.0f && g_kin_corexy.joint_sign[1] == 1.0f);
+    assert(g_kin_corexy.cart_sign[1] == -1.0f && g_kin_corexy.cart_sign[0] == 1.0f);
+
+    /* -400 steps on the inverted A joint read as +2 mm, 240 on B as 3 mm,
+     * Z has no steps/mm; Y comes out inverted */
+    const kin_steps_t steps = {{ -400, 240, 55, 0 }};
+    kin_cart_t cart;
+    kinematics_steps_to_cart(&steps, &cart);
+    assert(near(cart.v[0], 0.5f * (2.0f + 3.0f)));
+    assert(near(cart.v[1], -0.5f * (2.0f - 3.0f)));
+    assert(cart.v[2] == 0.0f);
+
+    const float planner_steps[KIN_MAX_JOINT_AXES] = { 80.0f, 80.0f, 400.0f, 0.0f };
+    for (int i = -50; i <= 50; i++) {
+        const kin_cart_t target = {{ 0.0137f * (float)i, 2.5f - 0.0291f * (float)i, 0.00125f * (float)i }};
+        kin_joint_t joint;
+        kin_steps_t direct;
+        assert(kinematics_cart_to_joint(&target, &joint));
+        assert(kinematics_cart_to_steps(&target, planner_steps, &direct));
+        for (uint8_t a = 0; a < KIN_MAX_JOINT_AXES; a++) {
+            assert(direct.v[a] == (int32_t)lroundf(joint.v[a] * planner_steps[a]));
+        }
+    }
+
+    kin_corexy_install(NULL);
+    assert(g_kin_corexy.joint_mm_per_step[0] == 1.0f / 80.0f);
+    assert(g_kin_corexy.joint_sign[0] == 1.0f && g_kin_corexy.cart_sign[1] == 1.0f);
+    printf("  [PASSED]\n");
+}
+
+/* Replacing g_kin leaves the compiled-in conversions alone but still
+ * swaps the other hooks */
+static void test_vtable_stays_pluggable(void) {
+    printf("Testing g_kin stays pluggable for the other hooks...\n");
+    kin_corexy_install(NULL);
+    kin_iface_t impl;
+    memset(&impl, 0, sizeof(impl));
+    impl.cart_to_joint = identity_cart_to_joint;
+    kinematics_install(&impl);
+
+    const kin_cart_t cart = {{ 1.0f, 1.0f, 0.0f }};
+    kin_joint_t joint;
+    assert(g_kin.cart_to_joint(&cart, &joint) && near(joint.v[1], 1.0f));
+    assert(kinematics_cart_to_joint(&cart, &joint) && near(joint.v[1], 0.0f));
+    assert(!g_kin.validate_homing_axes(1u));
+
+    kin_corexy_install(NULL);
+    assert(g_kin.validate_homing_axes(1u));
+    printf("  [PASSED]\n");
+}
+
+static void run_line(serial_gcode_bridge_t *bridge, const char *line) {
+    char response[64];
+    assert(serial_gcode_bridge_process_line(bridge, line, response, sizeof(response)) == GCODE_OK);
+    while (!serial_gcode_bridge_is_idle(bridge)) {
+        (void)serial_gcode_bridge_poll(bridge);
+        hal_poll();
+    }
+}
+
+/* Status reports convert motor steps back to X/Y through the kinematics,
+ * using the $100..$102 steps/mm */
+static void test_bridge_status_reports_cartesian(void) {
+    printf("Testing CoreXY status reports Cartesian position...\n");
+    static serial_gcode_bridge_t bridge;
+    char response[64];
+
+    hal_init();
+    hal_sim_set_serial_out(NULL);
+    kin_corexy_install(NULL);
+    serial_gcode_bridge_init(&bridge);
+
+    /* Pure Y move: A and B run in opposite directions */
+    run_line(&bridge, "G1 X0 Y5 F600");
+    assert(bridge.stepper.position.v[0] == 400);
+    assert(bridge.stepper.position.v[1] == -400);
+    assert(serial_gcode_bridge_process_line(&bridge, "?", response, sizeof(response)) == GCODE_OK);
+    assert(strcmp(response, "X:0 Y:5000 (x0.001mm)|Ov:100,100,100") == 0);
+
+    /* New steps/mm reach the kinematics' cached reciprocals */
+    assert(serial_gcode_bridge_process_line(&bridge, "$100=160", response, sizeof(response)) == GCODE_OK);
+    assert(serial_gcode_bridge_process_line(&bridge, "$101=160", response, sizeof(response)) == GCODE_OK);
+    assert(g_kin_corexy.joint_mm_per_step[0] == 1.0f / 160.0f);
+    assert(serial_gcode_bridge_process_line(&bridge, "?", response, sizeof(response)) == GCODE_OK);
+    assert(strcmp(response, "X:0 Y:2500 (x0.001mm)|Ov:100,100,100") == 0);
+    printf("  [PASSED]\n");
+}
+
+int main(void) {
+    printf("Running CoreXY kinematics tests...\n");
+    test_defaults_without_install();
+    test_inline_matches_vtable();
+    test_cached_factors_and_direct_steps();
+    test_vtable_stays_pluggable();
+    test_bridge_status_reports_cartesian();
+    printf("All CoreXY kinematics tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,161 @@
+/* parse_bench.c - G-code line parsing throughput (lines per second)
+ *
+ * Parses every line of a G-code file (software/dog.gcode by default)
+ * repeatedly with gcode_parse_line() and with the strtof/strtol parser it
+ * replaced, and checks that both produce the same words.
+ */
+
+#include <ctype.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/gcode.h"
+#include "bench.h"
+
+#define BENCH_DEFAULT_FILE "../software/dog.gcode"
+#define BENCH_MAX_LINES 4096
+#define BENCH_LINE_LEN 128
+#define BENCH_ROUNDS 2000
+
+static char lines[BENCH_MAX_LINES][BENCH_LINE_LEN];
+static int line_count;
+static volatile float parse_sink;   /* Keeps the optimizer from dropping the work */
+
+typedef gcode_status_t (*bench_parse_fn)(const char *line, gcode_block_t *block);
+
+static bool load_lines(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    while (line_count < BENCH_MAX_LINES && fgets(lines[line_count], BENCH_LINE_LEN, f)) {
+        lines[line_count][strcspn(lines[line_count], "\r\n")] = '\0';
+        line_count++;
+    }
+    fclose(f);
+    return true;
+}
+
+static bool libc_float(const char **ptr, float *out) {
+    char *end;
+    float val = strtof(*ptr, &end);
+    if (end == *ptr) return false;
+    *out = val;
+    *ptr = end;
+    return true;
+}
+
+static bool libc_int(const char **ptr, int *out) {
+    char *end;
+    long val = strtol(*ptr, &end, 10);
+    if (end == *ptr) return false;
+    *out = (int)val;
+    *ptr = end;
+    return true;
+}
+
+/* ctype/strtof word parser (the original gcode_parse_line) */
+static gcode_status_t libc_parse_line(const char *line, gcode_block_t *block) {
+    memset(block, 0, sizeof(*block));
+    block->x = block->y = block->f = block->s = block->p = NAN;
+    block->i = block->j = block->r = NAN;
+
+    const char *ptr = line;
+    while (*ptr) {
+        while (*ptr && isspace((unsigned char)*ptr)) ptr++;
+        if (*ptr == '\0') break;
+
+        char letter = (char)toupper((unsigned char)*ptr);
+        ptr++;
+        float *value = NULL;
+        bool *present = NULL;
+        switch (letter) {
+            case 'G':
+                if (!libc_int(&ptr, &block->g_code)) return GCODE_ERR_INVALID_PARAM;
+                block->has_g = true;
+                break;
+            case 'M':
+                if (!libc_int(&ptr, &block->m_code)) return GCODE_ERR_INVALID_PARAM;
+                block->has_m = true;
+                break;
+            case 'X': value = &block->x; present = &block->has_x; break;
+            case 'Y': value = &block->y; present = &block->has_y; break;
+            case 'F': value = &block->f; present = &block->has_f; break;
+            case 'S': value = &block->s; present = &block->has_s; break;
+            case 'P': value = &block->p; present = &block->has_p; break;
+            case 'I': value = &block->i; present = &block->has_i; break;
+            case 'J': value = &block->j; present = &block->has_j; break;
+            case 'R': value = &block->r; present = &block->has_r; break;
+            default:
+                while (*ptr && !isspace((unsigned char)*ptr)) ptr++;
+                break;
+        }
+        if (value != NULL) {
+            if (!libc_float(&ptr, value)) return GCODE_ERR_INVALID_PARAM;
+            *present = true;
+        }
+    }
+    return GCODE_OK;
+}
+
+static bool same_value(bool has_a, float a, bool has_b, float b) {
+    return has_a == has_b && (!has_a || a == b);
+}
+
+static bool same_block(const gcode_block_t *a, const gcode_block_t *b) {
+    return a->has_g == b->has_g && (!a->has_g || a->g_code == b->g_code) &&
+           a->has_m == b->has_m && (!a->has_m || a->m_code == b->m_code) &&
+           same_value(a->has_x, a->x, b->has_x, b->x) &&
+           same_value(a->has_y, a->y, b->has_y, b->y) &&
+           same_value(a->has_f, a->f, b->has_f, b->f) &&
+           same_value(a->has_s, a->s, b->has_s, b->s) &&
+           same_value(a->has_p, a->p, b->has_p, b->p) &&
+           same_value(a->has_i, a->i, b->has_i, b->i) &&
+           same_value(a->has_j, a->j, b->has_j, b->j) &&
+           same_value(a->has_r, a->r, b->has_r, b->r);
+}
+
+static void bench_parse_fn_run(const char *name, bench_parse_fn parse) {
+    gcode_block_t block;
+    uint32_t errors = 0;
+    float sum = 0.0f;
+
+    double t0 = bench_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int n = 0; n < line_count; n++) {
+            if (parse(lines[n], &block) != GCODE_OK) errors++;
+            if (block.has_x) sum += block.x;
+        }
+    }
+    double t1 = bench_seconds();
+    parse_sink = sum;
+
+    bench_report(name, "lines", (double)BENCH_ROUNDS * (double)line_count, t1 - t0);
+    if (errors != 0u) printf("  (%u parse errors)\n", (unsigned)errors);
+}
+
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : BENCH_DEFAULT_FILE;
+    if (!load_lines(path) || line_count == 0) {
+        fprintf(stderr, "cannot read G-code lines from %s\n", path);
+        return 1;
+    }
+
+    int mismatches = 0;
+    for (int n = 0; n < line_count; n++) {
+        gcode_block_t a, b;
+        gcode_status_t sa = gcode_parse_line(lines[n], &a);
+        gcode_status_t sb = libc_parse_line(lines[n], &b);
+        if (sa != sb || (sa == GCODE_OK && !same_block(&a, &b))) {
+            if (mismatches++ < 5) printf("mismatch: %s\n", lines[n]);
+        }
+    }
+
+    printf("G-code parse benchmark (%s, %d lines x %d rounds)\n", path, line_count, BENCH_ROUNDS);
+    bench_parse_fn_run("strtof/ctype parser", libc_parse_line);
+    bench_parse_fn_run("single-pass scanner", gcode_parse_line);
+    printf("lines parsed differently: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "../src/planner.h"
 
 // Test initialization of planner block
@@ -23,7 +24,6 @@ void test_planner_block_init() {
     assert(block.step_event_count == 0);
     assert(block.recalculate_flag == 0);
     assert(block.nominal_length_flag == 0);
-    assert(block.next == NULL);
     
     printf("[passed]\n");
 }
@@ -216,7 +216,6 @@ void test_planner_block_has_required_fields() {
     block.step_event_count = 1000;
     block.recalculate_flag = 1;
     block.nominal_length_flag = 1;
-    block.next = NULL;
     
     // Verify values were set correctly
     assert(block.entry_speed == 100.0f);
@@ -229,7 +228,6 @@ void test_planner_block_has_required_fields() {
     assert(block.step_event_count == 1000);
     assert(block.recalculate_flag == 1);
     assert(block.nominal_length_flag == 1);
-    assert(block.next == NULL);
     
     printf("[passed]\n");
 }
@@ -279,10 +277,17 @@ void test_planner_queue_init() {
     planner_queue_t queue;
     planner_queue_init(&queue, 10);
     
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(queue.head == 0);
+    assert(queue.tail == 0);
     assert(queue.size == 0);
     assert(queue.capacity == 10);
+    assert(planner_peek_front(&queue) == NULL);
+    
+    // Capacity is clamped to the ring size
+    planner_queue_init(&queue, 0);
+    assert(queue.capacity == PLANNER_BUFFER_SIZE);
+    planner_queue_init(&queue, PLANNER_BUFFER_SIZE * 2u);
+    assert(queue.capacity == PLANNER_BUFFER_SIZE);
     
     printf("[passed]\n");
 }
@@ -300,8 +305,11 @@ void test_planner_queue_enqueue_single() {
     
     assert(planner_enqueue(&queue, &block1) == 1);
     assert(queue.size == 1);
-    assert(queue.head == &block1);
-    assert(queue.tail == &block1);
+    
+    // Block is copied into the ring
+    assert(planner_peek_front(&queue) != &block1);
+    assert(planner_peek_front(&queue) == planner_peek_back(&queue));
+    assert(planner_peek_front(&queue)->nominal_speed == 100.0f);
     
     printf("[passed]\n");
 }
@@ -327,8 +335,8 @@ void test_planner_queue_enqueue_multiple() {
     assert(planner_enqueue(&queue, &block3) == 1);
     
     assert(queue.size == 3);
-    assert(queue.head == &block1);
-    assert(queue.tail == &block3);
+    assert(planner_peek_front(&queue)->nominal_speed == 100.0f);
+    assert(planner_peek_back(&queue)->nominal_speed == 300.0f);
     
     printf("[passed]\n");
 }
@@ -347,11 +355,11 @@ void test_planner_queue_dequeue_single() {
     planner_enqueue(&queue, &block1);
     
     planner_block_t *dequeued = planner_dequeue(&queue);
-    assert(dequeued == &block1);
+    assert(dequeued != NULL);
     assert(dequeued->nominal_speed == 100.0f);
     assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_peek_front(&queue) == NULL);
+    assert(planner_peek_back(&queue) == NULL);
     
     printf("[passed]\n");
 }
@@ -377,21 +385,20 @@ void test_planner_queue_dequeue_multiple() {
     planner_enqueue(&queue, &block3);
     
     planner_block_t *dequeued1 = planner_dequeue(&queue);
-    assert(dequeued1 == &block1);
+    assert(dequeued1 != NULL);
     assert(dequeued1->nominal_speed == 100.0f);
     assert(queue.size == 2);
     
     planner_block_t *dequeued2 = planner_dequeue(&queue);
-    assert(dequeued2 == &block2);
+    assert(dequeued2 != NULL);
     assert(dequeued2->nominal_speed == 200.0f);
     assert(queue.size == 1);
     
     planner_block_t *dequeued3 = planner_dequeue(&queue);
-    assert(dequeued3 == &block3);
+    assert(dequeued3 != NULL);
     assert(dequeued3->nominal_speed == 300.0f);
     assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_peek_front(&queue) == NULL);
     
     printf("[passed]\n");
 }
@@ -449,7 +456,7 @@ void test_planner_queue_peek_front() {
     planner_enqueue(&queue, &block2);
     
     planner_block_t *front = planner_peek_front(&queue);
-    assert(front == &block1);
+    assert(front != NULL);
     assert(front->nominal_speed == 100.0f);
     assert(queue.size == 2); // Size should not change
     
@@ -474,7 +481,7 @@ void test_planner_queue_peek_back() {
     planner_enqueue(&queue, &block2);
     
     planner_block_t *back = planner_peek_back(&queue);
-    assert(back == &block2);
+    assert(back != NULL);
     assert(back->nominal_speed == 200.0f);
     assert(queue.size == 2); // Size should not change
     
@@ -536,8 +543,7 @@ void test_planner_queue_clear() {
     planner_queue_clear(&queue);
     
     assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_peek_front(&queue) == NULL);
     assert(planner_is_empty(&queue) == 1);
     
     printf("[passed]\n");
@@ -553,8 +559,7 @@ void test_planner_queue_clear_empty() {
     planner_queue_clear(&queue);
     
     assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_peek_front(&queue) == NULL);
     
     printf("[passed]\n");
 }
@@ -569,14 +574,16 @@ void test_planner_queue_enqueue_after_clear() {
     planner_block_t block1, block2;
     planner_block_init(&block1);
     planner_block_init(&block2);
+    block1.nominal_speed = 100.0f;
+    block2.nominal_speed = 200.0f;
     
     planner_enqueue(&queue, &block1);
     planner_queue_clear(&queue);
     
     assert(planner_enqueue(&queue, &block2) == 1);
     assert(queue.size == 1);
-    assert(queue.head == &block2);
-    assert(queue.tail == &block2);
+    assert(planner_peek_front(&queue)->nominal_speed == 200.0f);
+    assert(planner_peek_front(&queue) == planner_peek_back(&queue));
     
     printf("[passed]\n");
 }
@@ -590,8 +597,10 @@ void test_planner_queue_null_parameters() {
     
     // NULL queue
     planner_queue_init(NULL, 10);
+    assert(planner_alloc_block(NULL) == NULL);
     assert(planner_enqueue(NULL, &block) == 0);
     assert(planner_dequeue(NULL) == NULL);
+    planner_discard_front(NULL);
     assert(planner_peek_front(NULL) == NULL);
     assert(planner_peek_back(NULL) == NULL);
     assert(planner_is_empty(NULL) == 1);
@@ -604,6 +613,335 @@ void test_planner_queue_null_parameters() {
     printf("[passed]\n");
 }
 
+// Test building a block in place in the ring
+void test_planner_queue_alloc_in_place() {
+    printf("Testing planner queue in-place allocation...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 2);
+    
+    planner_block_t *slot = planner_alloc_block(&queue);
+    assert(slot != NULL);
+    planner_block_init(slot);
+    slot->nominal_speed = 123.0f;
+    
+    // Not queued until enqueued
+    assert(queue.size == 0);
+    assert(planner_enqueue(&queue, slot) == 1);
+    assert(planner_peek_front(&queue) == slot);
+    assert(slot->nominal_speed == 123.0f);
+    
+    slot = planner_alloc_block(&queue);
+    assert(slot != NULL);
+    assert(planner_enqueue(&queue, slot) == 1);
+    assert(planner_alloc_block(&queue) == NULL); // Full
+    
+    printf("[passed]\n");
+}
+
+// Test that head/tail wrap around the ring
+void test_planner_queue_wraparound() {
+    printf("Testing planner queue wraparound...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 0);
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    
+    for (uint32_t i = 0; i < PLANNER_BUFFER_SIZE * 3u; i++) {
+        block.nominal_speed = (float)i;
+        assert(planner_enqueue(&queue, &block) == 1);
+        if (i >= 2) {
+            // Keep two blocks queued while cycling through the ring
+            planner_block_t *front = planner_peek_front(&queue);
+            assert(front->nominal_speed == (float)(i - 2));
+            planner_discard_front(&queue);
+        }
+        assert(queue.head < PLANNER_BUFFER_SIZE);
+        assert(queue.tail < PLANNER_BUFFER_SIZE);
+    }
+    assert(queue.size == 2);
+    assert(planner_peek_back(&queue)->nominal_speed == (float)(PLANNER_BUFFER_SIZE * 3u - 1u));
+    
+    printf("[passed]\n");
+}
+
+// ===== Look-ahead Tests =====
+
+static int near(float a, float b, float tol) {
+    float d = a - b;
+    return d < tol && d > -tol;
+}
+
+static planner_block_t* plan_move(planner_queue_t *queue, float dx, float dy, float feed) {
+    float delta[KIN_MAX_CART_AXES] = {dx, dy, 0.0f};
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = feed;
+    assert(planner_plan_block(queue, &block, delta) == 1);
+    return planner_peek_back(queue);
+}
+
+// Test that collinear moves carry nominal speed through their junctions
+void test_planner_lookahead_collinear() {
+    printf("Testing planner look-ahead on collinear moves...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 10);
+    
+    planner_block_t *b1 = plan_move(&queue, 10.0f, 0.0f, 1200.0f);
+    planner_block_t *b2 = plan_move(&queue, 10.0f, 0.0f, 1200.0f);
+    planner_block_t *b3 = plan_move(&queue, 10.0f, 0.0f, 1200.0f);
+    
+    // 200 mm/s^2 on X
+    assert(near(b1->acceleration, 200.0f * 3600.0f, 1.0f));
+    assert(near(b1->millimeters, 10.0f, 1e-4f));
+    
+    assert(b1->entry_speed == 0.0f);
+    assert(near(b1->exit_speed, 1200.0f, 0.01f));
+    assert(near(b2->entry_speed, 1200.0f, 0.01f));
+    assert(near(b3->entry_speed, 1200.0f, 0.01f));
+    assert(b3->exit_speed == 0.0f);
+    
+    assert(planner_block_validate(b1) == 1);
+    assert(planner_block_validate(b2) == 1);
+    assert(planner_block_validate(b3) == 1);
+    
+    printf("[passed]\n");
+}
+
+// Test that a 90 degree corner is limited by junction deviation
+void test_planner_lookahead_corner() {
+    printf("Testing planner look-ahead on a 90 degree corner...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 10);
+    
+    planner_block_t *b1 = plan_move(&queue, 10.0f, 0.0f, 1200.0f);
+    planner_block_t *b2 = plan_move(&queue, 0.0f, 10.0f, 1200.0f);
+    
+    // a = 200/cos(45) mm/s^2, v^2 = a * 0.01 * sin(45) / (1 - sin(45))
+    assert(near(b2->max_entry_speed, 156.8f, 0.5f));
+    assert(near(b2->entry_speed, b2->max_entry_speed, 0.01f));
+    assert(near(b1->exit_speed, b2->entry_speed, 0.01f));
+    
+    // Larger junction deviation allows a faster corner
+    planner_settings_t settings = queue.settings;
+    settings.junction_deviation_mm = 0.1f;
+    planner_queue_t loose;
+    planner_queue_init(&loose, 10);
+    planner_set_settings(&loose, &settings);
+    
+    plan_move(&loose, 10.0f, 0.0f, 1200.0f);
+    planner_block_t *c2 = plan_move(&loose, 0.0f, 10.0f, 1200.0f);
+    assert(c2->entry_speed > b2->entry_speed);
+    
+    printf("[passed]\n");
+}
+
+// Test that a full reversal stops at the junction
+void test_planner_lookahead_reversal() {
+    printf("Testing planner look-ahead on a reversal...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 10);
+    
+    planner_block_t *b1 = plan_move(&queue, 10.0f, 0.0f, 1200.0f);
+    planner_block_t *b2 = plan_move(&queue, -10.0f, 0.0f, 1200.0f);
+    
+    assert(b2->entry_speed == 0.0f);
+    assert(b1->exit_speed == 0.0f);
+    
+    printf("[passed]\n");
+}
+
+// Test that short blocks limit entry speed so the queue can still stop
+void test_planner_lookahead_short_blocks() {
+    printf("Testing planner look-ahead on short blocks...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 10);
+    
+    planner_block_t *b1 = plan_move(&queue, 100.0f, 0.0f, 6000.0f);
+    planner_block_t *b2 = plan_move(&queue, 0.05f, 0.0f, 6000.0f);
+    planner_block_t *b3 = plan_move(&queue, 0.05f, 0.0f, 6000.0f);
+    
+    // Last block must stop: entry limited to sqrt(2 * a * d)
+    float a = 200.0f * 3600.0f;
+    assert(near(b3->entry_speed, sqrtf(2.0f * a * 0.05f), 0.5f));
+    assert(near(b2->entry_speed, sqrtf(2.0f * a * 0.10f), 0.5f));
+    assert(b2->entry_speed < b2->nominal_speed);
+    assert(b3->nominal_length_flag == 0);
+    assert(b1->nominal_length_flag == 1);
+    
+    // Appending more blocks raises the junction speeds again
+    planner_block_t *b4 = plan_move(&queue, 10.0f, 0.0f, 6000.0f);
+    assert(b3->entry_speed > sqrtf(2.0f * a * 0.05f) + 1.0f);
+    assert(near(b3->exit_speed, b4->entry_speed, 0.01f));
+    
+    printf("[passed]\n");
+}
+
+// Test that S-curve ramps plan lower entry speeds so the ramps still fit
+void test_planner_lookahead_scurve_ramps() {
+    printf("Testing planner look-ahead with S-curve ramps...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 10);
+    planner_ramp_t ramp = { .scurve = 1u, .jerk_mm_per_s3 = 0.0f };
+    planner_set_ramp(&queue, &ramp);
+    
+    plan_move(&queue, 10.0f, 0.0f, 1200.0f);
+    planner_block_t *b2 = plan_move(&queue, 1.0f, 0.0f, 1200.0f);
+    
+    // Mean acceleration is 2/3 of the limit
+    float a = 200.0f * 3600.0f;
+    assert(near(b2->entry_speed, sqrtf(2.0f * a / 1.5f * 1.0f), 0.5f));
+    assert(near(planner_ramp_mm(&ramp, 200.0f, b2->entry_speed / 60.0f, 0.0f), 1.0f, 0.001f));
+    
+    // A jerk limit stretches the ramp further: entry lower still, the stop
+    // ramp still exactly fits
+    planner_queue_init(&queue, 10);
+    ramp.jerk_mm_per_s3 = 2000.0f;
+    planner_set_ramp(&queue, &ramp);
+    plan_move(&queue, 10.0f, 0.0f, 1200.0f);
+    b2 = plan_move(&queue, 1.0f, 0.0f, 1200.0f);
+    assert(b2->entry_speed < sqrtf(2.0f * a / 1.5f * 1.0f) - 60.0f);
+    assert(near(planner_ramp_mm(&ramp, 200.0f, b2->entry_speed / 60.0f, 0.0f), 1.0f, 0.001f));
+    
+    printf("[passed]\n");
+}
+
+// Test look-ahead parameter handling
+void test_planner_lookahead_invalid() {
+    printf("Testing planner look-ahead parameter handling...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 1);
+    
+    planner_block_t b1, b2;
+    float zero[KIN_MAX_CART_AXES] = {0.0f, 0.0f, 0.0f};
+    planner_block_init(&b1);
+    assert(planner_plan_block(&queue, &b1, zero) == 0);
+    assert(planner_plan_block(NULL, &b1, zero) == 0);
+    assert(planner_plan_block(&queue, NULL, zero) == 0);
+    assert(planner_plan_block(&queue, &b1, NULL) == 0);
+    
+    plan_move(&queue, 1.0f, 0.0f, 100.0f);
+    float delta[KIN_MAX_CART_AXES] = {1.0f, 0.0f, 0.0f};
+    planner_block_init(&b2);
+    assert(planner_plan_block(&queue, &b2, delta) == 0); // Queue full
+    
+    printf("[passed]\n");
+}
+
+// ===== Cartesian Line Tests =====
+
+// Test that line targets become absolute step counts and real blocks
+void test_planner_line_to_steps() {
+    printf("Testing planner line-to step conversion...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 0);
+    planner_line_data_t data = { .feed_rate = 600.0f, .rapid = 0 };
+    
+    // 80 steps/mm default, Cartesian identity kinematics
+    kin_cart_t t1 = {{ 10.0f, -5.0f, 0.0f }};
+    assert(planner_line_to(&queue, &t1, &data) == PLANNER_LINE_OK);
+    planner_block_t *b1 = planner_peek_back(&queue);
+    assert(b1->steps[0] == 800 && b1->steps[1] == 400 && b1->steps[2] == 0);
+    assert(b1->step_event_count == 800);
+    assert((b1->direction_bits & 0x01) != 0);
+    assert((b1->direction_bits & 0x02) == 0);
+    assert(near(b1->millimeters, sqrtf(125.0f), 1e-3f));
+    assert(b1->nominal_speed == 600.0f);
+    assert(queue.position_steps.v[0] == 800 && queue.position_steps.v[1] == -400);
+    
+    // Many short segments round against absolute targets: no drift
+    for (int i = 1; i <= 300; i++) {
+        kin_cart_t t = {{ 10.0f + 0.0123f * (float)i, -5.0f, 0.0f }};
+        planner_line_status_t st = planner_line_to(&queue, &t, &data);
+        if (st == PLANNER_LINE_FULL) {
+            planner_queue_clear(&queue);
+            st = planner_line_to(&queue, &t, &data);
+        }
+        assert(st == PLANNER_LINE_OK);
+    }
+    assert(queue.position_steps.v[0] == (int32_t)lroundf((10.0f + 0.0123f * 300.0f) * 80.0f));
+    
+    // Shorter than a step: nothing queued, distance carries over
+    planner_queue_clear(&queue);
+    kin_cart_t here = queue.position;
+    kin_cart_t tiny = {{ here.v[0] + 0.001f, here.v[1], 0.0f }};
+    assert(planner_line_to(&queue, &tiny, &data) == PLANNER_LINE_OK);
+    assert(planner_is_empty(&queue));
+    assert(queue.position.v[0] == here.v[0]);
+    
+    printf("[passed]\n");
+}
+
+// Test rapid speed limits, full queue and invalid requests
+void test_planner_line_to_limits() {
+    printf("Testing planner line-to limits...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 2);
+    planner_line_data_t rapid = { .feed_rate = 0.0f, .rapid = 1 };
+    planner_line_data_t fast = { .feed_rate = 100000.0f, .rapid = 0 };
+    
+    // Rapid diagonal in XY: each axis at its 3000 mm/min max
+    kin_cart_t t1 = {{ 10.0f, 10.0f, 0.0f }};
+    assert(planner_line_to(&queue, &t1, &rapid) == PLANNER_LINE_OK);
+    assert(near(planner_peek_back(&queue)->nominal_speed, 3000.0f * sqrtf(2.0f), 0.5f));
+    
+    // Feed above the Z max rate is clamped to it
+    kin_cart_t t2 = {{ 10.0f, 10.0f, 5.0f }};
+    assert(planner_line_to(&queue, &t2, &fast) == PLANNER_LINE_OK);
+    assert(near(planner_peek_back(&queue)->nominal_speed, 500.0f, 0.01f));
+    
+    // Queue full: position unchanged until there is room
+    kin_cart_t t3 = {{ 0.0f, 0.0f, 0.0f }};
+    assert(planner_line_to(&queue, &t3, &fast) == PLANNER_LINE_FULL);
+    assert(queue.position.v[2] == 5.0f);
+    
+    assert(planner_line_to(NULL, &t3, &fast) == PLANNER_LINE_INVALID);
+    assert(planner_line_to(&queue, NULL, &fast) == PLANNER_LINE_INVALID);
+    assert(planner_line_to(&queue, &t3, NULL) == PLANNER_LINE_INVALID);
+    
+    printf("[passed]\n");
+}
+
+// Test position redefinition and resync from executed steps
+void test_planner_set_and_sync_position() {
+    printf("Testing planner position set/sync...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 0);
+    
+    kin_cart_t origin = {{ 2.5f, -1.0f, 0.0f }};
+    planner_set_position(&queue, &origin);
+    assert(queue.position_steps.v[0] == 200 && queue.position_steps.v[1] == -80);
+    
+    // Next move is relative to the new position
+    planner_line_data_t data = { .feed_rate = 600.0f, .rapid = 0 };
+    kin_cart_t t1 = {{ 5.0f, -1.0f, 0.0f }};
+    assert(planner_line_to(&queue, &t1, &data) == PLANNER_LINE_OK);
+    assert(planner_peek_back(&queue)->steps[0] == 200);
+    assert(planner_peek_back(&queue)->steps[1] == 0);
+    
+    // Abort part way: resync to the steps actually taken
+    kin_steps_t taken = {{ 320, -80, 0, 0 }};
+    planner_sync_position(&queue, &taken);
+    kin_cart_t pos;
+    planner_get_position(&queue, &pos);
+    assert(near(pos.v[0], 4.0f, 1e-5f));
+    assert(near(pos.v[1], -1.0f, 1e-5f));
+    assert(queue.position_steps.v[0] == 320);
+    
+    printf("[passed]\n");
+}
+
 // Main function to execute all test cases
 int main() {
     printf("=== Running Planner Block Tests ===\n\n");
@@ -644,8 +982,31 @@ int main() {
     test_planner_queue_clear_empty();
     test_planner_queue_enqueue_after_clear();
     test_planner_queue_null_parameters();
+    test_planner_queue_alloc_in_place();
+    test_planner_queue_wraparound();
     
     printf("\n=== All planner queue tests passed! ===\n");
     
+    // Run look-ahead tests
+    printf("\n=== Running Planner Look-ahead Tests ===\n\n");
+    
+    test_planner_lookahead_collinear();
+    test_planner_lookahead_corner();
+    test_planner_lookahead_reversal();
+    test_planner_lookahead_short_blocks();
+    test_planner_lookahead_scurve_ramps();
+    test_planner_lookahead_invalid();
+    
+    printf("\n=== All planner look-ahead tests passed! ===\n");
+    
+    // Run Cartesian line tests
+    printf("\n=== Running Planner Line Tests ===\n\n");
+    
+    test_planner_line_to_steps();
+    test_planner_line_to_limits();
+    test_planner_set_and_sync_position();
+    
+    printf("\n=== All planner line tests passed! ===\n");
+    
     return 0;
 }
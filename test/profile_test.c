@@ -0,0 +1,134 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/firmware_gcode_streamer.h"
+#include "../src/hal_linux_sim.h"
+#include "../src/profile.h"
+#include "../src/uart_dma_rx.h"
+
+#if !GRBL_FEATURE_PROFILE
+#error "profile_test needs GRBL_FEATURE_PROFILE=1"
+#endif
+
+static char report_lines[PROFILE_ZONE_COUNT + 2][64];
+static int report_count;
+
+static void capture_report(void *ctx, const char *msg) {
+    (void)ctx;
+    if (report_count < (int)(sizeof(report_lines) / sizeof(report_lines[0]))) {
+        snprintf(report_lines[report_count], sizeof(report_lines[0]), "%s", msg);
+    }
+    report_count++;
+}
+
+static void test_zone_statistics(void) {
+    printf("Testing zone statistics...\n");
+    profile_stats_t st;
+    profile_reset();
+
+    profile_get(PROFILE_ZONE_PARSE, &st);
+    assert(st.count == 0u && st.min_cycles == 0u && st.max_cycles == 0u && st.total_cycles == 0u);
+
+    profile_record(PROFILE_ZONE_PARSE, 30u);
+    profile_record(PROFILE_ZONE_PARSE, 10u);
+    profile_record(PROFILE_ZONE_PARSE, 20u);
+    profile_record(PROFILE_ZONE_COUNT, 5u);   /* Out of range: ignored */
+    profile_get(PROFILE_ZONE_PARSE, &st);
+    assert(st.count == 3u);
+    assert(st.min_cycles == 10u);
+    assert(st.max_cycles == 30u);
+    assert(st.total_cycles == 60u);
+
+    profile_get(PROFILE_ZONE_PLAN, &st);
+    assert(st.count == 0u);
+    assert(strcmp(profile_zone_name(PROFILE_ZONE_STEP_ISR), "step_isr") == 0);
+    assert(strcmp(profile_zone_name(PROFILE_ZONE_COUNT), "?") == 0);
+
+    profile_reset();
+    profile_get(PROFILE_ZONE_PARSE, &st);
+    assert(st.count == 0u);
+    printf("  [PASSED]\n");
+}
+
+/* Stream a job the way the firmware does: DMA receive -> streamer poll ->
+ * bridge -> planner -> stepper, with the step ISR on virtual time */
+static void test_job_fills_every_zone(void) {
+    printf("Testing a streamed job fills every zone...\n");
+    static fw_gcode_streamer_t streamer;
+    static uart_dma_rx_t rx;
+    static const char job[] =
+        "G21\nG90\nG1 X5 Y2 F1200\nG2 X10 Y2 I2.5 J0\nG0 X0 Y0\nG1 X1 Y1\n";
+
+    hal_init();
+    profile_reset();
+    fw_gcode_streamer_init(&streamer);
+    uart_dma_rx_init(&rx);
+    uart_dma_rx_set_realtime(&rx, fw_gcode_streamer_rx_realtime, &streamer);
+
+    /* The DMA writes the job into the circular buffer a few bytes at a time */
+    uint16_t write_pos = 0u;
+    for (size_t i = 0; i < sizeof(job) - 1u; i++) {
+        rx.buf[write_pos] = (uint8_t)job[i];
+        write_pos = (uint16_t)((write_pos + 1u) % UART_DMA_RX_SIZE);
+        if (i % 8u == 7u || i == sizeof(job) - 2u) {
+            (void)uart_dma_rx_service(&rx, write_pos, &streamer.uart);
+            fw_gcode_streamer_poll(&streamer);
+            hal_poll();
+        }
+    }
+    while (!serial_gcode_bridge_is_idle(&streamer.bridge)) {
+        fw_gcode_streamer_poll(&streamer);
+        hal_poll();
+    }
+
+    profile_stats_t st;
+    for (profile_zone_t zone = (profile_zone_t)0; zone < PROFILE_ZONE_COUNT; zone++) {
+        profile_get(zone, &st);
+        assert(st.count > 0u);
+        assert(st.min_cycles <= st.max_cycles);
+        assert(st.total_cycles >= (uint64_t)st.min_cycles * st.count);
+        assert(st.total_cycles <= (uint64_t)st.max_cycles * st.count);
+    }
+    profile_get(PROFILE_ZONE_FRAMING, &st);
+    assert(st.count == 6u);
+    profile_get(PROFILE_ZONE_PARSE, &st);
+    assert(st.count >= 6u);
+    hal_sim_stats_t sim;
+    hal_sim_get_stats(&sim);
+    profile_get(PROFILE_ZONE_STEP_ISR, &st);
+    assert(st.count == sim.isr_calls);
+    printf("  [PASSED]\n");
+}
+
+static void test_report_command(void) {
+    printf("Testing $P report...\n");
+    static serial_gcode_bridge_t bridge;
+    char response[64];
+
+    hal_init();
+    profile_reset();
+    profile_record(PROFILE_ZONE_PLAN, 100u);
+    profile_record(PROFILE_ZONE_PLAN, 300u);
+    serial_gcode_bridge_init(&bridge);
+    serial_gcode_bridge_set_report(&bridge, capture_report, NULL);
+
+    report_count = 0;
+    assert(serial_gcode_bridge_process_line(&bridge, "$P", response, sizeof(response)) == GCODE_OK);
+    assert(strcmp(response, "OK") == 0);
+    assert(report_count == (int)PROFILE_ZONE_COUNT);
+    assert(strcmp(report_lines[PROFILE_ZONE_RX_FEED], "[PRF:rx_feed,0,0,0,0]") == 0);
+    assert(strcmp(report_lines[PROFILE_ZONE_PLAN], "[PRF:plan,2,100,200,300]") == 0);
+    assert(strncmp(report_lines[PROFILE_ZONE_STEP_ISR], "[PRF:step_isr,", 14) == 0);
+    printf("  [PASSED]\n");
+}
+
+int main(void) {
+    printf("Running profiling tests...\n");
+    test_zone_statistics();
+    test_job_fills_every_zone();
+    test_report_command();
+    printf("All profiling tests passed!\n");
+    return 0;
+}
@@ -51,6 +51,50 @@ int main(void) {
     assert(capture.count == 4u);
     assert(capture.cmd == PROTO_RT_RESET);
 
+    /* Realtime classification used by the raw receive paths */
+    assert(protocol_rt_classify((uint8_t)'?') == PROTO_RT_STATUS_QUERY);
+    assert(protocol_rt_classify((uint8_t)'!') == PROTO_RT_FEED_HOLD);
+    assert(protocol_rt_classify((uint8_t)'~') == PROTO_RT_CYCLE_START);
+    assert(protocol_rt_classify(0x18u) == PROTO_RT_RESET);
+    assert(protocol_rt_classify((uint8_t)'G') == PROTO_RT_NONE);
+    assert(protocol_rt_classify((uint8_t)'\n') == PROTO_RT_NONE);
+    assert(protocol_rt_classify(0x90u) == PROTO_RT_FEED_OVR_RESET);
+    assert(protocol_rt_classify(0x94u) == PROTO_RT_FEED_OVR_FINE_MINUS);
+    assert(protocol_rt_classify(0x97u) == PROTO_RT_RAPID_OVR_LOW);
+    assert(protocol_rt_classify(0x98u) == PROTO_RT_NONE);
+    assert(protocol_rt_classify(0x9Du) == PROTO_RT_SPINDLE_OVR_FINE_MINUS);
+    assert(protocol_rt_is_override(PROTO_RT_RAPID_OVR_MEDIUM));
+    assert(!protocol_rt_is_override(PROTO_RT_FEED_HOLD));
+
+    /* Override bytes never reach the line buffer */
+    const uint8_t ovr_stream[] = {'G', 0x91u, '1', '\n'};
+    protocol_feed_bytes(&proto, ovr_stream, sizeof(ovr_stream));
+    assert(capture.cmd == PROTO_RT_FEED_OVR_COARSE_PLUS);
+    assert(protocol_pop_line(&proto, out, sizeof(out), &status));
+    assert(status == PROTO_LINE_OK);
+    assert(strcmp(out, "G1") == 0);
+
+    /* Override steps clamp at the limits */
+    proto_overrides_t ovr;
+    protocol_overrides_init(&ovr);
+    assert(ovr.feed == 100u && ovr.rapid == 100u && ovr.spindle == 100u);
+    assert(!protocol_apply_override(&ovr, PROTO_RT_FEED_OVR_RESET));
+    assert(protocol_apply_override(&ovr, PROTO_RT_FEED_OVR_FINE_MINUS));
+    assert(ovr.feed == 99u);
+    for (unsigned i = 0u; i < 20u; ++i) {
+        (void)protocol_apply_override(&ovr, PROTO_RT_FEED_OVR_COARSE_PLUS);
+    }
+    assert(ovr.feed == PROTO_OVR_FEED_MAX);
+    assert(!protocol_apply_override(&ovr, PROTO_RT_FEED_OVR_FINE_PLUS));
+    for (unsigned i = 0u; i < 30u; ++i) {
+        (void)protocol_apply_override(&ovr, PROTO_RT_SPINDLE_OVR_COARSE_MINUS);
+    }
+    assert(ovr.spindle == PROTO_OVR_SPINDLE_MIN);
+    assert(protocol_apply_override(&ovr, PROTO_RT_RAPID_OVR_LOW));
+    assert(ovr.rapid == PROTO_OVR_RAPID_LOW);
+    assert(protocol_apply_override(&ovr, PROTO_RT_RAPID_OVR_RESET));
+    assert(ovr.rapid == PROTO_OVR_DEFAULT);
+
     printf("All protocol tests passed!\n");
     return 0;
 }
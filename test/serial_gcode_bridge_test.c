@@ -7,6 +7,7 @@
 #include "../src/serial_uart.h"
 #include "../src/hal.h"
 #include "../src/kinematics.h"
+#include "../src/arc.h"
 
 static bool mock_motor_enabled = false;
 static uint32_t mock_pulse_counts[HAL_AXIS_MAX];
@@ -25,6 +26,20 @@ static const float FLOAT_EPSILON = 0.0001f;
 static const char DRIVER_READY_MSG[] = "CNC ready";
 static const char DRIVER_READY_LINE[] = "CNC ready\r\n";
 static uint32_t mock_motion_backend_calls = 0u;
+static uint32_t mock_spindle_calls = 0u;
+static hal_spindle_dir_t mock_spindle_dir = HAL_SPINDLE_OFF;
+static float mock_spindle_pwm = 0.0f;
+static float mock_spindle_max_pwm = 0.0f;
+static hal_step_timer_cb_t mock_timer_cb = NULL;
+static void *mock_timer_user = NULL;
+static bool mock_timer_running = false;
+static const size_t TEST_DRAIN_ITERATIONS_LIMIT = 100000u;
+static char mock_report_text[256];
+static uint32_t mock_report_calls = 0u;
+/* Realtime byte "received" by hal_poll() once mock_rt_after_polls runs out */
+static serial_gcode_bridge_t *mock_rt_bridge = NULL;
+static proto_rt_cmd_t mock_rt_cmd = PROTO_RT_NONE;
+static uint32_t mock_rt_after_polls = 0u;
 
 hal_status_t hal_init(void) { return HAL_OK; }
 void hal_start(void) {}
@@ -77,6 +92,7 @@ void hal_stepper_set_dir(hal_axis_t axis, bool dir_positive) {
 }
 void hal_stepper_step_pulse(hal_axis_t axis) { mock_pulse_counts[axis]++; }
 void hal_stepper_step_clear(hal_axis_t axis) { (void)axis; }
+void hal_stepper_set_pulse_width(uint32_t ticks) { (void)ticks; }
 void hal_stepper_pulse_mask(uint32_t axis_mask) {
     mock_pulse_mask_calls++;
     for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
@@ -86,8 +102,12 @@ void hal_stepper_pulse_mask(uint32_t axis_mask) {
     }
 }
 void hal_spindle_set(hal_spindle_dir_t dir, float pwm_0_to_1) {
-    (void)dir;
-    (void)pwm_0_to_1;
+    mock_spindle_calls++;
+    mock_spindle_dir = dir;
+    mock_spindle_pwm = pwm_0_to_1;
+    if (pwm_0_to_1 > mock_spindle_max_pwm) {
+        mock_spindle_max_pwm = pwm_0_to_1;
+    }
 }
 void hal_coolant_mist(bool on) { (void)on; }
 void hal_coolant_flood(bool on) { (void)on; }
@@ -96,7 +116,28 @@ void hal_read_inputs(hal_inputs_t *out) {
         *out = mock_inputs;
     }
 }
-void hal_poll(void) { mock_time_us++; }
+void hal_step_timer_init(hal_step_timer_cb_t cb, void *user) {
+    mock_timer_cb = cb;
+    mock_timer_user = user;
+    mock_timer_running = false;
+}
+void hal_step_timer_start(uint32_t period_ticks) {
+    (void)period_ticks;
+    mock_timer_running = true;
+}
+void hal_step_timer_set_period(uint32_t period_ticks) { (void)period_ticks; }
+void hal_step_timer_stop(void) { mock_timer_running = false; }
+/* Each poll lets one step timer interrupt fire, so motion runs in the
+ * background of anything that polls. */
+void hal_poll(void) {
+    mock_time_us++;
+    if (mock_rt_bridge != NULL && mock_rt_after_polls > 0u && --mock_rt_after_polls == 0u) {
+        serial_gcode_bridge_realtime(mock_rt_bridge, mock_rt_cmd);
+    }
+    if (mock_timer_running && mock_timer_cb != NULL) {
+        mock_timer_cb(mock_timer_user);
+    }
+}
 void hal_tick_1khz_isr(void) {}
 
 static void reset_mocks(void) {
@@ -111,6 +152,31 @@ static void reset_mocks(void) {
     memset(&mock_inputs, 0, sizeof(mock_inputs));
     mock_pulse_mask_calls = 0u;
     mock_motion_backend_calls = 0u;
+    mock_timer_running = false;
+    mock_report_text[0] = '\0';
+    mock_report_calls = 0u;
+    mock_rt_bridge = NULL;
+    mock_rt_cmd = PROTO_RT_NONE;
+    mock_rt_after_polls = 0u;
+    mock_spindle_calls = 0u;
+    mock_spindle_dir = HAL_SPINDLE_OFF;
+    mock_spindle_pwm = 0.0f;
+    mock_spindle_max_pwm = 0.0f;
+}
+
+static void mock_report(void *ctx, const char *msg) {
+    (void)ctx;
+    mock_report_calls++;
+    snprintf(mock_report_text, sizeof(mock_report_text), "%s", msg);
+}
+
+/* Main loop stand-in: run queued motion to completion */
+static void drain_motion(serial_gcode_bridge_t *bridge) {
+    for (size_t i = 0; i < TEST_DRAIN_ITERATIONS_LIMIT && !serial_gcode_bridge_is_idle(bridge); ++i) {
+        (void)serial_gcode_bridge_poll(bridge);
+        hal_poll();
+    }
+    assert(serial_gcode_bridge_is_idle(bridge));
 }
 
 static bool mock_motion_backend(void *ctx,
@@ -205,8 +271,9 @@ static void test_g0_motion_emits_ok_and_steps(void) {
     assert(st == GCODE_OK);
     assert(strcmp(response, "OK") == 0);
     assert(mock_motor_enabled);
+    drain_motion(&bridge);
     assert(mock_dir_set_counts[HAL_AXIS_X] > 0u);
-    assert(mock_pulse_counts[HAL_AXIS_X] > 0u);
+    assert(mock_pulse_counts[HAL_AXIS_X] == 80u);
 }
 
 static void test_enable_disable_commands(void) {
@@ -237,6 +304,29 @@ static void test_identity_query_returns_firmware_info(void) {
     assert(strcmp(response, "[FW:STM32G4 CNC_machine_Proj]") == 0);
 }
 
+static void test_profile_report_needs_profiling_build(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "$P", response, sizeof(response));
+    assert(st == GCODE_ERR_UNSUPPORTED_CMD);
+    assert(strcmp(response, "error: profiling disabled") == 0);
+}
+
+static void test_isr_latency_report_needs_latency_build(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    assert(serial_gcode_bridge_process_line(&bridge, "$L", response, sizeof(response)) == GCODE_ERR_UNSUPPORTED_CMD);
+    assert(strcmp(response, "error: ISR latency disabled") == 0);
+    assert(serial_gcode_bridge_process_line(&bridge, "$LR", response, sizeof(response)) == GCODE_ERR_UNSUPPORTED_CMD);
+    assert(strcmp(response, "error: ISR latency disabled") == 0);
+}
+
 static void test_invalid_line_returns_error(void) {
     reset_mocks();
     serial_gcode_bridge_t bridge;
@@ -248,7 +338,7 @@ static void test_invalid_line_returns_error(void) {
     assert(strncmp(response, "error:", 6) == 0);
 }
 
-static void test_settings_dump_contains_required_entries_without_laser(void) {
+static void test_settings_dump_contains_required_entries(void) {
     reset_mocks();
     serial_gcode_bridge_t bridge;
     serial_gcode_bridge_init(&bridge);
@@ -258,7 +348,7 @@ static void test_settings_dump_contains_required_entries_without_laser(void) {
     assert(st == GCODE_OK);
     assert(strstr(response, "$0=") != NULL);
     assert(strstr(response, "$132=") != NULL);
-    assert(strstr(response, "$32=") == NULL);
+    assert(strstr(response, "$32=0") != NULL);
 }
 
 static void test_setting_assignment_updates_internal_values(void) {
@@ -277,22 +367,33 @@ static void test_setting_assignment_updates_internal_values(void) {
     assert(strcmp(response, "OK") == 0);
     assert(bridge.step_pulse_delay_us == 9u);
     assert(bridge.settings.step_pulse_time_us == 9u);
+
+    st = serial_gcode_bridge_process_line(&bridge, "$12=0.01", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(fabsf(arc_get_tolerance_mm() - 0.01f) < FLOAT_EPSILON);
+    serial_gcode_bridge_init(&bridge);
+    assert(fabsf(arc_get_tolerance_mm() - 0.002f) < FLOAT_EPSILON);
 }
 
-static void test_setting_assignment_rejects_laser_and_invalid_values(void) {
+static void test_setting_assignment_rejects_invalid_values(void) {
     reset_mocks();
     serial_gcode_bridge_t bridge;
     serial_gcode_bridge_init(&bridge);
 
     char response[128];
-    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "$32=1", response, sizeof(response));
-    assert(st == GCODE_ERR_UNSUPPORTED_CMD);
-    assert(strstr(response, "unsupported setting $32") != NULL);
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "$32=2", response, sizeof(response));
+    assert(st == GCODE_ERR_INVALID_PARAM);
+    assert(strstr(response, "invalid value for setting $32") != NULL);
+    assert(!bridge.settings.laser_mode);
 
     st = serial_gcode_bridge_process_line(&bridge, "$100=abc", response, sizeof(response));
     assert(st == GCODE_ERR_INVALID_PARAM);
     assert(strstr(response, "invalid value for setting $100") != NULL);
 
+    st = serial_gcode_bridge_process_line(&bridge, "$12=0", response, sizeof(response));
+    assert(st == GCODE_ERR_INVALID_PARAM);
+    assert(fabsf(bridge.settings.arc_tolerance_mm - 0.002f) < FLOAT_EPSILON);
+
     st = serial_gcode_bridge_process_line(&bridge, "$999=1", response, sizeof(response));
     assert(st == GCODE_ERR_INVALID_PARAM);
     assert(strstr(response, "unknown setting $999") != NULL);
@@ -437,6 +538,7 @@ static void test_xy_motion_uses_atomic_pulse_mask(void) {
     gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G0 X1 Y1", response, sizeof(response));
     assert(st == GCODE_OK);
     assert(strcmp(response, "OK") == 0);
+    drain_motion(&bridge);
     assert(mock_pulse_mask_calls > 0u);
     assert(mock_pulse_counts[HAL_AXIS_X] > 0u);
     assert(mock_pulse_counts[HAL_AXIS_Y] > 0u);
@@ -484,15 +586,424 @@ static void test_custom_motion_backend_is_used(void) {
     assert(mock_pulse_mask_calls == 0u);
 }
 
+static void test_motion_replies_ok_before_move_finishes(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(strcmp(response, "OK") == 0);
+    assert(!serial_gcode_bridge_is_idle(&bridge));
+    assert(mock_pulse_counts[HAL_AXIS_X] < 800u);
+
+    drain_motion(&bridge);
+    assert(mock_pulse_counts[HAL_AXIS_X] == 800u);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 800);
+
+    st = serial_gcode_bridge_process_line(&bridge, "?", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(strcmp(response, "X:10000 Y:0 (x0.001mm)|Ov:100,100,100") == 0);
+}
+
+static void test_lines_queue_back_to_back(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    static const char *const lines[] = {"G1 X5 F1200", "G1 X10", "G1 X10 Y5", "G1 X0 Y0"};
+    char response[64];
+    for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i) {
+        gcode_status_t st = serial_gcode_bridge_process_line(&bridge, lines[i], response, sizeof(response));
+        assert(st == GCODE_OK);
+        assert(strcmp(response, "OK") == 0);
+    }
+
+    /* Nothing has executed yet: every move is waiting in the queue */
+    assert(mock_pulse_mask_calls == 0u);
+    assert(bridge.planner.size >= 3u);
+
+    /* Collinear first pair is planned through the junction without stopping */
+    const planner_block_t *first = planner_peek_front(&bridge.planner);
+    assert(first != NULL);
+    assert(first->exit_speed > 0.0f);
+
+    drain_motion(&bridge);
+    assert(mock_pulse_counts[HAL_AXIS_X] == 1600u);
+    assert(mock_pulse_counts[HAL_AXIS_Y] == 800u);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 0);
+    assert(bridge.stepper.position.v[HAL_AXIS_Y] == 0);
+}
+
+static void test_full_queue_waits_for_room(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char line[32];
+    char response[64];
+    for (uint32_t i = 1u; i <= PLANNER_BUFFER_SIZE + 4u; ++i) {
+        snprintf(line, sizeof(line), "G1 X%lu F3000", (unsigned long)i);
+        gcode_status_t st = serial_gcode_bridge_process_line(&bridge, line, response, sizeof(response));
+        assert(st == GCODE_OK);
+        assert(bridge.planner.size <= bridge.planner.capacity);
+    }
+
+    /* The overflow lines ran earlier motion while they waited */
+    assert(mock_pulse_counts[HAL_AXIS_X] > 0u);
+
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == (int32_t)((PLANNER_BUFFER_SIZE + 4u) * 80u));
+}
+
+static void test_background_motion_aborts_on_estop(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    for (size_t i = 0; i < 2000u; ++i) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+
+    mock_inputs.estop = true;
+    assert(!serial_gcode_bridge_poll(&bridge));
+    assert(serial_gcode_bridge_is_idle(&bridge));
+    assert(!mock_motor_enabled);
+
+    /* Parser position follows the steps that were actually taken */
+    const int32_t taken = bridge.stepper.position.v[HAL_AXIS_X];
+    assert(taken > 0 && taken < 800);
+    assert(fabsf(bridge.gcode.position_x - (float)taken / 80.0f) < FLOAT_EPSILON);
+    const uint32_t pulses = mock_pulse_counts[HAL_AXIS_X];
+    hal_poll();
+    assert(mock_pulse_counts[HAL_AXIS_X] == pulses);
+}
+
+static void test_realtime_status_reports_during_motion(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+    serial_gcode_bridge_set_report(&bridge, mock_report, NULL);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    for (size_t i = 0; i < 2000u; ++i) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+
+    /* Reported by the next poll, mid-move, with the steps taken so far */
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_STATUS_QUERY);
+    assert(mock_report_calls == 0u);
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(mock_report_calls == 1u);
+    assert(!serial_gcode_bridge_is_idle(&bridge));
+    char expected[64];
+    const int32_t taken = bridge.stepper.position.v[HAL_AXIS_X];
+    assert(taken > 0 && taken < 800);
+    snprintf(expected, sizeof(expected), "X:%ld Y:0 (x0.001mm)|Ov:100,100,100",
+             (long)lroundf((float)taken * 12.5f));
+    assert(strcmp(mock_report_text, expected) == 0);
+
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(mock_report_calls == 1u);
+    drain_motion(&bridge);
+}
+
+static void test_realtime_feed_hold_ramps_down(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    for (size_t i = 0; i < 2000u; ++i) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+
+    /* The next poll starts the ramp down; steps continue until at rest */
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_FEED_HOLD);
+    const uint32_t hold_pulses = mock_pulse_counts[HAL_AXIS_X];
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(bridge.feed_hold);
+    assert(stepper_get_state(&bridge.stepper) == STEPPER_HOLDING);
+    for (size_t i = 0; i < TEST_DRAIN_ITERATIONS_LIMIT &&
+                       stepper_get_state(&bridge.stepper) != STEPPER_HOLD; ++i) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+    assert(stepper_get_state(&bridge.stepper) == STEPPER_HOLD);
+    const uint32_t pulses = mock_pulse_counts[HAL_AXIS_X];
+    assert(pulses > hold_pulses && pulses < 800u);
+    for (size_t i = 0; i < 100u; ++i) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+    assert(mock_pulse_counts[HAL_AXIS_X] == pulses);
+
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_CYCLE_START);
+    drain_motion(&bridge);
+    assert(!bridge.feed_hold);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 800);
+}
+
+static void test_realtime_reset_aborts_waiting_line(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+    serial_gcode_bridge_set_report(&bridge, mock_report, NULL);
+
+    char line[32];
+    char response[64];
+    for (uint32_t i = 1u; i <= PLANNER_BUFFER_SIZE; ++i) {
+        snprintf(line, sizeof(line), "G1 X%lu F600", (unsigned long)i);
+        gcode_status_t st = serial_gcode_bridge_process_line(&bridge, line, response, sizeof(response));
+        assert(st == GCODE_OK);
+    }
+
+    /* Ctrl-X arrives while the next line waits for planner room */
+    mock_rt_bridge = &bridge;
+    mock_rt_cmd = PROTO_RT_RESET;
+    mock_rt_after_polls = 50u;
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 X100", response, sizeof(response));
+    assert(st == GCODE_ERR_MOTION_ABORTED);
+    assert(strcmp(response, "error: reset") == 0);
+    assert(strcmp(mock_report_text, "Grbl reset") == 0);
+    assert(serial_gcode_bridge_is_idle(&bridge));
+    assert(bridge.alarm_lock);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 0);
+
+    const uint32_t pulses = mock_pulse_counts[HAL_AXIS_X];
+    for (size_t i = 0; i < 100u; ++i) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+    assert(mock_pulse_counts[HAL_AXIS_X] == pulses);
+
+    /* The next line starts from a clean state */
+    st = serial_gcode_bridge_process_line(&bridge, "G1 X1 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 80);
+}
+
+static void test_realtime_overrides_apply_and_reset(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    for (size_t i = 0; i < 2000u; ++i) {
+        assert(serial_gcode_bridge_poll(&bridge));
+        hal_poll();
+    }
+
+    /* Applied by the next poll; repeats between polls count once */
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_FEED_OVR_COARSE_MINUS);
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_FEED_OVR_COARSE_MINUS);
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_RAPID_OVR_MEDIUM);
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_SPINDLE_OVR_FINE_PLUS);
+    assert(bridge.stepper.feed_override == 100u);
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(bridge.overrides.feed == 90u);
+    assert(bridge.overrides.rapid == 50u);
+    assert(bridge.overrides.spindle == 101u);
+    assert(bridge.stepper.feed_override == 90u);
+    assert(bridge.stepper.rapid_override == 50u);
+    assert(stepper_get_state(&bridge.stepper) == STEPPER_RUNNING);
+
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 800);
+
+    /* Soft reset restores 100% */
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_RESET);
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(bridge.overrides.feed == 100u);
+    assert(bridge.overrides.rapid == 100u);
+    assert(bridge.overrides.spindle == 100u);
+    assert(bridge.stepper.feed_override == 100u);
+    assert(bridge.stepper.rapid_override == 100u);
+}
+
+/* The status report shows the live overrides: 0x91 received as a
+ * realtime byte raises the reported feed */
+static void test_status_reports_live_overrides(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+    serial_gcode_bridge_set_report(&bridge, mock_report, NULL);
+
+    char response[64];
+    assert(serial_gcode_bridge_process_line(&bridge, "?", response, sizeof(response)) == GCODE_OK);
+    assert(strstr(response, "|Ov:100,100,100") != NULL);
+
+    serial_gcode_bridge_realtime(&bridge, protocol_rt_classify(0x91u));
+    serial_gcode_bridge_realtime(&bridge, PROTO_RT_STATUS_QUERY);
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(strcmp(mock_report_text, "X:0 Y:0 (x0.001mm)|Ov:110,100,100") == 0);
+
+    assert(serial_gcode_bridge_process_line(&bridge, "?", response, sizeof(response)) == GCODE_OK);
+    assert(strcmp(response, "X:0 Y:0 (x0.001mm)|Ov:110,100,100") == 0);
+}
+
+/* Words the parser cannot act on are reported, the rest of the line runs */
+static void test_ignored_words_are_reported(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+    serial_gcode_bridge_set_report(&bridge, mock_report, NULL);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 Z-1 X1 T2 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(strcmp(response, "OK") == 0);
+    assert(mock_report_calls == 1u);
+    assert(strcmp(mock_report_text, "[MSG:Ignored T Z]") == 0);
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 80);
+
+    /* Line numbers are accepted quietly */
+    st = serial_gcode_bridge_process_line(&bridge, "N20 G1 X0", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(mock_report_calls == 1u);
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 0);
+}
+
+static void test_spindle_switches_after_queued_motion(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(!serial_gcode_bridge_is_idle(&bridge));
+
+    /* M3 waits for the move, then switches at S/$30 */
+    st = serial_gcode_bridge_process_line(&bridge, "M3 S5000", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(serial_gcode_bridge_is_idle(&bridge));
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 800);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW);
+    assert(fabsf(mock_spindle_pwm - 0.5f) < FLOAT_EPSILON);
+
+    /* The spindle keeps running through motion */
+    const uint32_t calls = mock_spindle_calls;
+    st = serial_gcode_bridge_process_line(&bridge, "G1 X0", response, sizeof(response));
+    assert(st == GCODE_OK);
+    drain_motion(&bridge);
+    assert(mock_spindle_calls == calls);
+
+    st = serial_gcode_bridge_process_line(&bridge, "M5", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF);
+    assert(mock_spindle_pwm == 0.0f);
+}
+
+static void test_laser_mode_scales_power_with_motion(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "$32=1", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(bridge.settings.laser_mode);
+    assert(bridge.stepper.config.laser_mode);
+
+    /* M3/M4 queue with the motion instead of waiting for it */
+    st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600 M3 S5000", response, sizeof(response));
+    assert(st == GCODE_OK);
+    st = serial_gcode_bridge_process_line(&bridge, "M4 S2000", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(!serial_gcode_bridge_is_idle(&bridge));
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 800);
+    assert(fabsf(mock_spindle_max_pwm - 0.5f) < FLOAT_EPSILON);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF);
+    assert(mock_spindle_pwm == 0.0f);
+
+    /* Rapids move with the laser off */
+    mock_spindle_max_pwm = 0.0f;
+    st = serial_gcode_bridge_process_line(&bridge, "G0 X0", response, sizeof(response));
+    assert(st == GCODE_OK);
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 0);
+    assert(mock_spindle_max_pwm == 0.0f);
+
+    /* M4 S2000 is active: the next feed move fires at 20% */
+    st = serial_gcode_bridge_process_line(&bridge, "G1 X5", response, sizeof(response));
+    assert(st == GCODE_OK);
+    drain_motion(&bridge);
+    assert(fabsf(mock_spindle_max_pwm - 0.2f) < FLOAT_EPSILON);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF);
+}
+
+/* 0x9A/0x9B change the spindle output, not just the Ov: report */
+static void test_spindle_override_scales_output(void) {
+    reset_mocks();
+    serial_gcode_bridge_t bridge;
+    serial_gcode_bridge_init(&bridge);
+
+    char response[64];
+    gcode_status_t st = serial_gcode_bridge_process_line(&bridge, "M3 S5000", response, sizeof(response));
+    assert(st == GCODE_OK);
+    assert(fabsf(mock_spindle_pwm - 0.5f) < FLOAT_EPSILON);
+
+    /* The running spindle follows the override on the next poll */
+    serial_gcode_bridge_realtime(&bridge, protocol_rt_classify(0x9Au));
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(bridge.overrides.spindle == 110u);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW);
+    assert(fabsf(mock_spindle_pwm - 0.55f) < FLOAT_EPSILON);
+
+    /* Feed overrides leave the spindle alone */
+    const uint32_t calls = mock_spindle_calls;
+    serial_gcode_bridge_realtime(&bridge, protocol_rt_classify(0x91u));
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(mock_spindle_calls == calls);
+
+    st = serial_gcode_bridge_process_line(&bridge, "M5", response, sizeof(response));
+    assert(st == GCODE_OK);
+
+    /* Laser mode: per-segment power follows the override too */
+    st = serial_gcode_bridge_process_line(&bridge, "$32=1", response, sizeof(response));
+    assert(st == GCODE_OK);
+    serial_gcode_bridge_realtime(&bridge, protocol_rt_classify(0x99u));
+    assert(serial_gcode_bridge_poll(&bridge));
+    serial_gcode_bridge_realtime(&bridge, protocol_rt_classify(0x9Bu));
+    assert(serial_gcode_bridge_poll(&bridge));
+    assert(bridge.stepper.spindle_override == 90u);
+    mock_spindle_max_pwm = 0.0f;
+    st = serial_gcode_bridge_process_line(&bridge, "G1 X10 F600 M3 S5000", response, sizeof(response));
+    assert(st == GCODE_OK);
+    drain_motion(&bridge);
+    assert(bridge.stepper.position.v[HAL_AXIS_X] == 800);
+    assert(fabsf(mock_spindle_max_pwm - 0.45f) < FLOAT_EPSILON);
+}
+
 int main(void) {
     printf("Running serial gcode bridge tests...\n");
     test_g0_motion_emits_ok_and_steps();
     test_enable_disable_commands();
     test_identity_query_returns_firmware_info();
+    test_profile_report_needs_profiling_build();
+    test_isr_latency_report_needs_latency_build();
     test_invalid_line_returns_error();
-    test_settings_dump_contains_required_entries_without_laser();
+    test_settings_dump_contains_required_entries();
     test_setting_assignment_updates_internal_values();
-    test_setting_assignment_rejects_laser_and_invalid_values();
+    test_setting_assignment_rejects_invalid_values();
     test_coordinate_offsets_and_modal_state_queries();
     test_startup_lines_show_and_set();
     test_check_mode_hold_and_resume_commands();
@@ -503,6 +1014,19 @@ int main(void) {
     test_motion_aborts_on_estop_input();
     test_motion_aborts_on_limit_input();
     test_custom_motion_backend_is_used();
+    test_motion_replies_ok_before_move_finishes();
+    test_lines_queue_back_to_back();
+    test_full_queue_waits_for_room();
+    test_background_motion_aborts_on_estop();
+    test_realtime_status_reports_during_motion();
+    test_realtime_feed_hold_ramps_down();
+    test_realtime_reset_aborts_waiting_line();
+    test_realtime_overrides_apply_and_reset();
+    test_status_reports_live_overrides();
+    test_ignored_words_are_reported();
+    test_spindle_switches_after_queued_motion();
+    test_laser_mode_scales_power_with_motion();
+    test_spindle_override_scales_output();
     printf("All serial gcode bridge tests passed!\n");
     return 0;
 }
@@ -1,9 +1,160 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "../src/serial_uart.h"
 
+#define SPSC_STRESS_BYTES 2000000u
+
+/* Producer thread stands in for the UART ISR: pushes a counting byte
+ * pattern in odd-sized chunks whenever there is room */
+static void *spsc_producer(void *arg) {
+    serial_uart_t *uart = (serial_uart_t *)arg;
+    uint8_t chunk[37];
+    uint32_t sent = 0u;
+    while (sent < SPSC_STRESS_BYTES) {
+        size_t len = sizeof(chunk);
+        if (len > SPSC_STRESS_BYTES - sent) len = SPSC_STRESS_BYTES - sent;
+        for (size_t i = 0; i < len; i++) chunk[i] = (uint8_t)(sent + i);
+        size_t pushed = 0u;
+        while (pushed < len) {
+            pushed += serial_uart_rx_push(uart, chunk + pushed, len - pushed);
+        }
+        sent += (uint32_t)len;
+    }
+    return NULL;
+}
+
+static void test_spsc_concurrent_stream(void) {
+    static serial_uart_t uart;
+    serial_uart_init(&uart);
+
+    pthread_t producer;
+    assert(pthread_create(&producer, NULL, spsc_producer, &uart) == 0);
+
+    /* Consumer (main loop) sees every byte exactly once, in order */
+    uint8_t buf[53];
+    uint32_t received = 0u;
+    while (received < SPSC_STRESS_BYTES) {
+        size_t n = serial_uart_rx_pop(&uart, buf, sizeof(buf));
+        for (size_t i = 0; i < n; i++) {
+            assert(buf[i] == (uint8_t)(received + i));
+        }
+        received += (uint32_t)n;
+    }
+
+    assert(pthread_join(producer, NULL) == 0);
+    assert(serial_uart_rx_count(&uart) == 0u);
+}
+
+/* Byte-at-a-time line assembler with the original framing rules, used as
+ * the reference for the memchr framing path */
+typedef struct {
+    char line[UART_LINE_MAX + 1];
+    size_t len;
+    bool overflow;
+} ref_assembler_t;
+
+static uart_line_status_t ref_feed(ref_assembler_t *ref, uint8_t byte) {
+    if (byte == '\r') return UART_LINE_NONE;
+    if (byte == '\n') {
+        if (ref->len == 0u && !ref->overflow) return UART_LINE_NONE;
+        uart_line_status_t st = ref->overflow ? UART_LINE_OVERFLOW : UART_LINE_READY;
+        ref->line[ref->len] = '\0';
+        ref->len = 0u;
+        ref->overflow = false;
+        return st;
+    }
+    if (byte == 0x08u || byte == 0x7Fu) {
+        if (ref->len > 0u) ref->len--;
+        return UART_LINE_NONE;
+    }
+    if (byte < 0x20u || byte > 0x7Eu) return UART_LINE_NONE;
+    if (ref->len < UART_LINE_MAX) {
+        ref->line[ref->len++] = (char)byte;
+    } else {
+        ref->overflow = true;
+    }
+    return UART_LINE_NONE;
+}
+
+static void test_framing_matches_byte_reference(void) {
+    static const uint8_t alphabet[] = {
+        'G', '1', 'X', '.', ' ', '\r', '\n', '\n', 0x08u, 0x7Fu, 0x01u, 0xC3u, '~'
+    };
+    serial_uart_t uart;
+    ref_assembler_t ref;
+    serial_uart_init(&uart);
+    memset(&ref, 0, sizeof(ref));
+
+    uint32_t seed = 12345u;
+    size_t lines = 0u;
+    size_t overflows = 0u;
+    for (int round = 0; round < 4000; round++) {
+        /* Random chunk; long runs without newline force overflows */
+        uint8_t chunk[200];
+        seed = seed * 1103515245u + 12345u;
+        size_t len = 1u + (seed >> 16) % sizeof(chunk);
+        bool long_line = ((seed >> 8) & 7u) == 0u;
+        for (size_t i = 0; i < len; i++) {
+            seed = seed * 1103515245u + 12345u;
+            uint8_t byte = alphabet[(seed >> 16) % sizeof(alphabet)];
+            if (long_line && byte == '\n') byte = 'Y';
+            chunk[i] = byte;
+        }
+
+        assert(serial_uart_rx_push(&uart, chunk, len) == len);
+
+        char line[UART_LINE_MAX + 1];
+        for (size_t i = 0; i < len; i++) {
+            uart_line_status_t expect = ref_feed(&ref, chunk[i]);
+            if (expect == UART_LINE_NONE) continue;
+            assert(serial_uart_read_line(&uart, line, sizeof(line)) == expect);
+            assert(strcmp(line, ref.line) == 0);
+            if (expect == UART_LINE_OVERFLOW) overflows++;
+            lines++;
+        }
+        assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_NONE);
+    }
+    assert(lines > 1000u);
+    assert(overflows > 10u);
+}
+
+static void test_bulk_wrap_and_full(void) {
+    serial_uart_t uart;
+    serial_uart_init(&uart);
+
+    uint8_t data[UART_RX_BUFFER_SIZE + 16u];
+    uint8_t out[UART_RX_BUFFER_SIZE + 16u];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)(i * 7u);
+
+    /* Move the indices near the end so the next bulk copy wraps */
+    assert(serial_uart_rx_push(&uart, data, UART_RX_BUFFER_SIZE - 5u) == UART_RX_BUFFER_SIZE - 5u);
+    assert(serial_uart_rx_pop(&uart, out, UART_RX_BUFFER_SIZE - 5u) == UART_RX_BUFFER_SIZE - 5u);
+    assert(serial_uart_rx_count(&uart) == 0u);
+
+    /* Full ring: only the free space is accepted, the rest is refused */
+    assert(serial_uart_rx_push(&uart, data, sizeof(data)) == UART_RX_BUFFER_SIZE);
+    assert(serial_uart_rx_count(&uart) == UART_RX_BUFFER_SIZE);
+    assert(!serial_uart_rx_push_byte(&uart, 0x55u));
+
+    memset(out, 0, sizeof(out));
+    assert(serial_uart_rx_pop(&uart, out, sizeof(out)) == UART_RX_BUFFER_SIZE);
+    assert(memcmp(out, data, UART_RX_BUFFER_SIZE) == 0);
+    assert(serial_uart_rx_pop(&uart, out, sizeof(out)) == 0u);
+
+    /* TX ring behaves the same way */
+    assert(serial_uart_tx_enqueue(&uart, data, 10u) == 10u);
+    assert(serial_uart_tx_count(&uart) == 10u);
+    assert(serial_uart_tx_pop(&uart, out, 4u) == 4u);
+    assert(memcmp(out, data, 4u) == 0);
+    assert(serial_uart_tx_count(&uart) == 6u);
+}
+
 int main(void) {
     printf("Running serial UART transport tests...\n");
 
@@ -30,6 +181,10 @@ int main(void) {
     assert(serial_uart_tx_pop_byte(&uart, &out) && out == '\n');
     assert(!serial_uart_tx_pop_byte(&uart, &out));
 
+    test_bulk_wrap_and_full();
+    test_framing_matches_byte_reference();
+    test_spsc_concurrent_stream();
+
     printf("All serial UART tests passed!\n");
     return 0;
 }
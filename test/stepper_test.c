@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include "../src/stepper.h"
@@ -47,8 +48,73 @@ void hal_stepper_step_clear(hal_axis_t axis) {
     }
 }
 
+static uint32_t mock_pulse_width = 0;
+
+void hal_stepper_set_pulse_width(uint32_t ticks) {
+    mock_pulse_width = ticks;
+}
+
+static uint32_t mock_pulse_mask_calls = 0;
+static uint32_t mock_pulse_mask_bits[HAL_AXIS_MAX];
+
 void hal_stepper_pulse_mask(uint32_t axis_mask) {
-    (void)axis_mask;
+    mock_pulse_mask_calls++;
+    for (int i = 0; i < HAL_AXIS_MAX; i++) {
+        if (axis_mask & (1u << i)) {
+            mock_pulse_mask_bits[i]++;
+            mock_step_pulse_state[i] = true;
+        }
+    }
+}
+
+/* Mock spindle: logs every change with the X steps taken so far */
+#define MOCK_SPINDLE_LOG_SIZE 256u
+static uint32_t mock_spindle_calls = 0;
+static hal_spindle_dir_t mock_spindle_dir[MOCK_SPINDLE_LOG_SIZE];
+static float mock_spindle_pwm[MOCK_SPINDLE_LOG_SIZE];
+static uint32_t mock_spindle_at_step[MOCK_SPINDLE_LOG_SIZE];
+
+void hal_spindle_set(hal_spindle_dir_t dir, float pwm_0_to_1) {
+    if (mock_spindle_calls < MOCK_SPINDLE_LOG_SIZE) {
+        mock_spindle_dir[mock_spindle_calls] = dir;
+        mock_spindle_pwm[mock_spindle_calls] = pwm_0_to_1;
+        mock_spindle_at_step[mock_spindle_calls] = mock_pulse_mask_bits[HAL_AXIS_X];
+    }
+    mock_spindle_calls++;
+}
+
+/* Mock step timer: tests fire the callback by hand */
+static hal_step_timer_cb_t mock_timer_cb = NULL;
+static void *mock_timer_user = NULL;
+static bool mock_timer_running = false;
+static uint32_t mock_timer_period = 0;
+
+void hal_step_timer_init(hal_step_timer_cb_t cb, void *user) {
+    mock_timer_cb = cb;
+    mock_timer_user = user;
+}
+
+void hal_step_timer_start(uint32_t period_ticks) {
+    mock_timer_running = true;
+    mock_timer_period = period_ticks;
+}
+
+void hal_step_timer_set_period(uint32_t period_ticks) {
+    mock_timer_period = period_ticks;
+}
+
+void hal_step_timer_stop(void) {
+    mock_timer_running = false;
+}
+
+/* Fire the step timer while it is armed; returns the number of ticks */
+static uint32_t run_timer(uint32_t max_ticks) {
+    uint32_t ticks = 0;
+    while (mock_timer_running && ticks < max_ticks) {
+        mock_timer_cb(mock_timer_user);
+        ticks++;
+    }
+    return ticks;
 }
 
 /* Mock kinematics */
@@ -67,6 +133,14 @@ void reset_mocks(void) {
     mock_time_ms = 0;
     memset(mock_dir_state, 0, sizeof(mock_dir_state));
     memset(mock_step_pulse_state, 0, sizeof(mock_step_pulse_state));
+    mock_pulse_mask_calls = 0;
+    mock_pulse_width = 0;
+    memset(mock_pulse_mask_bits, 0, sizeof(mock_pulse_mask_bits));
+    mock_timer_cb = NULL;
+    mock_timer_user = NULL;
+    mock_timer_running = false;
+    mock_timer_period = 0;
+    mock_spindle_calls = 0;
     
     /* Set up minimal kinematics */
     g_kin.cart_axes = 3;
@@ -259,8 +333,10 @@ void test_stepper_hold_resume(void) {
     stepper_load_block(&ctx, &block);
     assert(ctx.state == STEPPER_RUNNING);
     
-    /* Hold */
+    /* Hold: nothing has stepped yet, so the ramp is empty */
     stepper_hold(&ctx);
+    assert(ctx.state == STEPPER_HOLDING);
+    stepper_update(&ctx);
     assert(ctx.state == STEPPER_HOLD);
     
     /* Resume */
@@ -357,6 +433,786 @@ void test_stepper_config(void) {
     printf("[passed]\n");
 }
 
+/* Test that the step timer ISR executes a whole block from the segment buffer */
+void test_stepper_isr_executes_block(void) {
+    printf("Testing stepper ISR block execution...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    assert(mock_timer_cb != NULL);
+    assert(mock_timer_user == &ctx);
+    
+    /* 100 steps/mm at 600 mm/min = 1000 steps/s = 1000 ticks per step */
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 600.0f;
+    block.millimeters = 5.0f;
+    block.step_event_count = 500;
+    block.direction_bits = 0x01;
+    
+    assert(stepper_load_block(&ctx, &block));
+    assert(!mock_timer_running);
+    
+    /* Foreground prepares segments and arms the timer without waiting */
+    stepper_update(&ctx);
+    assert(mock_timer_running);
+    assert(mock_timer_period == (1000 >> STEPPER_AMASS_MAX_LEVEL));  /* AMASS level 3 */
+    assert(mock_time_us == 0);
+    
+    while (stepper_get_state(&ctx) == STEPPER_RUNNING) {
+        run_timer(64);
+        stepper_update(&ctx);
+    }
+    
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 500);
+    assert(mock_pulse_mask_calls == 500);
+    assert(ctx.position.v[HAL_AXIS_X] == 500);
+    assert(!mock_step_pulse_state[HAL_AXIS_X]);
+    assert(!mock_timer_running);
+    assert(ctx.current_block == NULL);
+    
+    printf("[passed]\n");
+}
+
+/* Test that segment periods track the step rate and respect the floor */
+void test_stepper_isr_fast_rate(void) {
+    printf("Testing stepper ISR high step rate...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    /* 800 steps/mm at 3000 mm/min = 40 kHz = 25 ticks per step */
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 3000.0f;
+    block.millimeters = 10.0f;
+    block.step_event_count = 8000;
+    block.direction_bits = 0x01;
+    
+    assert(stepper_load_block(&ctx, &block));
+    stepper_update(&ctx);
+    assert(ctx.segment_buffer[ctx.segment_tail].period_ticks == 25);
+    assert(mock_pulse_width == 10);  /* step_pulse_us, set when the timer is armed */
+    
+    while (stepper_get_state(&ctx) == STEPPER_RUNNING) {
+        run_timer(1000);
+        stepper_update(&ctx);
+    }
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 8000);
+    
+    printf("[passed]\n");
+}
+
+/* Test that hold parks the step timer and resume continues the block */
+void test_stepper_isr_hold_resume(void) {
+    printf("Testing stepper ISR hold and resume...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 600.0f;
+    block.millimeters = 2.0f;
+    block.step_event_count = 200;
+    block.direction_bits = 0x01;
+    
+    assert(stepper_load_block(&ctx, &block));
+    stepper_update(&ctx);
+    run_timer(50);
+    
+    stepper_hold(&ctx);
+    while (stepper_get_state(&ctx) == STEPPER_HOLDING) {
+        stepper_update(&ctx);
+        run_timer(64);
+    }
+    assert(stepper_get_state(&ctx) == STEPPER_HOLD);
+    assert(!mock_timer_running);
+    uint32_t held_steps = mock_pulse_mask_bits[HAL_AXIS_X];
+    assert(held_steps > 0 && held_steps < 200);
+    stepper_update(&ctx);
+    run_timer(10);
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == held_steps);
+    
+    stepper_resume(&ctx);
+    while (stepper_get_state(&ctx) == STEPPER_RUNNING) {
+        stepper_update(&ctx);
+        run_timer(64);
+    }
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 200);
+    
+    printf("[passed]\n");
+}
+
+/* Test that realtime requests park the ISR before the next update runs */
+void test_stepper_rt_request(void) {
+    printf("Testing stepper realtime requests...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 600.0f;
+    block.millimeters = 2.0f;
+    block.step_event_count = 200;
+    block.direction_bits = 0x01;
+    
+    assert(stepper_load_block(&ctx, &block));
+    stepper_update(&ctx);
+    run_timer(50);
+    
+    /* Posted as an interrupt would: the next update starts the ramp down */
+    stepper_rt_request(&ctx, STEPPER_RT_HOLD);
+    assert(stepper_get_state(&ctx) == STEPPER_RUNNING);
+    stepper_update(&ctx);
+    assert(stepper_get_state(&ctx) == STEPPER_HOLDING);
+    assert(ctx.rt_request == 0u);
+    
+    /* Resume cancels a hold that has not been taken yet */
+    stepper_rt_request(&ctx, STEPPER_RT_HOLD);
+    stepper_rt_request(&ctx, STEPPER_RT_RESUME);
+    assert(ctx.rt_request == STEPPER_RT_RESUME);
+    stepper_update(&ctx);
+    assert(stepper_get_state(&ctx) == STEPPER_RUNNING);
+    uint32_t resumed_steps = mock_pulse_mask_bits[HAL_AXIS_X];
+    run_timer(20);
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] > resumed_steps);
+    
+    /* Stop parks immediately and drops the rest of the block */
+    stepper_rt_request(&ctx, STEPPER_RT_STOP);
+    uint32_t stopped_steps = mock_pulse_mask_bits[HAL_AXIS_X];
+    run_timer(10);
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == stopped_steps);
+    stepper_update(&ctx);
+    stepper_update(&ctx);
+    assert(stepper_is_idle(&ctx));
+    assert(stopped_steps < 200);
+    
+    printf("[passed]\n");
+}
+
+/* Test that the DDA distributes exact per-axis step counts in combined masks */
+void test_stepper_dda_multi_axis(void) {
+    printf("Testing stepper multi-axis DDA...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    ctx.config.amass_enabled = false;  /* One DDA tick per step event */
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 600.0f;
+    block.millimeters = 3.0f;
+    block.steps[HAL_AXIS_X] = 300;
+    block.steps[HAL_AXIS_Y] = 100;
+    block.steps[HAL_AXIS_Z] = 7;
+    block.steps[HAL_AXIS_A] = 299;
+    block.step_event_count = 300;
+    block.direction_bits = (1u << HAL_AXIS_X) | (1u << HAL_AXIS_Z);  /* Y and A negative */
+    
+    assert(stepper_load_block(&ctx, &block));
+    
+    /* Step events are counted by pulse_mask calls (X steps on every event) */
+    uint32_t last_y_tick = 0;
+    uint32_t y_gap_min = 0xFFFFFFFFu;
+    uint32_t y_gap_max = 0;
+    uint32_t y_seen = 0;
+    while (stepper_get_state(&ctx) == STEPPER_RUNNING) {
+        stepper_update(&ctx);
+        while (mock_timer_running) {
+            uint32_t y_before = mock_pulse_mask_bits[HAL_AXIS_Y];
+            mock_timer_cb(mock_timer_user);
+            uint32_t tick = mock_pulse_mask_calls;
+            if (mock_pulse_mask_bits[HAL_AXIS_Y] != y_before) {
+                if (y_seen++ > 0) {
+                    uint32_t gap = tick - last_y_tick;
+                    if (gap < y_gap_min) y_gap_min = gap;
+                    if (gap > y_gap_max) y_gap_max = gap;
+                }
+                last_y_tick = tick;
+            }
+        }
+    }
+    
+    /* Directions are set by the ISR before the first step */
+    assert(mock_dir_state[HAL_AXIS_X]);
+    assert(!mock_dir_state[HAL_AXIS_Y]);
+    
+    /* Exact counts, one combined mask per tick */
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 300);
+    assert(mock_pulse_mask_bits[HAL_AXIS_Y] == 100);
+    assert(mock_pulse_mask_bits[HAL_AXIS_Z] == 7);
+    assert(mock_pulse_mask_bits[HAL_AXIS_A] == 299);
+    assert(mock_pulse_mask_calls == 300);
+    
+    /* Minor axis steps evenly: every third tick */
+    assert(y_gap_min == 3 && y_gap_max == 3);
+    
+    assert(ctx.position.v[HAL_AXIS_X] == 300);
+    assert(ctx.position.v[HAL_AXIS_Y] == -100);
+    assert(ctx.position.v[HAL_AXIS_Z] == 7);
+    assert(ctx.position.v[HAL_AXIS_A] == -299);
+    
+    printf("[passed]\n");
+}
+
+/* Run a two-axis block and return the spread (max - min) of the time between
+ * minor-axis steps in step timer ticks */
+static uint32_t minor_axis_jitter(bool amass) {
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    ctx.config.amass_enabled = amass;
+    
+    /* 100 steps/s on X (level 3), Y at 33/100 of that */
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 60.0f;
+    block.millimeters = 1.0f;
+    block.steps[HAL_AXIS_X] = 100;
+    block.steps[HAL_AXIS_Y] = 33;
+    block.direction_bits = 0x03;
+    assert(stepper_load_block(&ctx, &block));
+    
+    uint32_t now = 0, last_y = 0, y_seen = 0;
+    uint32_t gap_min = 0xFFFFFFFFu, gap_max = 0;
+    while (stepper_get_state(&ctx) == STEPPER_RUNNING) {
+        stepper_update(&ctx);
+        while (mock_timer_running) {
+            uint32_t y_before = mock_pulse_mask_bits[HAL_AXIS_Y];
+            mock_timer_cb(mock_timer_user);
+            if (!mock_timer_running) {
+                break;  /* Underrun/end tick: no step time elapsed in this test */
+            }
+            now += mock_timer_period;
+            if (mock_pulse_mask_bits[HAL_AXIS_Y] != y_before) {
+                if (y_seen++ > 0) {
+                    uint32_t gap = now - last_y;
+                    if (gap < gap_min) gap_min = gap;
+                    if (gap > gap_max) gap_max = gap;
+                }
+                last_y = now;
+            }
+        }
+    }
+    
+    /* Step counts stay exact at every oversampling level */
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 100);
+    assert(mock_pulse_mask_bits[HAL_AXIS_Y] == 33);
+    assert(ctx.position.v[HAL_AXIS_X] == 100);
+    assert(ctx.position.v[HAL_AXIS_Y] == 33);
+    
+    return gap_max - gap_min;
+}
+
+/* Test that AMASS evens out minor-axis pulse spacing at low step rates */
+void test_stepper_amass_smoothing(void) {
+    printf("Testing stepper AMASS smoothing...\n");
+    
+    /* Without AMASS minor-axis gaps alternate between 3 and 4 major steps */
+    assert(minor_axis_jitter(false) == 10000);
+    
+    /* With AMASS the spread shrinks to one oversampled tick */
+    assert(minor_axis_jitter(true) == 10000 >> STEPPER_AMASS_MAX_LEVEL);
+    
+    printf("[passed]\n");
+}
+
+/* Test AMASS level selection against the step rate thresholds */
+void test_stepper_amass_levels(void) {
+    printf("Testing stepper AMASS levels...\n");
+    
+    /* Step rate (steps/s) -> expected level */
+    const struct { float rate; uint8_t level; } cases[] = {
+        { 40000.0f, 0 }, { 6000.0f, 1 }, { 3000.0f, 2 }, { 500.0f, 3 },
+    };
+    
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        reset_mocks();
+        stepper_context_t ctx;
+        stepper_init(&ctx, NULL);
+        
+        planner_block_t block;
+        planner_block_init(&block);
+        block.nominal_speed = cases[i].rate * 60.0f / 100.0f;  /* 100 steps/mm */
+        block.millimeters = 10.0f;
+        block.steps[HAL_AXIS_X] = 1000;
+        assert(stepper_load_block(&ctx, &block));
+        stepper_update(&ctx);
+        
+        const stepper_segment_t *seg = &ctx.segment_buffer[ctx.segment_tail];
+        assert(seg->amass_level == cases[i].level);
+        uint32_t period = (uint32_t)(HAL_STEP_TIMER_HZ / cases[i].rate);
+        assert(seg->period_ticks == (period >> cases[i].level));
+    }
+    
+    printf("[passed]\n");
+}
+
+/* Run while the stepper stays in state, or until *x_count reaches stop_at.
+ * *x_count and *now carry on across calls. */
+static void record_while(stepper_context_t *ctx, stepper_state_t state, uint32_t *x_times,
+                         uint32_t max_steps, uint32_t stop_at, uint32_t *x_count, uint32_t *now) {
+    while (stepper_get_state(ctx) == state && *x_count < stop_at) {
+        stepper_update(ctx);
+        while (mock_timer_running) {
+            uint32_t x_before = mock_pulse_mask_bits[HAL_AXIS_X];
+            mock_timer_cb(mock_timer_user);
+            if (mock_pulse_mask_bits[HAL_AXIS_X] != x_before && *x_count < max_steps) {
+                x_times[(*x_count)++] = *now;
+            }
+            if (!mock_timer_running) {
+                break;  /* Underrun/end tick: refill in the foreground */
+            }
+            *now += mock_timer_period;
+        }
+    }
+}
+
+/* Run the stepper to completion, recording the time (in step timer ticks)
+ * of every X step. Returns the total motion time. */
+static uint32_t run_recording(stepper_context_t *ctx, uint32_t *x_times, uint32_t max_steps) {
+    uint32_t now = 0;
+    uint32_t x_count = 0;
+    record_while(ctx, STEPPER_RUNNING, x_times, max_steps, 0xFFFFFFFFu, &x_count, &now);
+    return now;
+}
+
+/* Largest interval between consecutive recorded steps in [from, to) */
+static uint32_t max_step_interval(const uint32_t *times, uint32_t from, uint32_t to) {
+    uint32_t max_gap = 0;
+    for (uint32_t i = from + 1; i < to; i++) {
+        uint32_t gap = times[i] - times[i - 1];
+        if (gap > max_gap) max_gap = gap;
+    }
+    return max_gap;
+}
+
+static uint32_t min_step_interval(const uint32_t *times, uint32_t from, uint32_t to) {
+    uint32_t min_gap = 0xFFFFFFFFu;
+    for (uint32_t i = from + 1; i < to; i++) {
+        uint32_t gap = times[i] - times[i - 1];
+        if (gap < min_gap) min_gap = gap;
+    }
+    return min_gap;
+}
+
+/* Peak acceleration (steps/s^2) from recorded step times: mean speeds over
+ * windows of w steps, differenced between windows 2w apart so the 10 ms
+ * segment quantisation averages out */
+static float peak_step_accel(const uint32_t *times, uint32_t count, uint32_t w) {
+    float peak = 0.0f;
+    for (uint32_t i = 0; i + 3 * w < count; i++) {
+        float v1 = (float)w * HAL_STEP_TIMER_HZ / (float)(times[i + w] - times[i]);
+        float v2 = (float)w * HAL_STEP_TIMER_HZ / (float)(times[i + 3 * w] - times[i + 2 * w]);
+        float dt = 0.5f * (float)((times[i + 3 * w] + times[i + 2 * w]) - (times[i + w] + times[i])) /
+                   HAL_STEP_TIMER_HZ;
+        float accel = fabsf(v2 - v1) / dt;
+        if (accel > peak) peak = accel;
+    }
+    return peak;
+}
+
+static uint32_t profile_x_times[4000];
+
+/* 10 mm at 1200 mm/min with 200 mm/s^2 from rest to rest:
+ * 0.1 s ramp up (1 mm), 0.4 s cruise, 0.1 s ramp down = 0.6 s */
+static void load_profile_block(stepper_context_t *ctx, planner_block_t *block) {
+    planner_block_init(block);
+    block->nominal_speed = 1200.0f;
+    block->acceleration = 200.0f * 3600.0f;
+    block->millimeters = 10.0f;
+    block->steps[HAL_AXIS_X] = 1000;
+    block->direction_bits = 0x01;
+    assert(stepper_load_block(ctx, block));
+}
+
+/* Test that segment prep follows a trapezoidal velocity profile */
+void test_stepper_trapezoid_profile(void) {
+    printf("Testing stepper trapezoid profile...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    load_profile_block(&ctx, &block);
+    uint32_t total = run_recording(&ctx, profile_x_times, 1000);
+    
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 1000);
+    assert(ctx.position.v[HAL_AXIS_X] == 1000);
+    
+    /* Total time matches the profile within 2% */
+    assert(total > 588000 && total < 612000);
+    
+    /* Cruise at 2000 steps/s = 500 ticks per step */
+    uint32_t cruise_min = min_step_interval(profile_x_times, 150, 850);
+    uint32_t cruise_max = max_step_interval(profile_x_times, 150, 850);
+    assert(cruise_min >= 490 && cruise_max <= 510);
+    
+    /* Ramps are slower than cruise at both ends */
+    assert(profile_x_times[1] - profile_x_times[0] > 2 * cruise_max);
+    assert(profile_x_times[999] - profile_x_times[998] > 2 * cruise_max);
+    
+    /* Accelerating: step intervals shrink through the ramp */
+    assert(profile_x_times[20] - profile_x_times[19] > profile_x_times[80] - profile_x_times[79]);
+    
+    printf("[passed]\n");
+}
+
+/* Test that the S-curve stretches its ramps so the peak acceleration
+ * measured from the steps stays at the limit */
+void test_stepper_scurve_profile(void) {
+    printf("Testing stepper S-curve profile...\n");
+    
+    static uint32_t trap_times[1000];
+    reset_mocks();
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    planner_block_t block;
+    load_profile_block(&ctx, &block);
+    run_recording(&ctx, trap_times, 1000);
+    float trap_peak = peak_step_accel(trap_times, 1000, 20);
+    
+    reset_mocks();
+    stepper_init(&ctx, NULL);
+    ctx.config.profile = STEPPER_PROFILE_SCURVE;
+    load_profile_block(&ctx, &block);
+    uint32_t total = run_recording(&ctx, profile_x_times, 1000);
+    float scurve_peak = peak_step_accel(profile_x_times, 1000, 20);
+    
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 1000);
+    
+    /* 0.15 s ramps over 1.5 mm each, 7 mm cruise: 0.65 s */
+    assert(total > 637000 && total < 663000);
+    assert(profile_x_times[150] > trap_times[150] + 20000);  /* 0.125 s on the trapezoid */
+    
+    /* 200 mm/s^2 at 100 steps/mm: both profiles peak at the limit */
+    assert(trap_peak > 18000.0f && trap_peak < 22000.0f);
+    assert(scurve_peak > 18000.0f && scurve_peak < 22000.0f);
+    
+    /* Gentler start: the first steps come later than on the trapezoid */
+    assert(profile_x_times[10] > trap_times[10]);
+    
+    /* 2000 mm/s^3 jerk: ramps of sqrt(6 * 20 / 2000) = 0.245 s, 2.45 mm each */
+    reset_mocks();
+    stepper_init(&ctx, NULL);
+    ctx.config.profile = STEPPER_PROFILE_SCURVE;
+    ctx.config.jerk_mm_per_s3 = 2000.0f;
+    load_profile_block(&ctx, &block);
+    total = run_recording(&ctx, profile_x_times, 1000);
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 1000);
+    assert(total > 730000 && total < 760000);
+    /* Peak 1.5 dv / T with dv = 2000 steps/s */
+    assert(peak_step_accel(profile_x_times, 1000, 20) < 1.1f * 1.5f * 2000.0f / 0.245f);
+    
+    printf("[passed]\n");
+}
+
+/* Test planner-fed execution: collinear blocks run through their junction
+ * without slowing, including when the second block arrives mid-prep */
+void test_stepper_planner_continuous(void) {
+    printf("Testing stepper planner-fed continuous motion...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 0);
+    stepper_set_planner(&ctx, &queue);
+    
+    float delta[KIN_MAX_CART_AXES] = {10.0f, 0.0f, 0.0f};
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 1200.0f;
+    block.steps[HAL_AXIS_X] = 1000;
+    block.direction_bits = 0x01;
+    assert(planner_plan_block(&queue, &block, delta));
+    
+    /* Stepper starts on its own and prepares the first block to a stop */
+    stepper_update(&ctx);
+    assert(stepper_get_state(&ctx) == STEPPER_RUNNING);
+    assert(ctx.prep.exit_speed_used == 0.0f);
+    
+    /* Second block raises the first block's exit speed while it is prepared */
+    assert(planner_plan_block(&queue, &block, delta));
+    uint32_t total = run_recording(&ctx, profile_x_times, 2000);
+    
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 2000);
+    assert(ctx.position.v[HAL_AXIS_X] == 2000);
+    assert(planner_is_empty(&queue));
+    assert(stepper_is_idle(&ctx));
+    
+    /* Cruise straight through the junction at step 1000 */
+    assert(max_step_interval(profile_x_times, 150, 1850) <= 510);
+    
+    /* 20 mm rest to rest: 0.1 + 0.9 + 0.1 s */
+    assert(total > 1078000 && total < 1122000);
+    
+    printf("[passed]\n");
+}
+
+/* Run 10 mm then a short collinear block through the planner with the
+ * S-curve and return the last X step interval (ticks) */
+static uint32_t run_scurve_short_tail(float tail_mm, float jerk) {
+    reset_mocks();
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    stepper_config_t config;
+    stepper_get_config(&ctx, &config);
+    config.profile = STEPPER_PROFILE_SCURVE;
+    config.jerk_mm_per_s3 = jerk;
+    stepper_set_config(&ctx, &config);
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue, 0);
+    stepper_set_planner(&ctx, &queue);
+    
+    /* 200 mm/s^2 planner default, 100 steps/mm */
+    const uint32_t tail_steps = (uint32_t)(tail_mm * 100.0f);
+    float delta[KIN_MAX_CART_AXES] = {10.0f, 0.0f, 0.0f};
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 1200.0f;
+    block.steps[HAL_AXIS_X] = 1000;
+    block.direction_bits = 0x01;
+    assert(planner_plan_block(&queue, &block, delta));
+    delta[0] = tail_mm;
+    block.steps[HAL_AXIS_X] = tail_steps;
+    assert(planner_plan_block(&queue, &block, delta));
+    
+    /* The planner leaves the S-curve room to stop: the junction entry is
+     * below what the trapezoid would allow (sqrt(2 * 200 * tail_mm)) */
+    const planner_block_t *tail = &queue.blocks[(queue.head + 1u) % PLANNER_BUFFER_SIZE];
+    assert(tail->entry_speed / 60.0f < sqrtf(2.0f * 200.0f * tail_mm / 1.5f) + 0.01f);
+    
+    stepper_update(&ctx);
+    run_recording(&ctx, profile_x_times, 4000);
+    const uint32_t n = 1000 + tail_steps;
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == n);
+    assert(stepper_is_idle(&ctx));
+    return profile_x_times[n - 1] - profile_x_times[n - 2];
+}
+
+/* Test that a planner-fed S-curve job ramps down to rest at its end even
+ * when the last block is short */
+void test_stepper_scurve_planner_stops(void) {
+    printf("Testing stepper planner-fed S-curve ends at rest...\n");
+    
+    /* Cruise is 500 ticks per step; at rest the last interval is far longer
+     * (under 4 mm/s) */
+    assert(run_scurve_short_tail(1.0f, 0.0f) > 2500);
+    assert(run_scurve_short_tail(0.5f, 0.0f) > 2500);
+    assert(run_scurve_short_tail(1.0f, 2000.0f) > 2500);
+    assert(run_scurve_short_tail(0.5f, 2000.0f) > 2500);
+    
+    printf("[passed]\n");
+}
+
+/* Test that a hold ramps down along the block and resume ramps back up */
+void test_stepper_hold_decelerates(void) {
+    printf("Testing stepper hold deceleration...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    load_profile_block(&ctx, &block);
+    uint32_t now = 0;
+    uint32_t x_count = 0;
+    record_while(&ctx, STEPPER_RUNNING, profile_x_times, 1000, 300, &x_count, &now);
+    
+    /* Hold at cruise (2000 steps/s): queued segments, then a 1 mm ramp */
+    uint32_t hold_at = x_count;
+    stepper_hold(&ctx);
+    assert(stepper_get_state(&ctx) == STEPPER_HOLDING);
+    record_while(&ctx, STEPPER_HOLDING, profile_x_times, 1000, 0xFFFFFFFFu, &x_count, &now);
+    assert(stepper_get_state(&ctx) == STEPPER_HOLD);
+    assert(!mock_timer_running);
+    assert(ctx.current_speed == 0.0f);
+    uint32_t held = x_count;
+    assert(held >= hold_at + 90 && held < hold_at + 260);
+    assert(ctx.position.v[HAL_AXIS_X] == (int32_t)held);
+    
+    /* Step intervals stretch through the ramp down */
+    uint32_t cruise_max = max_step_interval(profile_x_times, 150, hold_at);
+    assert(cruise_max <= 510);
+    assert(profile_x_times[held - 1] - profile_x_times[held - 2] > 4 * cruise_max);
+    assert(profile_x_times[held - 10] - profile_x_times[held - 11] >
+           profile_x_times[held - 60] - profile_x_times[held - 61]);
+    
+    /* Parked: updates and timer ticks move nothing */
+    stepper_update(&ctx);
+    run_timer(10);
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == held);
+    
+    /* Resume ramps up from rest and finishes the block exactly */
+    stepper_resume(&ctx);
+    record_while(&ctx, STEPPER_RUNNING, profile_x_times, 1000, 0xFFFFFFFFu, &x_count, &now);
+    assert(stepper_is_idle(&ctx));
+    assert(x_count == 1000);
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == 1000);
+    assert(ctx.position.v[HAL_AXIS_X] == 1000);
+    assert(profile_x_times[held + 1] - profile_x_times[held] > 4 * cruise_max);
+    
+    printf("[passed]\n");
+}
+
+/* Test that a feed override mid-block ramps to the new cruise speed */
+void test_stepper_feed_override(void) {
+    printf("Testing stepper feed override...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    load_profile_block(&ctx, &block);
+    uint32_t now = 0;
+    uint32_t x_count = 0;
+    record_while(&ctx, STEPPER_RUNNING, profile_x_times, 1000, 300, &x_count, &now);
+    
+    /* 50% at cruise: 2000 -> 1000 steps/s, no replan of the planner */
+    stepper_set_overrides(&ctx, 50u, 100u, 100u);
+    assert(ctx.feed_override == 50u);
+    assert(stepper_get_state(&ctx) == STEPPER_RUNNING);
+    record_while(&ctx, STEPPER_RUNNING, profile_x_times, 1000, 0xFFFFFFFFu, &x_count, &now);
+    assert(stepper_is_idle(&ctx));
+    assert(x_count == 1000);
+    assert(ctx.position.v[HAL_AXIS_X] == 1000);
+    
+    /* Ramped down through the queued segments, then cruised at half speed */
+    assert(max_step_interval(profile_x_times, 150, 300) <= 510);
+    assert(min_step_interval(profile_x_times, 500, 900) >= 990);
+    assert(max_step_interval(profile_x_times, 500, 900) <= 1020);
+    
+    /* 200% stays within the block's rapid rate */
+    reset_mocks();
+    stepper_init(&ctx, NULL);
+    planner_block_init(&block);
+    block.nominal_speed = 1200.0f;
+    block.rapid_rate = 1800.0f;
+    block.acceleration = 200.0f * 3600.0f;
+    block.millimeters = 10.0f;
+    block.steps[HAL_AXIS_X] = 1000;
+    block.direction_bits = 0x01;
+    stepper_set_overrides(&ctx, 200u, 100u, 100u);
+    assert(stepper_load_block(&ctx, &block));
+    run_recording(&ctx, profile_x_times, 1000);
+    assert(ctx.position.v[HAL_AXIS_X] == 1000);
+    assert(min_step_interval(profile_x_times, 400, 600) >= 330);
+    assert(max_step_interval(profile_x_times, 400, 600) <= 340);
+    
+    printf("[passed]\n");
+}
+
+/* Test that laser mode scales the spindle PWM with speed per segment */
+void test_stepper_laser_mode(void) {
+    printf("Testing stepper laser mode...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    ctx.config.laser_mode = true;
+    assert(stepper_spindle_pwm(&ctx, 500.0f) == 0.5f);
+    assert(stepper_spindle_pwm(&ctx, 5000.0f) == 1.0f);
+    assert(stepper_spindle_pwm(&ctx, 0.0f) == 0.0f);
+    
+    /* Same block as the profile tests, M3 S500 of 1000 RPM */
+    planner_block_t block;
+    planner_block_init(&block);
+    block.nominal_speed = 1200.0f;
+    block.acceleration = 200.0f * 3600.0f;
+    block.millimeters = 10.0f;
+    block.steps[HAL_AXIS_X] = 1000;
+    block.direction_bits = 0x01;
+    block.spindle_speed = 500.0f;
+    block.spindle_dir = HAL_SPINDLE_CW;
+    assert(stepper_load_block(&ctx, &block));
+    run_recording(&ctx, profile_x_times, 1000);
+    assert(ctx.position.v[HAL_AXIS_X] == 1000);
+    
+    /* Power ramps up with speed, holds at S500 through the cruise, ramps
+     * down, and goes off once motion ends */
+    uint32_t calls = mock_spindle_calls;
+    assert(calls > 10 && calls < MOCK_SPINDLE_LOG_SIZE);
+    assert(mock_spindle_dir[0] == HAL_SPINDLE_CW);
+    assert(mock_spindle_pwm[0] > 0.0f && mock_spindle_pwm[0] < 0.1f);
+    uint32_t i = 1;
+    while (i < calls && mock_spindle_pwm[i] > mock_spindle_pwm[i - 1]) {
+        i++;
+    }
+    assert(fabsf(mock_spindle_pwm[i - 1] - 0.5f) < 1e-4f);
+    assert(mock_spindle_at_step[i - 1] <= 150);
+    assert(mock_spindle_at_step[i] >= 850);
+    assert(mock_spindle_pwm[calls - 2] > 0.0f && mock_spindle_pwm[calls - 2] < 0.1f);
+    assert(mock_spindle_dir[calls - 1] == HAL_SPINDLE_OFF);
+    assert(mock_spindle_pwm[calls - 1] == 0.0f);
+    assert(mock_spindle_at_step[calls - 1] == 1000);
+    
+    /* Rapids move with the laser off */
+    reset_mocks();
+    stepper_init(&ctx, NULL);
+    ctx.config.laser_mode = true;
+    block.rapid_flag = 1u;
+    assert(stepper_load_block(&ctx, &block));
+    run_recording(&ctx, profile_x_times, 1000);
+    assert(ctx.position.v[HAL_AXIS_X] == 1000);
+    assert(mock_spindle_calls == 0);
+    
+    /* Outside laser mode the stepper leaves the spindle alone */
+    reset_mocks();
+    stepper_init(&ctx, NULL);
+    block.rapid_flag = 0u;
+    assert(stepper_load_block(&ctx, &block));
+    run_recording(&ctx, profile_x_times, 1000);
+    assert(mock_spindle_calls == 0);
+    
+    printf("[passed]\n");
+}
+
+/* Test that stop ramps down, then drops the rest of the motion */
+void test_stepper_stop_decelerates(void) {
+    printf("Testing stepper stop deceleration...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    load_profile_block(&ctx, &block);
+    uint32_t now = 0;
+    uint32_t x_count = 0;
+    record_while(&ctx, STEPPER_RUNNING, profile_x_times, 1000, 300, &x_count, &now);
+    
+    uint32_t stop_at = x_count;
+    stepper_stop(&ctx);
+    assert(stepper_get_state(&ctx) == STEPPER_STOPPING);
+    record_while(&ctx, STEPPER_STOPPING, profile_x_times, 1000, 0xFFFFFFFFu, &x_count, &now);
+    assert(stepper_is_idle(&ctx));
+    assert(x_count >= stop_at + 90 && x_count < 1000);
+    assert(ctx.position.v[HAL_AXIS_X] == (int32_t)x_count);
+    assert(profile_x_times[x_count - 1] - profile_x_times[x_count - 2] > 2000);
+    
+    /* Nothing is left to resume */
+    stepper_resume(&ctx);
+    stepper_update(&ctx);
+    run_timer(10);
+    assert(stepper_is_idle(&ctx));
+    assert(mock_pulse_mask_bits[HAL_AXIS_X] == x_count);
+    
+    printf("[passed]\n");
+}
+
 int main(void) {
     printf("Running stepper tests...\n\n");
     
@@ -371,6 +1227,21 @@ int main(void) {
     test_stepper_stop();
     test_stepper_get_position();
     test_stepper_config();
+    test_stepper_isr_executes_block();
+    test_stepper_isr_fast_rate();
+    test_stepper_isr_hold_resume();
+    test_stepper_rt_request();
+    test_stepper_dda_multi_axis();
+    test_stepper_amass_smoothing();
+    test_stepper_amass_levels();
+    test_stepper_trapezoid_profile();
+    test_stepper_scurve_profile();
+    test_stepper_hold_decelerates();
+    test_stepper_stop_decelerates();
+    test_stepper_feed_override();
+    test_stepper_laser_mode();
+    test_stepper_planner_continuous();
+    test_stepper_scurve_planner_stops();
     
     printf("\nAll stepper tests passed!\n");
     return 0;
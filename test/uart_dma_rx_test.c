@@ -0,0 +1,199 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/uart_dma_rx.h"
+
+/* Stand-in for the DMA channel: writes bytes into the circular buffer and
+ * counts the remaining-transfer register down like the hardware does */
+typedef struct {
+    uart_dma_rx_t *rx;
+    uint16_t remaining;
+} fake_dma_t;
+
+static void fake_dma_start(fake_dma_t *dma, uart_dma_rx_t *rx) {
+    dma->rx = rx;
+    dma->remaining = UART_DMA_RX_SIZE;
+}
+
+static void fake_dma_receive(fake_dma_t *dma, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dma->rx->buf[UART_DMA_RX_SIZE - dma->remaining] = (uint8_t)data[i];
+        dma->remaining--;
+        if (dma->remaining == 0u) dma->remaining = UART_DMA_RX_SIZE;  /* circular reload */
+    }
+}
+
+static uint16_t fake_dma_write_pos(const fake_dma_t *dma) {
+    return (uint16_t)(UART_DMA_RX_SIZE - dma->remaining);
+}
+
+static void drain_lines(serial_uart_t *uart) {
+    char line[UART_LINE_MAX + 1];
+    while (serial_uart_read_line(uart, line, sizeof(line)) == UART_LINE_READY) {
+    }
+    assert(serial_uart_rx_count(uart) == 0u);
+}
+
+static void test_idle_chunk_reaches_line_reader(void) {
+    uart_dma_rx_t rx;
+    serial_uart_t uart;
+    fake_dma_t dma;
+    char line[UART_LINE_MAX + 1];
+
+    uart_dma_rx_init(&rx);
+    serial_uart_init(&uart);
+    fake_dma_start(&dma, &rx);
+
+    /* Nothing written yet */
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 0u);
+
+    /* Idle line after a burst: the whole burst arrives as one chunk */
+    fake_dma_receive(&dma, "G1 X10\nG1 Y5\n", 13);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 13u);
+    assert(serial_uart_rx_count(&uart) == 13u);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "G1 X10") == 0);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "G1 Y5") == 0);
+
+    /* Repeated event at the same position forwards nothing */
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 0u);
+
+    /* CR-only line endings still terminate lines */
+    fake_dma_receive(&dma, "?\r", 2);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 2u);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "?") == 0);
+}
+
+static void test_wrap_around_splits_into_two_chunks(void) {
+    uart_dma_rx_t rx;
+    serial_uart_t uart;
+    fake_dma_t dma;
+    char line[UART_LINE_MAX + 1];
+    char filler[UART_DMA_RX_SIZE];
+
+    uart_dma_rx_init(&rx);
+    serial_uart_init(&uart);
+    fake_dma_start(&dma, &rx);
+
+    /* Park the write pointer 4 bytes before the end of the buffer */
+    for (size_t i = 0; i < sizeof(filler); i++) {
+        filler[i] = (i % 32u == 31u) ? '\n' : ' ';
+    }
+    filler[UART_DMA_RX_SIZE - 5u] = '\n';
+    fake_dma_receive(&dma, filler, UART_DMA_RX_SIZE - 4u);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == UART_DMA_RX_SIZE - 4u);
+    drain_lines(&uart);
+
+    /* Transfer-complete event: write position equals the buffer size */
+    fake_dma_receive(&dma, "M3 S", 4);
+    assert(uart_dma_rx_service(&rx, UART_DMA_RX_SIZE, &uart) == 4u);
+    assert(rx.read_pos == 0u);
+
+    fake_dma_receive(&dma, "100\n", 4);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 4u);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "M3 S100") == 0);
+
+    /* A burst that crosses the end of the buffer between two events */
+    fake_dma_receive(&dma, filler, UART_DMA_RX_SIZE - 8u);
+    fake_dma_receive(&dma, "\n", 1);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == UART_DMA_RX_SIZE - 7u);
+    drain_lines(&uart);
+    fake_dma_receive(&dma, "M5\nG0 X1\n", 9);
+    assert(fake_dma_write_pos(&dma) == 6u);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 9u);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "M5") == 0);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "G0 X1") == 0);
+}
+
+static void test_full_ring_counts_dropped_bytes(void) {
+    uart_dma_rx_t rx;
+    serial_uart_t uart;
+    fake_dma_t dma;
+    char filler[UART_DMA_RX_SIZE / 2u];
+
+    uart_dma_rx_init(&rx);
+    serial_uart_init(&uart);
+    fake_dma_start(&dma, &rx);
+    memset(filler, 'X', sizeof(filler));
+
+    /* Main loop stalled: keep receiving without reading lines */
+    size_t sent = 0u;
+    size_t accepted = 0u;
+    while (sent < UART_RX_BUFFER_SIZE + sizeof(filler)) {
+        fake_dma_receive(&dma, filler, sizeof(filler));
+        sent += sizeof(filler);
+        accepted += uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart);
+    }
+    assert(accepted == UART_RX_BUFFER_SIZE);
+    assert(serial_uart_rx_count(&uart) == UART_RX_BUFFER_SIZE);
+    assert(rx.dropped == sent - UART_RX_BUFFER_SIZE);
+
+    assert(uart_dma_rx_service(NULL, 0u, &uart) == 0u);
+    assert(uart_dma_rx_service(&rx, 0u, NULL) == 0u);
+}
+
+/* Realtime filter stand-in: records the bytes it takes out of the stream */
+typedef struct {
+    char taken[16];
+    size_t count;
+} fake_realtime_t;
+
+static bool fake_realtime(void *ctx, uint8_t byte) {
+    fake_realtime_t *rt = (fake_realtime_t *)ctx;
+    if (byte != '?' && byte != '!' && byte != '~' && byte != 0x18u) return false;
+    if (rt->count < sizeof(rt->taken)) rt->taken[rt->count++] = (char)byte;
+    return true;
+}
+
+static void test_realtime_bytes_bypass_line_ring(void) {
+    uart_dma_rx_t rx;
+    serial_uart_t uart;
+    fake_dma_t dma;
+    fake_realtime_t rt = {{0}, 0u};
+    char line[UART_LINE_MAX + 1];
+
+    uart_dma_rx_init(&rx);
+    uart_dma_rx_set_realtime(&rx, fake_realtime, &rt);
+    serial_uart_init(&uart);
+    fake_dma_start(&dma, &rx);
+
+    /* Realtime bytes in the middle of a line are taken at receive time */
+    fake_dma_receive(&dma, "G1 ?X1!0\r~", 10);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 7u);
+    assert(rt.count == 3u);
+    assert(memcmp(rt.taken, "?!~", 3) == 0);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "G1 X10") == 0);
+    assert(serial_uart_rx_count(&uart) == 0u);
+
+    /* Across the wrap, with a chunk that is nothing but realtime bytes */
+    while (fake_dma_write_pos(&dma) != UART_DMA_RX_SIZE - 1u) {
+        fake_dma_receive(&dma, "\n", 1);
+    }
+    (void)uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart);
+    drain_lines(&uart);
+    fake_dma_receive(&dma, "?\x18M5\n", 5);
+    assert(uart_dma_rx_service(&rx, fake_dma_write_pos(&dma), &uart) == 3u);
+    assert(rt.count == 5u);
+    assert(rt.taken[4] == 0x18);
+    assert(serial_uart_read_line(&uart, line, sizeof(line)) == UART_LINE_READY);
+    assert(strcmp(line, "M5") == 0);
+}
+
+int main(void) {
+    printf("Running UART DMA receive tests...\n");
+
+    test_idle_chunk_reaches_line_reader();
+    test_wrap_around_splits_into_two_chunks();
+    test_full_ring_counts_dropped_bytes();
+    test_realtime_bytes_bypass_line_ring();
+
+    printf("All UART DMA receive tests passed!\n");
+    return 0;
+}